@@ -153,6 +153,12 @@ struct nl_parser_param
 
 	/** Arbitary argument to be passed to the parser */
 	void *            pp_arg;
+
+	/** Flags of the cache the objects are parsed for */
+	unsigned int      pp_flags;
+
+	/** Message type being parsed, if already looked up */
+	struct nl_msgtype *pp_msgtype;
 };
 
 /**
@@ -240,9 +246,16 @@ struct nl_cache_ops
 				  change_func_t change_cb, change_func_v2_t change_cb_v2,
 				  void *data);
 
-	void (*reserved_1)(void);
-	void (*reserved_2)(void);
-	void (*reserved_3)(void);
+	/**
+	 * Maintain secondary indexes of the cache. Called after an object
+	 * has been added to the cache and before it is removed. Indexes
+	 * may be kept in \c c_index of the cache and must be released by
+	 * \c co_index_free when the cache is freed.
+	 */
+	void  (*co_index_add)(struct nl_cache *, struct nl_object *);
+	void  (*co_index_del)(struct nl_cache *, struct nl_object *);
+	void  (*co_index_free)(struct nl_cache *);
+
 	void (*reserved_4)(void);
 	void (*reserved_5)(void);
 	void (*reserved_6)(void);
@@ -177,6 +177,89 @@ static inline int nl_cb_call(struct nl_cb *cb, enum nl_cb_type type, struct nl_m
 
 extern int nl_cache_parse(struct nl_cache_ops *, struct sockaddr_nl *,
 			  struct nlmsghdr *, struct nl_parser_param *);
+extern int _nl_cache_parse_msgtype(struct nl_cache_ops *, struct nl_msgtype *,
+				   struct sockaddr_nl *, struct nlmsghdr *,
+				   struct nl_parser_param *);
+extern int _nl_cache_resync_assoc(struct nl_sock *, struct nl_cache_assoc *);
+extern int _nl_cache_include_msgtype(struct nl_cache *, struct nl_object *,
+				     struct nl_msgtype *, uint64_t,
+				     change_func_t, change_func_v2_t, void *);
+
+extern uint32_t _nl_object_hash(struct nl_object *);
+
+/* Must be called whenever an attribute used by oo_keygen changes */
+static inline void nl_object_invalidate_hash(struct nl_object *obj)
+{
+	obj->ce_flags &= ~NL_OBJ_HASH_VALID;
+}
+
+extern int __nl_epoch_enter(void);
+extern void __nl_epoch_exit(void);
+extern void __nl_epoch_retire(void (*)(void *), void *);
+
+extern struct nl_addr *__nl_addr_inline_build(struct nl_addr_inline *,
+					      struct nl_object *, int,
+					      const void *, size_t);
+extern struct nl_addr *__nl_addr_inline_clone(struct nl_addr_inline *,
+					      struct nl_object *,
+					      const struct nl_addr *);
+extern struct nl_addr *__nl_addr_owner_get(struct nl_object *,
+					   struct nl_addr *);
+extern void __nl_addr_owner_put(struct nl_object *, struct nl_addr *);
+
+struct nl_arena;
+extern struct nl_arena *_nl_arena_alloc(void);
+extern void _nl_arena_free(struct nl_arena *);
+extern struct nl_arena *_nl_arena_enter(struct nl_arena *);
+extern void _nl_arena_leave(struct nl_arena *);
+extern void *_nl_arena_zalloc(size_t);
+extern void _nl_arena_release(void *);
+
+/*
+ * Sequence counter of a cache, readers of a cache with NL_CACHE_CONCURRENT
+ * set retry a lookup which failed while the cache was being modified.
+ * Write sections may be nested but must not invoke change callbacks.
+ */
+static inline void _nl_cache_write_begin(struct nl_cache *cache)
+{
+	if (cache->c_writers++ == 0) {
+		__atomic_store_n(&cache->c_seq, cache->c_seq + 1,
+				 __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+}
+
+static inline void _nl_cache_write_end(struct nl_cache *cache)
+{
+	if (--cache->c_writers == 0)
+		__atomic_store_n(&cache->c_seq, cache->c_seq + 1,
+				 __ATOMIC_RELEASE);
+}
+
+static inline unsigned int _nl_cache_read_begin(struct nl_cache *cache)
+{
+	return __atomic_load_n(&cache->c_seq, __ATOMIC_ACQUIRE);
+}
+
+static inline int _nl_cache_read_retry(struct nl_cache *cache,
+				       unsigned int seq)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return (seq & 1) ||
+	       __atomic_load_n(&cache->c_seq, __ATOMIC_RELAXED) != seq;
+}
+
+static inline int _nl_cache_is_concurrent(struct nl_cache *cache)
+{
+	return (cache->c_flags & NL_CACHE_CONCURRENT) && cache->hashtable;
+}
+
+extern struct nl_recvbuf *_nl_recvbuf_alloc(unsigned char *, size_t);
+extern void _nl_recvbuf_get(struct nl_recvbuf *);
+extern void _nl_recvbuf_put(struct nl_recvbuf *);
+extern struct nl_msg *_nlmsg_convert_in_place(struct nl_msg *, struct nlmsghdr *,
+					      struct nl_recvbuf *);
 
 
 static inline void rtnl_copy_ratespec(struct rtnl_ratespec *dst,
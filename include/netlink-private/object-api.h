@@ -191,6 +191,8 @@ extern "C" {
 	struct nl_list_head	ce_list;	\
 	int			ce_msgtype;	\
 	int			ce_flags;	\
+	uint32_t		ce_hash;	\
+	uint32_t		ce_gen;		\
 	uint64_t		ce_mask;
 
 struct nl_object
@@ -191,6 +191,8 @@ extern int			rtnl_link_af_data_compare(struct rtnl_link *a,
 extern int			rtnl_link_info_data_compare(struct rtnl_link *a,
 							    struct rtnl_link *b,
 							    int flags);
+extern int			rtnl_link_lazy_decode(struct rtnl_link *);
+extern int			rtnl_link_lazy_decode_af(struct rtnl_link *);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,14 @@ uint32_t _nl_socket_set_local_port_no_release(struct nl_sock *sk, int generate_o
 void _nl_socket_used_ports_release_all(const uint32_t *used_ports);
 void _nl_socket_used_ports_set(uint32_t *used_ports, uint32_t port);
 
+/* Room for the part of a datagram exceeding the receive buffer */
+#define NL_RECV_OVERFLOW	65536
+
+size_t _nl_socket_recv_bufsize(struct nl_sock *sk);
+
+int _nl_uring_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		   struct nl_recvbuf **rbuf);
+
 #ifdef __cplusplus
 }
 #endif
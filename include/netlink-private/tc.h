@@ -51,6 +51,9 @@ static inline void *tca_xstats(struct rtnl_tc *tca)
 
 extern struct nl_af_group tc_groups[];
 
+/* Hashes interface index and handle, shared by all tc object types */
+extern void rtnl_tc_keygen(struct nl_object *, uint32_t *, uint32_t);
+
 #ifdef __cplusplus
 }
 #endif
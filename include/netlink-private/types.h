@@ -14,6 +14,7 @@
 #define NETLINK_LOCAL_TYPES_H_
 
 #include <netlink/list.h>
+#include <netlink/batch.h>
 #include <netlink/route/link.h>
 #include <netlink/route/qdisc.h>
 #include <netlink/route/rtnl.h>
@@ -37,8 +38,8 @@
 #define NL_SOCK_PASSCRED	(1<<1)
 #define NL_OWN_PORT		(1<<2)
 #define NL_MSG_PEEK		(1<<3)
-#define NL_MSG_PEEK_EXPLICIT	(1<<4)
 #define NL_NO_AUTO_ACK		(1<<5)
+#define NL_MSG_ZERO_COPY	(1<<6)
 
 #define NL_MSG_CRED_PRESENT 1
 
@@ -78,6 +79,46 @@ struct nl_cb
 	enum nl_cb_type		cb_active;
 };
 
+struct nl_uring;
+
+/* Datagrams received by a single recvmmsg() call */
+struct nl_recv_batch
+{
+	unsigned int		bt_size;
+	unsigned int		bt_count;
+	unsigned int		bt_next;
+	struct nl_recvbuf **	bt_bufs;
+	struct mmsghdr *	bt_msgs;
+	struct iovec *		bt_iov;
+	unsigned char *		bt_overflow;
+	struct sockaddr_nl *	bt_addrs;
+	struct nl_recv_batch_stats bt_stats;
+};
+
+struct nl_batch_req
+{
+	struct nl_msg *		r_msg;
+	uint32_t		r_seq;
+	int			r_done;
+};
+
+struct nl_batch
+{
+	struct nl_sock *	b_sk;
+	struct nl_batch_req *	b_reqs;
+	unsigned int		b_size;
+	unsigned int		b_count;
+	/* first request not yet acknowledged */
+	unsigned int		b_head;
+	/* first request not yet sent */
+	unsigned int		b_sent;
+	unsigned int		b_acked;
+	unsigned int		b_window;
+	unsigned int		b_nerrors;
+	nl_batch_result_func_t	b_result;
+	void *			b_result_arg;
+};
+
 struct nl_sock
 {
 	struct sockaddr_nl	s_local;
@@ -89,6 +130,10 @@ struct nl_sock
 	int			s_flags;
 	struct nl_cb *		s_cb;
 	size_t			s_bufsize;
+	struct nl_recvbuf *	s_rbuf;
+	void *			s_overflow;
+	struct nl_recv_batch *	s_batch;
+	struct nl_uring *	s_uring;
 };
 
 struct nl_cache
@@ -101,6 +146,24 @@ struct nl_cache
 	unsigned int		c_flags;
 	struct nl_hash_table *	hashtable;
 	struct nl_cache_ops *   c_ops;
+	/* secondary indexes, see nl_cache_ops::co_index_add */
+	void *			c_index;
+	/* Generation of the last resync. Objects are kept ordered by the
+	 * generation they were last seen in, see nl_cache_resync(). */
+	uint32_t		c_gen;
+	struct nl_cache_resync_stats c_resync_stats;
+	/* Odd while the cache is being modified, see NL_CACHE_CONCURRENT */
+	unsigned int		c_seq;
+	unsigned int		c_writers;
+	/* objects of dumps are allocated from, see NL_CACHE_ARENA */
+	struct nl_arena *	c_arena;
+};
+
+struct nl_cache_snapshot
+{
+	struct nl_cache_ops *	cs_ops;
+	struct nl_object **	cs_objs;
+	int			cs_nitems;
 };
 
 struct nl_cache_assoc
@@ -111,6 +174,13 @@ struct nl_cache_assoc
 	void *			ca_change_data;
 };
 
+/* Cache association handling a message type, indexed by nlmsg_type */
+struct nl_cache_dispatch
+{
+	struct nl_msgtype *	cd_msgtype;
+	int			cd_assoc;
+};
+
 struct nl_cache_mngr
 {
 	int			cm_protocol;
@@ -119,6 +189,23 @@ struct nl_cache_mngr
 	struct nl_sock *	cm_sock;
 	struct nl_sock *	cm_sync_sock;
 	struct nl_cache_assoc *	cm_assocs;
+	struct nl_cache_dispatch *cm_dispatch;
+	int			cm_ndispatch;
+	/* Receive buffer size of cm_sock and its limit when recovering */
+	int			cm_rxbuf;
+	int			cm_rxbuf_max;
+	/* Caches must be resynced, an earlier recovery did not complete */
+	int			cm_recover_pending;
+	struct nl_cache_mngr_recovery_stats cm_recovery;
+	/* Updates held back, see nl_cache_mngr_set_coalesce() */
+	int			cm_coalesce_msec;
+	struct nl_cache_pending **cm_pending;
+	unsigned int		cm_pending_size;
+	unsigned int		cm_npending;
+	struct nl_list_head	cm_pending_list;
+	/* Threads applying events, see nl_cache_mngr_set_workers() */
+	struct nl_cache_worker *cm_workers;
+	int			cm_nworkers;
 };
 
 struct nl_parser_param;
@@ -127,6 +214,12 @@ struct nl_parser_param;
 #define ID_COMPARISON           2
 
 #define NL_OBJ_MARK		1
+/* ce_hash holds the result of oo_keygen */
+#define NL_OBJ_HASH_VALID	2
+/* object may be referenced by a cache snapshot, see nl_cache_snapshot() */
+#define NL_OBJ_SNAPSHOT		4
+/* object was allocated from an arena, see NL_CACHE_ARENA */
+#define NL_OBJ_ARENA		8
 
 struct nl_data
 {
@@ -141,9 +234,34 @@ struct nl_addr
 	unsigned int		a_len;
 	int			a_prefixlen;
 	int			a_refcnt;
+	int			a_flags;
 	char			a_addr[0];
 };
 
+/* address was allocated from an arena, see NL_CACHE_ARENA */
+#define NL_ADDR_ARENA		1
+/* address is embedded into an object, see struct nl_addr_inline */
+#define NL_ADDR_INLINE		2
+
+#define NL_ADDR_INLINE_SIZE	16
+
+/* Address embedded into the object it belongs to, see lib/addr.c */
+struct nl_addr_inline
+{
+	struct nl_addr		ai_addr;
+	char			ai_buf[NL_ADDR_INLINE_SIZE];
+	struct nl_object *	ai_owner;
+};
+
+/* Receive buffer shared by all messages parsed in place from it */
+struct nl_recvbuf
+{
+	unsigned char *		rb_data;
+	size_t			rb_size;
+	int			rb_refcnt;
+	void		      (*rb_release)(struct nl_recvbuf *);
+};
+
 struct nl_msg
 {
 	int			nm_protocol;
@@ -154,6 +272,11 @@ struct nl_msg
 	struct nlmsghdr *	nm_nlh;
 	size_t			nm_size;
 	int			nm_refcnt;
+	/* set if nm_nlh points into a shared receive buffer */
+	struct nl_recvbuf *	nm_rbuf;
+	/* size class + 1 of nm_nlh if it may be returned to the pool */
+	unsigned int		nm_pool_class;
+	struct nl_msg *		nm_pool_next;
 };
 
 struct rtnl_link_map
@@ -236,6 +359,10 @@ struct rtnl_link
 	int				l_ns_fd;
 	pid_t				l_ns_pid;
 	struct rtnl_link_vf *		l_vf_list;
+	struct rtnl_link_lazy *		l_lazy;
+	struct rtnl_link_lazy *		l_lazy_af;
+	/* links sharing an entry of the link cache index, per index */
+	struct rtnl_link *		l_idx_next[2];
 };
 
 struct rtnl_ncacheinfo
@@ -263,6 +390,9 @@ struct rtnl_neigh
 	uint32_t                n_flag_mask;
 	uint32_t		n_master;
 	uint16_t	n_vlan;
+	/* storage of n_lladdr and n_dst as parsed */
+	struct nl_addr_inline	n_lladdr_buf;
+	struct nl_addr_inline	n_dst_buf;
 };
 
 
@@ -302,6 +432,9 @@ struct rtnl_addr
 	char a_label[IFNAMSIZ];
 	uint32_t a_flag_mask;
 	struct rtnl_link *a_link;
+	/* storage of a_local and a_peer as parsed */
+	struct nl_addr_inline a_local_buf;
+	struct nl_addr_inline a_peer_buf;
 };
 
 struct rtnl_nh_encap
@@ -352,6 +485,9 @@ struct rtnl_route
 	struct nl_list_head	rt_nexthops;
 	struct rtnl_rtcacheinfo	rt_cacheinfo;
 	uint32_t		rt_flag_mask;
+	/* storage of rt_dst and rt_pref_src as parsed */
+	struct nl_addr_inline	rt_dst_buf;
+	struct nl_addr_inline	rt_pref_src_buf;
 };
 
 struct rtnl_rule
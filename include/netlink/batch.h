@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: LGPL-2.1-only */
+/*
+ * netlink/batch.h		Pipelined Request Batching
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#ifndef NETLINK_BATCH_H_
+#define NETLINK_BATCH_H_
+
+#include <netlink/netlink.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct nl_batch;
+
+/**
+ * Request completion callback
+ * @ingroup batch
+ * @arg msg		Request as passed to nl_batch_add()
+ * @arg err		0 if acknowledged or negative error code reported
+ * @arg arg		Argument passed to nl_batch_set_result_cb()
+ */
+typedef void (*nl_batch_result_func_t)(struct nl_msg *msg, int err, void *arg);
+
+extern struct nl_batch *	nl_batch_alloc(struct nl_sock *);
+extern void			nl_batch_free(struct nl_batch *);
+
+extern int			nl_batch_set_window(struct nl_batch *,
+						    unsigned int);
+extern unsigned int		nl_batch_get_window(const struct nl_batch *);
+extern void			nl_batch_set_result_cb(struct nl_batch *,
+						       nl_batch_result_func_t,
+						       void *);
+
+extern int			nl_batch_add(struct nl_batch *, struct nl_msg *);
+extern unsigned int		nl_batch_get_count(const struct nl_batch *);
+extern unsigned int		nl_batch_get_pending(const struct nl_batch *);
+extern int			nl_batch_commit(struct nl_batch *);
+extern void			nl_batch_clear(struct nl_batch *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -34,21 +34,100 @@ enum {
 #define NL_ACT_MAX (__NL_ACT_MAX - 1)
 
 struct nl_cache;
+struct nl_cache_snapshot;
+struct nl_hash_table_stats;
 typedef void (*change_func_t)(struct nl_cache *, struct nl_object *, int, void *);
 typedef void (*change_func_v2_t)(struct nl_cache *, struct nl_object *old_obj,
 	      struct nl_object *new_obj, uint64_t, int, void *);
 
+/**
+ * @ingroup cache
+ * Object callback of nl_cache_stream()
+ *
+ * Returns NL_OK to continue or NL_STOP to stop the dump.
+ */
+typedef int (*nl_cache_stream_func_t)(struct nl_object *, void *);
+
 /**
  * @ingroup cache
  * Explicitely iterate over all address families when updating the cache
  */
 #define NL_CACHE_AF_ITER	0x0001
 
+/**
+ * @ingroup cache
+ * Dump all address families concurrently, each on its own socket and
+ * thread, when updating a cache with NL_CACHE_AF_ITER set
+ */
+#define NL_CACHE_AF_PARALLEL	0x0002
+
+/**
+ * @ingroup cache
+ * Allow lookups from other threads while a single thread updates the cache
+ */
+#define NL_CACHE_CONCURRENT	0x0004
+
+/**
+ * @ingroup cache
+ * Decode rarely used sections of objects only when they are accessed
+ */
+#define NL_CACHE_LAZY_PARSE	0x0008
+
+/**
+ * @ingroup cache
+ * Allocate objects received in dumps from large blocks owned by the cache.
+ * Only used while the cache is empty or being refilled: most objects of a
+ * resync are dropped again and those kept would keep a block each alive.
+ */
+#define NL_CACHE_ARENA		0x0010
+
+/**
+ * @ingroup cache
+ * Statistics of the last nl_cache_resync() call
+ */
+struct nl_cache_resync_stats
+{
+	/** Time spent requesting and including dumps in microseconds */
+	uint64_t	rs_dump_usec;
+	/** Time spent removing obsolete objects in microseconds */
+	uint64_t	rs_sweep_usec;
+	/** Number of objects received */
+	unsigned int	rs_received;
+	/** Number of obsolete objects removed */
+	unsigned int	rs_removed;
+};
+
+/**
+ * @ingroup cache_mngr
+ * Statistics of the recovery of a cache manager from lost notifications
+ */
+struct nl_cache_mngr_recovery_stats
+{
+	/** Number of times notifications were lost */
+	unsigned int	rv_overruns;
+	/** Number of caches resynchronized */
+	unsigned int	rv_resyncs;
+	/** Number of resynchronizations which failed */
+	unsigned int	rv_failures;
+	/** Receive buffer size of the notification socket, 0 if unchanged */
+	int		rv_rxbuf;
+	/** Duration of the last recovery in microseconds */
+	uint64_t	rv_last_usec;
+	/** Duration of the longest recovery in microseconds */
+	uint64_t	rv_max_usec;
+	/** Time spent recovering in total in microseconds */
+	uint64_t	rv_total_usec;
+};
+
 /* Access Functions */
 extern int			nl_cache_nitems(struct nl_cache *);
 extern int			nl_cache_nitems_filter(struct nl_cache *,
 						       struct nl_object *);
 extern struct nl_cache_ops *	nl_cache_get_ops(struct nl_cache *);
+extern int			nl_cache_get_hash_stats(struct nl_cache *,
+							struct nl_hash_table_stats *);
+extern void			nl_cache_get_resync_stats(struct nl_cache *,
+							  struct nl_cache_resync_stats *);
 extern struct nl_object *	nl_cache_get_first(struct nl_cache *);
 extern struct nl_object *	nl_cache_get_last(struct nl_cache *);
 extern struct nl_object *	nl_cache_get_next(struct nl_object *);
@@ -78,6 +157,10 @@ extern int			nl_cache_move(struct nl_cache *,
 extern void			nl_cache_remove(struct nl_object *);
 extern int			nl_cache_refill(struct nl_sock *,
 						struct nl_cache *);
+extern int			nl_cache_stream(struct nl_sock *,
+						struct nl_cache *,
+						nl_cache_stream_func_t,
+						void *);
 extern int			nl_cache_pickup(struct nl_sock *,
 						struct nl_cache *);
 extern int			nl_cache_pickup_checkdup(struct nl_sock *,
@@ -113,6 +196,19 @@ extern void			nl_cache_dump_filter(struct nl_cache *,
 						     struct nl_dump_params *,
 						     struct nl_object *);
 
+/* Snapshots */
+extern struct nl_cache_snapshot *nl_cache_snapshot(struct nl_cache *);
+extern void			nl_cache_snapshot_free(struct nl_cache_snapshot *);
+extern int			nl_cache_snapshot_nitems(const struct nl_cache_snapshot *);
+extern struct nl_object *	nl_cache_snapshot_get(const struct nl_cache_snapshot *,
+						      int);
+extern int			nl_cache_snapshot_diff(struct nl_cache_snapshot *,
+						       struct nl_cache_snapshot *,
+						       void (*cb)(struct nl_object *,
+								  struct nl_object *,
+								  void *),
+						       void *arg);
+
 /* Iterators */
 extern void			nl_cache_foreach(struct nl_cache *,
 						 void (*cb)(struct nl_object *,
@@ -169,6 +265,16 @@ extern int			nl_cache_mngr_poll(struct nl_cache_mngr *,
 extern int			nl_cache_mngr_data_ready(struct nl_cache_mngr *);
 extern void			nl_cache_mngr_info(struct nl_cache_mngr *,
 						   struct nl_dump_params *);
+extern int			nl_cache_mngr_set_rxbuf_max(struct nl_cache_mngr *,
+							    int);
+extern void			nl_cache_mngr_get_recovery_stats(struct nl_cache_mngr *,
+								 struct nl_cache_mngr_recovery_stats *);
+extern int			nl_cache_mngr_set_coalesce(struct nl_cache_mngr *,
+							   int);
+extern int			nl_cache_mngr_flush(struct nl_cache_mngr *);
+extern int			nl_cache_mngr_get_timeout(struct nl_cache_mngr *);
+extern int			nl_cache_mngr_set_workers(struct nl_cache_mngr *,
+								  int);
 extern void			nl_cache_mngr_free(struct nl_cache_mngr *);
 
 extern void			nl_cache_ops_get(struct nl_cache_ops *);
@@ -31,11 +31,34 @@ typedef struct nl_hash_table {
     nl_hash_node_t **		nodes;
 } nl_hash_table_t;
 
+/* Use open addressing instead of chaining */
+#define NL_HASH_TABLE_OPEN	0x1
+
 /* Default hash table size */
 #define NL_MAX_HASH_ENTRIES 1024
 
+/* Number of chain length buckets reported in struct nl_hash_table_stats */
+#define NL_HASH_STATS_CHAINS 8
+
+struct nl_hash_table_stats {
+    /** Number of buckets */
+    unsigned int		hs_size;
+    /** Number of objects */
+    unsigned int		hs_entries;
+    /** Number of non-empty buckets */
+    unsigned int		hs_used;
+    /** Length of longest chain */
+    unsigned int		hs_max_chain;
+    /** Number of buckets with a chain of length i, the last element
+     *  counts all longer chains */
+    unsigned int		hs_chains[NL_HASH_STATS_CHAINS];
+    /** Non-zero while objects are being moved to a resized table */
+    int				hs_rehashing;
+};
+
 /* Access Functions */
 extern nl_hash_table_t *	nl_hash_table_alloc(int size);
+extern nl_hash_table_t *	nl_hash_table_alloc_flags(int size, int flags);
 extern void 			nl_hash_table_free(nl_hash_table_t *ht);
 
 extern int			nl_hash_table_add(nl_hash_table_t *ht,
@@ -45,6 +68,8 @@ extern int			nl_hash_table_del(nl_hash_table_t *ht,
 
 extern struct nl_object *	nl_hash_table_lookup(nl_hash_table_t *ht,
 						     struct nl_object *obj);
+extern void			nl_hash_table_get_stats(nl_hash_table_t *ht,
+							struct nl_hash_table_stats *stats);
 extern uint32_t 		nl_hash(void *k, size_t length,
 					uint32_t initval);
 
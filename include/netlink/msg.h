@@ -49,6 +49,21 @@ struct nl_msg;
 struct nl_tree;
 struct ucred;
 
+/**
+ * Message pool statistics
+ * @ingroup msg
+ * @see nlmsg_get_pool_stats()
+ */
+struct nl_msg_pool_stats
+{
+	/** Allocations served from the pool */
+	uint64_t	mps_hits;
+	/** Allocations that had to fall back to malloc() */
+	uint64_t	mps_misses;
+	/** Number of messages currently cached */
+	unsigned int	mps_cached;
+};
+
 extern int			nlmsg_size(int);
 extern int			nlmsg_total_size(int);
 extern int			nlmsg_padlen(int);
@@ -75,8 +90,11 @@ extern struct nl_msg *	  nlmsg_alloc(void);
 extern struct nl_msg *	  nlmsg_alloc_size(size_t);
 extern struct nl_msg *	  nlmsg_alloc_simple(int, int);
 extern void		  nlmsg_set_default_size(size_t);
+extern void		  nlmsg_set_pool_limit(unsigned int);
+extern void		  nlmsg_get_pool_stats(struct nl_msg_pool_stats *);
 extern struct nl_msg *	  nlmsg_inherit(struct nlmsghdr *);
 extern struct nl_msg *	  nlmsg_convert(struct nlmsghdr *);
+extern struct nl_msg *	  nlmsg_clone(struct nl_msg *);
 extern void *		  nlmsg_reserve(struct nl_msg *, size_t, int);
 extern int		  nlmsg_append(struct nl_msg *, void *, size_t, int);
 extern int		  nlmsg_expand(struct nl_msg *, size_t);
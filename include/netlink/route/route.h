@@ -52,6 +52,8 @@ extern struct rtnl_route *	rtnl_route_alloc(void);
 extern void	rtnl_route_put(struct rtnl_route *);
 extern int	rtnl_route_alloc_cache(struct nl_sock *, int, int,
 				       struct nl_cache **);
+extern struct rtnl_route *rtnl_route_lookup(struct nl_cache *, uint32_t,
+					    struct nl_addr *);
 
 extern void	rtnl_route_get(struct rtnl_route *);
 
@@ -19,6 +19,23 @@
 extern "C" {
 #endif
 
+/**
+ * Statistics of batched receiving
+ * @ingroup socket
+ * @see nl_socket_set_recv_batch()
+ */
+struct nl_recv_batch_stats
+{
+	/** Number of recvmmsg() calls which returned data */
+	uint64_t		rbs_calls;
+	/** Total number of datagrams received */
+	uint64_t		rbs_datagrams;
+	/** Number of calls which filled all batch slots */
+	uint64_t		rbs_full;
+	/** Number of datagrams received by the most recent call */
+	unsigned int		rbs_last;
+};
+
 extern struct nl_sock *	nl_socket_alloc(void);
 extern struct nl_sock *	nl_socket_alloc_cb(struct nl_cb *);
 extern void		nl_socket_free(struct nl_sock *);
@@ -64,6 +81,17 @@ extern int              nl_socket_set_fd(struct nl_sock *sk, int protocol, int f
 extern int		nl_socket_set_nonblocking(const struct nl_sock *);
 extern void		nl_socket_enable_msg_peek(struct nl_sock *);
 extern void		nl_socket_disable_msg_peek(struct nl_sock *);
+extern void		nl_socket_enable_zero_copy(struct nl_sock *);
+extern void		nl_socket_disable_zero_copy(struct nl_sock *);
+extern int		nl_socket_set_recv_batch(struct nl_sock *, unsigned int);
+extern unsigned int	nl_socket_get_recv_batch(const struct nl_sock *);
+extern unsigned int	nl_socket_get_recv_batch_pending(const struct nl_sock *);
+extern void		nl_socket_get_recv_batch_stats(const struct nl_sock *,
+						       struct nl_recv_batch_stats *);
+
+extern int		nl_socket_enable_io_uring(struct nl_sock *, unsigned int);
+extern void		nl_socket_disable_io_uring(struct nl_sock *);
+extern int		nl_socket_get_io_uring_fd(const struct nl_sock *);
 
 #ifdef __cplusplus
 }
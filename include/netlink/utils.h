@@ -257,6 +257,10 @@ enum {
 	 * Now, as indicated by this capability, nl_recvmsgs() would use MSG_PEEK by default. The
 	 * user still can explicitly disable MSG_PEEK by calling nl_socket_disable_msg_peek() or
 	 * by setting the nl_socket_set_msg_buf_size() to a non-zero value.
+	 *
+	 * nl_recvmsgs() no longer peeks by default but still does not truncate messages exceeding
+	 * its buffer unless a buffer size has been set. Such a message continues in an overflow
+	 * buffer read by the same recvmsg() call, the buffer then grows to fit it.
 	 */
 	NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT = 24,
 #define NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT
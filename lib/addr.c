@@ -160,10 +160,35 @@ static void addr_destroy(struct nl_addr *addr)
 	if (!addr)
 		return;
 
-	if (addr->a_refcnt != 1)
+	if (addr->a_refcnt > 1)
 		BUG();
 
-	free(addr);
+	if (addr->a_flags & NL_ADDR_ARENA)
+		_nl_arena_release(addr);
+	else
+		free(addr);
+}
+
+static void addr_init(struct nl_addr *addr, int family, const void *buf,
+		      size_t size)
+{
+	addr->a_family = family;
+	addr->a_len = size;
+	switch(family) {
+	case AF_MPLS:
+		addr->a_prefixlen = 20;  /* MPLS address is a 20-bit label */
+		break;
+	default:
+		addr->a_prefixlen = size*8;
+	}
+
+	if (size)
+		memcpy(addr->a_addr, buf, size);
+}
+
+static struct nl_object *addr_owner(struct nl_addr *addr)
+{
+	return ((struct nl_addr_inline *) addr)->ai_owner;
 }
 
 /**
@@ -188,8 +213,9 @@ struct nl_addr *nl_addr_alloc(size_t maxsize)
 {
 	struct nl_addr *addr;
 	
-	addr = calloc(1, sizeof(*addr) + maxsize);
-	if (!addr)
+	if ((addr = _nl_arena_zalloc(sizeof(*addr) + maxsize)))
+		addr->a_flags |= NL_ADDR_ARENA;
+	else if (!(addr = calloc(1, sizeof(*addr) + maxsize)))
 		return NULL;
 
 	addr->a_refcnt = 1;
@@ -223,18 +249,7 @@ struct nl_addr *nl_addr_build(int family, const void *buf, size_t size)
 	if (!addr)
 		return NULL;
 
-	addr->a_family = family;
-	addr->a_len = size;
-	switch(family) {
-	case AF_MPLS:
-		addr->a_prefixlen = 20;  /* MPLS address is a 20-bit label */
-		break;
-	default:
-		addr->a_prefixlen = size*8;
-	}
-
-	if (size)
-		memcpy(addr->a_addr, buf, size);
+	addr_init(addr, family, buf, size);
 
 	return addr;
 }
@@ -523,7 +538,11 @@ struct nl_addr *nl_addr_clone(const struct nl_addr *addr)
  */
 struct nl_addr *nl_addr_get(struct nl_addr *addr)
 {
-	addr->a_refcnt++;
+	/* Embedded addresses live as long as the object holding them */
+	if (addr->a_flags & NL_ADDR_INLINE)
+		nl_object_get(addr_owner(addr));
+	else
+		__atomic_add_fetch(&addr->a_refcnt, 1, __ATOMIC_RELAXED);
 
 	return addr;
 }
@@ -542,10 +561,10 @@ void nl_addr_put(struct nl_addr *addr)
 	if (!addr)
 		return;
 
-	if (addr->a_refcnt == 1)
+	if (addr->a_flags & NL_ADDR_INLINE)
+		nl_object_put(addr_owner(addr));
+	else if (__atomic_sub_fetch(&addr->a_refcnt, 1, __ATOMIC_ACQ_REL) == 0)
 		addr_destroy(addr);
-	else
-		addr->a_refcnt--;
 }
 
 /**
@@ -556,11 +575,77 @@ void nl_addr_put(struct nl_addr *addr)
  */
 int nl_addr_shared(const struct nl_addr *addr)
 {
-	return addr->a_refcnt > 1;
+	if (addr->a_flags & NL_ADDR_INLINE)
+		return nl_object_shared(addr_owner((struct nl_addr *) addr));
+
+	return __atomic_load_n(&addr->a_refcnt, __ATOMIC_RELAXED) > 1;
 }
 
 /** @} */
 
+/** @cond SKIP */
+/*
+ * Addresses embedded into objects
+ *
+ * Objects keep frequently used addresses of up to NL_ADDR_INLINE_SIZE
+ * bytes, e.g. the destination of a route, in a struct nl_addr_inline
+ * instead of a separate allocation. References on such an address are
+ * taken on the object holding it. The object itself holds no reference,
+ * it assigns and releases addresses with __nl_addr_owner_get() and
+ * __nl_addr_owner_put() instead of nl_addr_get() and nl_addr_put().
+ */
+struct nl_addr *__nl_addr_inline_build(struct nl_addr_inline *ai,
+				       struct nl_object *owner, int family,
+				       const void *buf, size_t size)
+{
+	if (size > sizeof(ai->ai_buf))
+		return nl_addr_build(family, buf, size);
+
+	memset(ai, 0, sizeof(*ai));
+	ai->ai_addr.a_refcnt = 1;
+	ai->ai_addr.a_maxsize = sizeof(ai->ai_buf);
+	ai->ai_addr.a_flags = NL_ADDR_INLINE;
+	ai->ai_owner = owner;
+	addr_init(&ai->ai_addr, family, buf, size);
+
+	return &ai->ai_addr;
+}
+
+struct nl_addr *__nl_addr_inline_clone(struct nl_addr_inline *ai,
+				       struct nl_object *owner,
+				       const struct nl_addr *addr)
+{
+	struct nl_addr *new;
+
+	new = __nl_addr_inline_build(ai, owner, addr->a_family, addr->a_addr,
+				     addr->a_len);
+	if (new)
+		new->a_prefixlen = addr->a_prefixlen;
+
+	return new;
+}
+
+static int addr_owned_by(struct nl_addr *addr, struct nl_object *owner)
+{
+	return (addr->a_flags & NL_ADDR_INLINE) && addr_owner(addr) == owner;
+}
+
+struct nl_addr *__nl_addr_owner_get(struct nl_object *owner,
+				    struct nl_addr *addr)
+{
+	if (!addr_owned_by(addr, owner))
+		nl_addr_get(addr);
+
+	return addr;
+}
+
+void __nl_addr_owner_put(struct nl_object *owner, struct nl_addr *addr)
+{
+	if (addr && !addr_owned_by(addr, owner))
+		nl_addr_put(addr);
+}
+/** @endcond */
+
 /**
  * @name Miscellaneous
  * @{
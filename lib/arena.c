@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: LGPL-2.1-only */
+/*
+ * lib/arena.c		Object Arenas
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+/** @cond SKIP */
+
+/*
+ * Objects parsed from a dump into a cache with NL_CACHE_ARENA set, and
+ * the addresses they reference, are carved out of large blocks instead
+ * of being allocated one by one. The thread filling the cache enters the
+ * arena of the cache with _nl_arena_enter(), nl_object_alloc() and
+ * nl_addr_alloc() then try _nl_arena_zalloc() first.
+ *
+ * A block counts the allocations still in use plus one reference held
+ * by the arena for as long as it allocates from the block. A block is
+ * released together with its last allocation, objects outliving the
+ * cache through nl_object_get() therefore remain valid.
+ */
+
+#include <netlink-private/netlink.h>
+#include <netlink/netlink.h>
+
+#define ARENA_BLOCK_SIZE	(64 * 1024)
+#define ARENA_MAX_ALLOC		(ARENA_BLOCK_SIZE / 16)
+
+union nl_arena_hdr
+{
+	struct nl_arena_block *	h_block;
+	long double		h_align;
+};
+
+#define ARENA_ALIGN(len) \
+	(((len) + sizeof(union nl_arena_hdr) - 1) & \
+	 ~(sizeof(union nl_arena_hdr) - 1))
+
+struct nl_arena_block
+{
+	int			b_refcnt;
+	size_t			b_used;
+	union nl_arena_hdr	b_data[];
+};
+
+struct nl_arena
+{
+	/* Block currently allocated from */
+	struct nl_arena_block *	a_block;
+};
+
+#ifndef DISABLE_PTHREADS
+static __thread struct nl_arena *arena_current;
+#else
+static struct nl_arena *arena_current;
+#endif
+
+static void arena_block_put(struct nl_arena_block *b)
+{
+	if (b && __atomic_sub_fetch(&b->b_refcnt, 1, __ATOMIC_ACQ_REL) == 0)
+		free(b);
+}
+
+struct nl_arena *_nl_arena_alloc(void)
+{
+	return calloc(1, sizeof(struct nl_arena));
+}
+
+void _nl_arena_free(struct nl_arena *arena)
+{
+	if (!arena)
+		return;
+
+	arena_block_put(arena->a_block);
+	free(arena);
+}
+
+/* Returns the arena entered before, to be passed to _nl_arena_leave() */
+struct nl_arena *_nl_arena_enter(struct nl_arena *arena)
+{
+	struct nl_arena *prev = arena_current;
+
+	arena_current = arena;
+
+	return prev;
+}
+
+void _nl_arena_leave(struct nl_arena *prev)
+{
+	arena_current = prev;
+}
+
+/*
+ * Returns zeroed memory from the arena entered by the calling thread or
+ * NULL if none was entered or the allocation is too large.
+ */
+void *_nl_arena_zalloc(size_t size)
+{
+	struct nl_arena *arena = arena_current;
+	struct nl_arena_block *b;
+	union nl_arena_hdr *h;
+	size_t need;
+
+	if (!arena)
+		return NULL;
+
+	need = sizeof(*h) + ARENA_ALIGN(size);
+	if (need > ARENA_MAX_ALLOC)
+		return NULL;
+
+	b = arena->a_block;
+	if (!b || b->b_used + need > ARENA_BLOCK_SIZE) {
+		if (!(b = malloc(sizeof(*b) + ARENA_BLOCK_SIZE)))
+			return NULL;
+
+		b->b_refcnt = 1;
+		b->b_used = 0;
+
+		arena_block_put(arena->a_block);
+		arena->a_block = b;
+	}
+
+	h = (union nl_arena_hdr *) ((char *) b->b_data + b->b_used);
+	h->h_block = b;
+	b->b_used += need;
+	__atomic_add_fetch(&b->b_refcnt, 1, __ATOMIC_RELAXED);
+
+	memset(h + 1, 0, size);
+
+	return h + 1;
+}
+
+/* Releases memory returned by _nl_arena_zalloc() */
+void _nl_arena_release(void *ptr)
+{
+	union nl_arena_hdr *h = (union nl_arena_hdr *) ptr - 1;
+
+	arena_block_put(h->h_block);
+}
+
+/** @endcond */
@@ -449,8 +449,8 @@ int nla_strcmp(const struct nlattr *nla, const char *str)
  * fills in the attribute header (type, length). Returns NULL if there
  * is unsuficient space for the attribute.
  *
- * Any padding between payload and the start of the next attribute is
- * zeroed out.
+ * The payload and any padding between payload and the start of the
+ * next attribute is zeroed out.
  *
  * @return Pointer to start of attribute or NULL on failure.
  */
@@ -472,7 +472,7 @@ struct nlattr *nla_reserve(struct nl_msg *msg, int attrtype, int attrlen)
 	nla->nla_len = nla_attr_size(attrlen);
 
 	if (attrlen)
-		memset((unsigned char *) nla + nla->nla_len, 0, nla_padlen(attrlen));
+		memset(nla_data(nla), 0, nla_total_size(attrlen) - NLA_HDRLEN);
 	msg->nm_nlh->nlmsg_len = tlen;
 
 	NL_DBG(2, "msg %p: attr <%p> %d: Reserved %d (%d) bytes at offset +%td "
@@ -0,0 +1,437 @@
+/* SPDX-License-Identifier: LGPL-2.1-only */
+/*
+ * lib/batch.c		Pipelined Request Batching
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+/**
+ * @ingroup core
+ * @defgroup batch Request Batching
+ *
+ * Sending many requests without waiting for each acknowledgement
+ *
+ * nl_send_sync() costs one round trip per request. A batch queues any
+ * number of requests and transmits them with as few sendmsg() calls as
+ * possible, each carrying many requests. The acknowledgements and error
+ * messages sent in response are matched back to the requests by sequence
+ * number and reported through a callback.
+ *
+ * The number of requests transmitted but not yet acknowledged is limited
+ * by a window to avoid overrunning the receive buffer of the socket with
+ * acknowledgements.
+ *
+ * @code
+ * struct nl_batch *batch = nl_batch_alloc(sk);
+ *
+ * nl_batch_set_result_cb(batch, my_result_cb, NULL);
+ *
+ * for (i = 0; i < n; i++) {
+ *         rtnl_route_build_add_request(routes[i], NLM_F_CREATE, &msg);
+ *         nl_batch_add(batch, msg);
+ *         nlmsg_free(msg);
+ * }
+ *
+ * nfailed = nl_batch_commit(batch);
+ * nl_batch_free(batch);
+ * @endcode
+ *
+ * @{
+ *
+ * Header
+ * ------
+ * ~~~~{.c}
+ * #include <netlink/batch.h>
+ * ~~~~
+ */
+
+#include <netlink-private/netlink.h>
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <netlink/handlers.h>
+#include <netlink/batch.h>
+
+/** @cond SKIP */
+#define NL_BATCH_WINDOW		64
+#define NL_BATCH_IOV_MAX	128
+/* Keeps the kernel from having to allocate high order pages */
+#define NL_BATCH_SEND_MAX	32768
+
+static const unsigned char batch_pad[NLMSG_ALIGNTO];
+
+static int batch_send_one(struct nl_batch *b)
+{
+	int err;
+
+	err = nl_send(b->b_sk, b->b_reqs[b->b_sent].r_msg);
+	if (err < 0)
+		return err;
+
+	b->b_sent++;
+
+	return 0;
+}
+
+static int batch_send(struct nl_batch *b)
+{
+	struct iovec iov[NL_BATCH_IOV_MAX];
+	unsigned int n = 0, niov = 0, limit;
+	size_t len = 0;
+	int err;
+
+	if (b->b_sk->s_cb->cb_send_ow)
+		return batch_send_one(b);
+
+	limit = b->b_window - (b->b_sent - b->b_acked);
+
+	while (b->b_sent + n < b->b_count && n < limit &&
+	       niov + 2 <= NL_BATCH_IOV_MAX) {
+		struct nlmsghdr *nlh = nlmsg_hdr(b->b_reqs[b->b_sent + n].r_msg);
+		size_t msglen = NLMSG_ALIGN(nlh->nlmsg_len);
+
+		if (n && len + msglen > NL_BATCH_SEND_MAX)
+			break;
+
+		iov[niov].iov_base = nlh;
+		iov[niov].iov_len = nlh->nlmsg_len;
+		niov++;
+
+		if (msglen != nlh->nlmsg_len) {
+			iov[niov].iov_base = (void *) batch_pad;
+			iov[niov].iov_len = msglen - nlh->nlmsg_len;
+			niov++;
+		}
+
+		len += msglen;
+		n++;
+	}
+
+	err = nl_send_iovec(b->b_sk, b->b_reqs[b->b_sent].r_msg, iov, niov);
+	if (err < 0)
+		return err;
+
+	NL_DBG(3, "batch %p: Sent %u requests in %zu bytes\n", b, n, len);
+
+	b->b_sent += n;
+
+	return 0;
+}
+
+static void batch_complete(struct nl_batch *b, uint32_t seq, int err)
+{
+	struct nl_batch_req *req = NULL;
+	unsigned int i;
+
+	for (i = b->b_head; i < b->b_sent; i++) {
+		if (!b->b_reqs[i].r_done && b->b_reqs[i].r_seq == seq) {
+			req = &b->b_reqs[i];
+			break;
+		}
+	}
+
+	/* not a response to one of our requests */
+	if (!req)
+		return;
+
+	req->r_done = 1;
+	b->b_acked++;
+	if (err)
+		b->b_nerrors++;
+
+	if (b->b_result)
+		b->b_result(req->r_msg, err, b->b_result_arg);
+
+	while (b->b_head < b->b_sent && b->b_reqs[b->b_head].r_done) {
+		nlmsg_free(b->b_reqs[b->b_head].r_msg);
+		b->b_reqs[b->b_head].r_msg = NULL;
+		b->b_head++;
+	}
+}
+
+static int batch_seq_check(struct nl_msg *msg, void *arg)
+{
+	/* requests are matched in batch_complete() */
+	return NL_OK;
+}
+
+static int batch_ack_handler(struct nl_msg *msg, void *arg)
+{
+	batch_complete(arg, nlmsg_hdr(msg)->nlmsg_seq, 0);
+
+	return NL_OK;
+}
+
+static int batch_error_handler(struct sockaddr_nl *nla, struct nlmsgerr *e,
+			       void *arg)
+{
+	batch_complete(arg, e->msg.nlmsg_seq, -nl_syserr2nlerr(e->error));
+
+	return NL_SKIP;
+}
+/** @endcond */
+
+/**
+ * @name Allocation/Freeing
+ * @{
+ */
+
+/**
+ * Allocate new request batch
+ * @arg sk		Netlink socket to send requests over (connected)
+ *
+ * The socket must stay allocated for as long as the batch is in use.
+ *
+ * @see nl_batch_free()
+ *
+ * @return Newly allocated batch or NULL.
+ */
+struct nl_batch *nl_batch_alloc(struct nl_sock *sk)
+{
+	struct nl_batch *b;
+
+	b = calloc(1, sizeof(*b));
+	if (!b)
+		return NULL;
+
+	b->b_sk = sk;
+	b->b_window = NL_BATCH_WINDOW;
+
+	NL_DBG(2, "Allocated new batch %p\n", b);
+
+	return b;
+}
+
+/**
+ * Free request batch
+ * @arg b		Request batch
+ *
+ * Drops all requests which have not been acknowledged yet.
+ *
+ * @see nl_batch_clear()
+ */
+void nl_batch_free(struct nl_batch *b)
+{
+	if (!b)
+		return;
+
+	nl_batch_clear(b);
+	free(b->b_reqs);
+
+	NL_DBG(2, "Freed batch %p\n", b);
+
+	free(b);
+}
+
+/** @} */
+
+/**
+ * @name Attributes
+ * @{
+ */
+
+/**
+ * Set maximum number of outstanding requests
+ * @arg b		Request batch
+ * @arg window		Maximum number of requests
+ *
+ * Limits the number of requests transmitted but not yet acknowledged.
+ * Every acknowledgement occupies space in the receive buffer of the socket
+ * until it is read. Error messages additionally carry a copy of the
+ * request header or, unless NETLINK_CAP_ACK is set on the socket, the
+ * whole request. Acknowledgements not fitting into the receive buffer are
+ * lost and cause nl_batch_commit() to fail, the window must therefore be
+ * chosen according to nl_socket_set_buffer_size(). Defaults to 64.
+ *
+ * @return 0 on success or a negative error code.
+ * @retval -NLE_INVAL \c window is zero
+ */
+int nl_batch_set_window(struct nl_batch *b, unsigned int window)
+{
+	if (window == 0)
+		return -NLE_INVAL;
+
+	b->b_window = window;
+
+	return 0;
+}
+
+/**
+ * Return maximum number of outstanding requests
+ * @arg b		Request batch
+ *
+ * @see nl_batch_set_window()
+ */
+unsigned int nl_batch_get_window(const struct nl_batch *b)
+{
+	return b->b_window;
+}
+
+/**
+ * Set request completion callback
+ * @arg b		Request batch
+ * @arg func		Callback function or NULL
+ * @arg arg		Argument passed to callback function
+ *
+ * The callback is invoked by nl_batch_commit() for every request once the
+ * acknowledgement or error message has been received. The error is
+ * reported as negative error code.
+ */
+void nl_batch_set_result_cb(struct nl_batch *b, nl_batch_result_func_t func,
+			    void *arg)
+{
+	b->b_result = func;
+	b->b_result_arg = arg;
+}
+
+/**
+ * Return number of requests not yet acknowledged
+ * @arg b		Request batch
+ */
+unsigned int nl_batch_get_count(const struct nl_batch *b)
+{
+	return b->b_count - b->b_acked;
+}
+
+/**
+ * Return number of requests transmitted but not yet acknowledged
+ * @arg b		Request batch
+ */
+unsigned int nl_batch_get_pending(const struct nl_batch *b)
+{
+	return b->b_sent - b->b_acked;
+}
+
+/** @} */
+
+/**
+ * @name Queueing/Transmission
+ * @{
+ */
+
+/**
+ * Add request to batch
+ * @arg b		Request batch
+ * @arg msg		Netlink message
+ *
+ * Finalizes the message with nl_complete_msg(), assigning a sequence
+ * number, and requests an acknowledgement regardless of the auto-ACK
+ * setting of the socket. The batch acquires a reference to the message,
+ * the caller may free it right away.
+ *
+ * The message is not transmitted until nl_batch_commit() is called.
+ *
+ * @return 0 on success or a negative error code.
+ */
+int nl_batch_add(struct nl_batch *b, struct nl_msg *msg)
+{
+	struct nl_batch_req *req;
+
+	if (b->b_count == b->b_size) {
+		unsigned int size = b->b_size ? b->b_size * 2 : 16;
+		void *tmp;
+
+		tmp = realloc(b->b_reqs, size * sizeof(*b->b_reqs));
+		if (!tmp)
+			return -NLE_NOMEM;
+
+		b->b_reqs = tmp;
+		b->b_size = size;
+	}
+
+	nl_complete_msg(b->b_sk, msg);
+	nlmsg_hdr(msg)->nlmsg_flags |= NLM_F_ACK;
+	nlmsg_get(msg);
+
+	req = &b->b_reqs[b->b_count++];
+	req->r_msg = msg;
+	req->r_seq = nlmsg_hdr(msg)->nlmsg_seq;
+	req->r_done = 0;
+
+	return 0;
+}
+
+/**
+ * Transmit all requests and wait for their acknowledgements
+ * @arg b		Request batch
+ *
+ * Transmits the queued requests, coalescing as many of them into a single
+ * sendmsg() call as possible, while keeping at most the number of requests
+ * set by nl_batch_set_window() outstanding. Receives and matches the
+ * responses until every request has been acknowledged, invoking the
+ * completion callback for each of them. Other messages received meanwhile
+ * are passed on to the callbacks of the socket.
+ *
+ * Requests are sent to the destination and with the credentials of the
+ * first request in each sendmsg() call. The \c NL_CB_MSG_OUT callback is
+ * invoked once per sendmsg() call for that request. If the send function
+ * has been overwritten with nl_cb_overwrite_send(), requests are
+ * transmitted one at a time.
+ *
+ * The batch is emptied on success and may be reused. If the function
+ * fails, e.g. with -NLE_AGAIN on a non-blocking socket, requests not yet
+ * acknowledged remain queued and calling the function again continues
+ * where it left off.
+ *
+ * @return Number of requests that failed or a negative error code.
+ */
+int nl_batch_commit(struct nl_batch *b)
+{
+	struct nl_cb *cb;
+	int err;
+
+	cb = nl_cb_clone(b->b_sk->s_cb);
+	if (!cb)
+		return -NLE_NOMEM;
+
+	nl_cb_set(cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, batch_seq_check, b);
+	nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, batch_ack_handler, b);
+	nl_cb_err(cb, NL_CB_CUSTOM, batch_error_handler, b);
+
+	while (b->b_acked < b->b_count) {
+		/* Refill the window once half of it has been acknowledged
+		 * to keep the number of requests per sendmsg() high. */
+		if (b->b_sent < b->b_count &&
+		    b->b_sent - b->b_acked <= b->b_window / 2)
+			err = batch_send(b);
+		else
+			err = nl_recvmsgs(b->b_sk, cb);
+
+		if (err < 0)
+			goto errout;
+	}
+
+	err = b->b_nerrors;
+	nl_batch_clear(b);
+
+errout:
+	nl_cb_put(cb);
+	return err;
+}
+
+/**
+ * Drop all requests
+ * @arg b		Request batch
+ *
+ * Responses to requests transmitted but not yet acknowledged will still
+ * be received by the socket.
+ */
+void nl_batch_clear(struct nl_batch *b)
+{
+	unsigned int i;
+
+	for (i = b->b_head; i < b->b_count; i++)
+		nlmsg_free(b->b_reqs[i].r_msg);
+
+	b->b_count = 0;
+	b->b_head = 0;
+	b->b_sent = 0;
+	b->b_acked = 0;
+	b->b_nerrors = 0;
+}
+
+/** @} */
+
+/** @} */
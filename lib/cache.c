@@ -113,6 +113,42 @@ struct nl_cache_ops *nl_cache_get_ops(struct nl_cache *cache)
 	return cache->c_ops;
 }
 
+/**
+ * Retrieve hash table statistics of the cache
+ * @arg cache		cache handle
+ * @arg stats		Pointer to store statistics in.
+ *
+ * @see nl_hash_table_get_stats()
+ *
+ * @return 0 on success or a negative error code.
+ * @retval -NLE_OPNOTSUPP The cache does not support hash lookups.
+ */
+int nl_cache_get_hash_stats(struct nl_cache *cache,
+			    struct nl_hash_table_stats *stats)
+{
+	if (!cache->hashtable)
+		return -NLE_OPNOTSUPP;
+
+	nl_hash_table_get_stats(cache->hashtable, stats);
+
+	return 0;
+}
+
+/**
+ * Retrieve statistics of the last resynchronization
+ * @arg cache		cache handle
+ * @arg stats		Pointer to store statistics in.
+ *
+ * All counters are zero if the cache has never been resynchronized.
+ *
+ * @see nl_cache_resync()
+ */
+void nl_cache_get_resync_stats(struct nl_cache *cache,
+			       struct nl_cache_resync_stats *stats)
+{
+	*stats = cache->c_resync_stats;
+}
+
 /**
  * Return the first element in the cache
  * @arg cache		cache handle
@@ -200,14 +236,10 @@ struct nl_cache *nl_cache_alloc(struct nl_cache_ops *ops)
 	 * cache objects for faster lookups
 	 */
 	if (ops->co_obj_ops->oo_keygen) {
-		int hashtable_size;
-
-		if (ops->co_hash_size)
-			hashtable_size = ops->co_hash_size;
-		else
-			hashtable_size = NL_MAX_HASH_ENTRIES;
-
-		cache->hashtable = nl_hash_table_alloc(hashtable_size);
+		/* The index starts out with a single group unless the cache
+		 * asks for more and grows with the number of objects. */
+		cache->hashtable = nl_hash_table_alloc_flags(ops->co_hash_size,
+							     NL_HASH_TABLE_OPEN);
 	}
 
 	NL_DBG(2, "Allocated cache %p <%s>.\n", cache, nl_cache_name(cache));
@@ -293,6 +325,8 @@ int nl_cache_alloc_name(const char *kind, struct nl_cache **result)
  * other. Later modifications to objects in the original cache will
  * not affect objects in the new cache.
  *
+ * @see nl_cache_snapshot() for a read-only view without copying objects
+ *
  * @return A newly allocated cache or NULL.
  */
 struct nl_cache *nl_cache_subset(struct nl_cache *orig,
@@ -372,6 +406,10 @@ void nl_cache_clear(struct nl_cache *cache)
 
 	nl_list_for_each_entry_safe(obj, tmp, &cache->c_items, ce_list)
 		nl_cache_remove(obj);
+
+	/* Blocks are released once all objects allocated from them are */
+	_nl_arena_free(cache->c_arena);
+	cache->c_arena = NULL;
 }
 
 static void __nl_cache_free(struct nl_cache *cache)
@@ -381,6 +419,9 @@ static void __nl_cache_free(struct nl_cache *cache)
 	if (cache->hashtable)
 		nl_hash_table_free(cache->hashtable);
 
+	if (cache->c_ops->co_index_free)
+		cache->c_ops->co_index_free(cache);
+
 	NL_DBG(2, "Freeing cache %p <%s>...\n", cache, nl_cache_name(cache));
 	free(cache);
 }
@@ -391,10 +432,12 @@ static void __nl_cache_free(struct nl_cache *cache)
  */
 void nl_cache_get(struct nl_cache *cache)
 {
-	cache->c_refcnt++;
+	int refcnt;
+
+	refcnt = __atomic_add_fetch(&cache->c_refcnt, 1, __ATOMIC_RELAXED);
 
 	NL_DBG(3, "Incremented cache %p <%s> reference count to %d\n",
-	       cache, nl_cache_name(cache), cache->c_refcnt);
+	       cache, nl_cache_name(cache), refcnt);
 }
 
 /**
@@ -408,15 +451,17 @@ void nl_cache_get(struct nl_cache *cache)
  */
 void nl_cache_free(struct nl_cache *cache)
 {
+	int refcnt;
+
 	if (!cache)
 		return;
 
-	cache->c_refcnt--;
+	refcnt = __atomic_sub_fetch(&cache->c_refcnt, 1, __ATOMIC_ACQ_REL);
 
 	NL_DBG(3, "Decremented cache %p <%s> reference count, %d remaining\n",
-	       cache, nl_cache_name(cache), cache->c_refcnt);
+	       cache, nl_cache_name(cache), refcnt);
 
-	if (cache->c_refcnt <= 0)
+	if (refcnt <= 0)
 		__nl_cache_free(cache);
 }
 
@@ -437,10 +482,14 @@ static int __cache_add(struct nl_cache *cache, struct nl_object *obj)
 	int ret;
 
 	obj->ce_cache = cache;
+	obj->ce_gen = cache->c_gen;
+
+	_nl_cache_write_begin(cache);
 
 	if (cache->hashtable) {
 		ret = nl_hash_table_add(cache->hashtable, obj);
 		if (ret < 0) {
+			_nl_cache_write_end(cache);
 			obj->ce_cache = NULL;
 			return ret;
 		}
@@ -449,6 +498,11 @@ static int __cache_add(struct nl_cache *cache, struct nl_object *obj)
 	nl_list_add_tail(&obj->ce_list, &cache->c_items);
 	cache->c_nitems++;
 
+	if (cache->c_ops->co_index_add)
+		cache->c_ops->co_index_add(cache, obj);
+
+	_nl_cache_write_end(cache);
+
 	NL_DBG(3, "Added object %p to cache %p <%s>, nitems %d\n",
 	       obj, cache, nl_cache_name(cache), cache->c_nitems);
 
@@ -539,6 +593,13 @@ int nl_cache_move(struct nl_cache *cache, struct nl_object *obj)
 	return __cache_add(cache, obj);
 }
 
+/** @cond SKIP */
+static void cache_obj_put(void *obj)
+{
+	nl_object_put(obj);
+}
+/** @endcond */
+
 /**
  * Remove object from cache.
  * @arg obj		Object to remove from cache
@@ -557,6 +618,13 @@ void nl_cache_remove(struct nl_object *obj)
 	if (cache == NULL)
 		return;
 
+	/* Concurrent readers may still be looking at the object, hold on
+	 * to it until they are done. */
+	if (_nl_cache_is_concurrent(cache))
+		nl_object_get(obj);
+
+	_nl_cache_write_begin(cache);
+
 	if (cache->hashtable) {
 		ret = nl_hash_table_del(cache->hashtable, obj);
 		if (ret < 0)
@@ -564,13 +632,21 @@ void nl_cache_remove(struct nl_object *obj)
 			       obj, cache, nl_cache_name(cache));
 	}
 
+	if (cache->c_ops->co_index_del)
+		cache->c_ops->co_index_del(cache, obj);
+
 	nl_list_del(&obj->ce_list);
 	obj->ce_cache = NULL;
 	nl_object_put(obj);
 	cache->c_nitems--;
 
+	_nl_cache_write_end(cache);
+
 	NL_DBG(2, "Deleted object %p from cache %p <%s>.\n",
 	       obj, cache, nl_cache_name(cache));
+
+	if (_nl_cache_is_concurrent(cache))
+		__nl_epoch_retire(cache_obj_put, obj);
 }
 
 /** @} */
@@ -610,9 +686,49 @@ void nl_cache_set_arg2(struct nl_cache *cache, int arg)
  * Set cache flags
  * @arg cache		Cache
  * @arg flags		Flags
+ *
+ * With `NL_CACHE_CONCURRENT` set, nl_cache_search(), nl_cache_find() and
+ * lookups of the object type such as rtnl_link_get() may be called from
+ * any number of threads without locking while a single thread updates the
+ * cache, e.g. through a cache manager. Objects are then never modified
+ * while in the cache, updates replace them with a modified copy, and
+ * objects removed are released once no lookup can be using them anymore.
+ * A lookup returns an object which was part of the cache at some point
+ * during the call. Iterating over the cache, e.g. nl_cache_foreach() or
+ * nl_cache_get_next(), and lookups falling back to a walk of the cache
+ * remain restricted to the updating thread. Only caches of object types
+ * supporting hashing are affected.
+ *
+ * With `NL_CACHE_LAZY_PARSE` set, object types supporting it keep rarely
+ * used sections of the received attributes, e.g. the statistics, VF info
+ * and protocol info of links, in raw form and only decode them when they
+ * are accessed for the first time. Such an access modifies the object, it
+ * must therefore not happen concurrently with other accesses to the same
+ * object. The flag can not be combined with `NL_CACHE_CONCURRENT`, either
+ * one is ignored if the other is set already or passed along with it. Nor
+ * can it be combined with snapshots, see nl_cache_snapshot().
+ *
+ * With `NL_CACHE_ARENA` set, objects received while filling the cache,
+ * and the addresses they hold, are carved out of large blocks instead of
+ * being allocated one by one. A block is freed along with the last object
+ * allocated from it, clearing or freeing a cache therefore takes a
+ * fraction of the calls to free(). Objects may still be kept after the
+ * cache is gone, they then keep their block allocated. Dumps merged into
+ * a filled cache, by nl_cache_resync() or nl_cache_pickup_checkdup(),
+ * allocate objects one by one.
  */
 void nl_cache_set_flags(struct nl_cache *cache, unsigned int flags)
 {
+	unsigned int excl = NL_CACHE_CONCURRENT | NL_CACHE_LAZY_PARSE;
+
+	/* Lookups from other threads would see objects being decoded */
+	if (((cache->c_flags | flags) & excl) == excl) {
+		NL_DBG(1, "Cache %p <%s>: Ignoring flags 0x%x, lazy parsing "
+		       "and concurrent lookups are exclusive\n", cache,
+		       nl_cache_name(cache), flags & excl);
+		flags &= ~excl;
+	}
+
 	cache->c_flags |= flags;
 }
 
@@ -711,6 +827,11 @@ static int __cache_pickup(struct nl_sock *sk, struct nl_cache *cache,
 	return err;
 }
 
+static int cache_update_copy(struct nl_cache *, struct nl_object *,
+			     struct nl_object *, uint64_t, change_func_t,
+			     change_func_v2_t, void *);
+static int cache_obj_in_snapshot(struct nl_cache *, struct nl_object *);
+
 static int pickup_checkdup_cb(struct nl_object *c, struct nl_parser_param *p)
 {
 	struct nl_cache *cache = (struct nl_cache *)p->pp_arg;
@@ -718,7 +839,14 @@ static int pickup_checkdup_cb(struct nl_object *c, struct nl_parser_param *p)
 
 	old = nl_cache_search(cache, c);
 	if (old) {
-		if (nl_object_update(old, c) == 0) {
+		if (_nl_cache_is_concurrent(cache) ||
+		    cache_obj_in_snapshot(cache, old)) {
+			if (cache_update_copy(cache, old, c, 0, NULL, NULL,
+					      NULL) == 0) {
+				nl_object_put(old);
+				return 0;
+			}
+		} else if (nl_object_update(old, c) == 0) {
 			nl_object_put(old);
 			return 0;
 		}
@@ -737,20 +865,233 @@ static int pickup_cb(struct nl_object *c, struct nl_parser_param *p)
 	return nl_cache_add(cache, c);
 }
 
+/* Arena to allocate objects of a dump from, NULL unless NL_CACHE_ARENA.
+ * Dumps merged into a filled cache mostly yield objects which are dropped
+ * again, those kept would pin a block each. They are not allocated from
+ * the arena. */
+static struct nl_arena *cache_arena(struct nl_cache *cache, int merge)
+{
+	if (!(cache->c_flags & NL_CACHE_ARENA) ||
+	    (merge && cache->c_nitems > 0))
+		return NULL;
+
+	if (!cache->c_arena)
+		cache->c_arena = _nl_arena_alloc();
+
+	return cache->c_arena;
+}
+
 static int __nl_cache_pickup(struct nl_sock *sk, struct nl_cache *cache,
 			     int checkdup)
 {
 	struct nl_parser_param p;
+	struct nl_arena *prev;
+	int err;
 
 	p.pp_cb = checkdup ? pickup_checkdup_cb : pickup_cb;
 	p.pp_arg = cache;
+	p.pp_flags = cache->c_flags;
 
 	if (sk->s_proto != cache->c_ops->co_protocol)
 		return -NLE_PROTO_MISMATCH;
 
-	return __cache_pickup(sk, cache, &p);
+	prev = _nl_arena_enter(cache_arena(cache, checkdup));
+	err = __cache_pickup(sk, cache, &p);
+	_nl_arena_leave(prev);
+
+	return err;
+}
+
+/** @cond SKIP */
+#ifndef DISABLE_PTHREADS
+/* Dump of a single address family of a NL_CACHE_AF_PARALLEL cache */
+struct cache_af_dump
+{
+	/* Only carries the ops, family and arguments of the dump request */
+	struct nl_cache		ad_cache;
+	struct nl_list_head	ad_objs;
+	int			ad_rcvbuf;
+	size_t			ad_msg_buf_size;
+	pthread_t		ad_thread;
+	int			ad_started;
+	int			ad_err;
+};
+
+static int af_dump_cb(struct nl_object *obj, struct nl_parser_param *p)
+{
+	struct cache_af_dump *ad = p->pp_arg;
+
+	/* Objects are queued and only added to the cache by the caller */
+	nl_object_get(obj);
+	nl_list_add_tail(&obj->ce_list, &ad->ad_objs);
+
+	return 0;
+}
+
+static void af_dump_drop(struct cache_af_dump *ad)
+{
+	struct nl_object *obj, *next;
+
+	nl_list_for_each_entry_safe(obj, next, &ad->ad_objs, ce_list) {
+		nl_list_del(&obj->ce_list);
+		nl_init_list_head(&obj->ce_list);
+		nl_object_put(obj);
+	}
+}
+
+static void *af_dump_thread(void *arg)
+{
+	struct cache_af_dump *ad = arg;
+	struct nl_cache *cache = &ad->ad_cache;
+	struct nl_parser_param p = {
+		.pp_cb = af_dump_cb,
+		.pp_arg = ad,
+		.pp_flags = cache->c_flags,
+	};
+	struct nl_arena *arena = NULL, *prev;
+	struct nl_sock *sk;
+	int err;
+
+	if (!(sk = nl_socket_alloc())) {
+		ad->ad_err = -NLE_NOMEM;
+		return NULL;
+	}
+
+	if ((err = nl_connect(sk, cache->c_ops->co_protocol)) < 0)
+		goto errout;
+
+	if (ad->ad_rcvbuf > 0 &&
+	    (err = nl_socket_set_buffer_size(sk, ad->ad_rcvbuf, 0)) < 0)
+		goto errout;
+
+	nl_socket_set_msg_buf_size(sk, ad->ad_msg_buf_size);
+
+	/* The arena of the cache is not shared between threads */
+	if (cache->c_flags & NL_CACHE_ARENA)
+		arena = _nl_arena_alloc();
+	prev = _nl_arena_enter(arena);
+
+restart:
+	err = nl_cache_request_full_dump(sk, cache);
+	if (err < 0)
+		goto out;
+
+	err = __cache_pickup(sk, cache, &p);
+	if (err == -NLE_DUMP_INTR) {
+		NL_DBG(2, "Dump interrupted, restarting!\n");
+		af_dump_drop(ad);
+		goto restart;
+	}
+
+out:
+	_nl_arena_leave(prev);
+	_nl_arena_free(arena);
+errout:
+	nl_socket_free(sk);
+	ad->ad_err = err;
+
+	return NULL;
 }
 
+/*
+ * Dumps all address families of the cache concurrently, each on its own
+ * socket and thread, and passes the objects received to the parser
+ * callback in the order of the families.
+ */
+static int cache_dump_parallel(struct nl_sock *sk, struct nl_cache *cache,
+			       struct nl_parser_param *p)
+{
+	struct cache_af_dump *dumps;
+	struct nl_af_group *grp;
+	struct nl_object *obj, *next;
+	socklen_t optlen = sizeof(int);
+	int i, n = 0, rcvbuf = 0, err = 0;
+
+	for (grp = cache->c_ops->co_groups; grp->ag_group; grp++)
+		n++;
+
+	if (!(dumps = calloc(n, sizeof(*dumps))))
+		return -NLE_NOMEM;
+
+	/* The kernel reports twice the size set */
+	if (getsockopt(nl_socket_get_fd(sk), SOL_SOCKET, SO_RCVBUF,
+		       &rcvbuf, &optlen) == 0)
+		rcvbuf /= 2;
+
+	for (i = 0; i < n; i++) {
+		struct cache_af_dump *ad = &dumps[i];
+
+		nl_init_list_head(&ad->ad_objs);
+		ad->ad_rcvbuf = rcvbuf;
+		ad->ad_msg_buf_size = nl_socket_get_msg_buf_size(sk);
+
+		nl_init_list_head(&ad->ad_cache.c_items);
+		ad->ad_cache.c_ops = cache->c_ops;
+		ad->ad_cache.c_iarg1 = cache->c_ops->co_groups[i].ag_family;
+		ad->ad_cache.c_iarg2 = cache->c_iarg2;
+		ad->ad_cache.c_flags = cache->c_flags;
+		if (cache->c_nitems > 0)
+			ad->ad_cache.c_flags &= ~NL_CACHE_ARENA;
+
+		if (pthread_create(&ad->ad_thread, NULL, af_dump_thread,
+				   ad) == 0)
+			ad->ad_started = 1;
+	}
+
+	/* Dump families for which no thread could be started in place */
+	for (i = 0; i < n; i++)
+		if (!dumps[i].ad_started)
+			af_dump_thread(&dumps[i]);
+
+	for (i = 0; i < n; i++)
+		if (dumps[i].ad_started)
+			pthread_join(dumps[i].ad_thread, NULL);
+
+	for (i = 0; i < n; i++) {
+		struct cache_af_dump *ad = &dumps[i];
+
+		NL_DBG(2, "Dump of family %d for cache %p <%s> returned %d\n",
+		       cache->c_ops->co_groups[i].ag_family, cache,
+		       nl_cache_name(cache), ad->ad_err);
+
+		if (!err && ad->ad_err < 0)
+			err = ad->ad_err;
+
+		nl_list_for_each_entry_safe(obj, next, &ad->ad_objs, ce_list) {
+			nl_list_del(&obj->ce_list);
+			nl_init_list_head(&obj->ce_list);
+
+			/* Like a serial dump, stop at the first failure */
+			if (!err) {
+				err = p->pp_cb(obj, p);
+				if (err == -NLE_EXIST)
+					err = 0;
+			}
+
+			nl_object_put(obj);
+		}
+	}
+
+	free(dumps);
+
+	return err;
+}
+#endif
+
+static int cache_dump_is_parallel(struct nl_cache *cache)
+{
+#ifndef DISABLE_PTHREADS
+	struct nl_af_group *grp = cache->c_ops->co_groups;
+
+	return (cache->c_flags & NL_CACHE_AF_ITER) &&
+	       (cache->c_flags & NL_CACHE_AF_PARALLEL) &&
+	       grp && grp->ag_group;
+#else
+	return 0;
+#endif
+}
+/** @endcond */
+
 /**
  * Pickup a netlink dump response and put it into a cache.
  * @arg sk		Netlink socket.
@@ -784,29 +1125,129 @@ int nl_cache_pickup(struct nl_sock *sk, struct nl_cache *cache)
 	return __nl_cache_pickup(sk, cache, 0);
 }
 
+/*
+ * Marks an object as seen by the resync in progress. Objects are moved to
+ * the tail as they are seen, the objects of the cache thus remain sorted by
+ * generation and obsolete ones are found at the head. Objects added are
+ * stamped by __cache_add() and updates outside of a resync leave the order
+ * of the cache alone.
+ */
+static void cache_stamp(struct nl_cache *cache, struct nl_object *obj)
+{
+	obj->ce_gen = cache->c_gen;
+	nl_list_del(&obj->ce_list);
+	nl_list_add_tail(&obj->ce_list, &cache->c_items);
+}
+
+/*
+ * Objects of a cache with NL_CACHE_CONCURRENT set are never modified in
+ * place, lookups may be reading them, neither are objects shared with a
+ * snapshot. The object is merged into a copy which then replaces it.
+ */
+static int cache_update_copy(struct nl_cache *cache, struct nl_object *old,
+			     struct nl_object *obj, uint64_t diff,
+			     change_func_t cb, change_func_v2_t cb_v2,
+			     void *data)
+{
+	struct nl_object *upd;
+
+	if (!old->ce_ops->oo_update || !(upd = nl_object_clone(old)))
+		return -NLE_OPNOTSUPP;
+
+	if (nl_object_update(upd, obj) != 0) {
+		nl_object_put(upd);
+		return -NLE_OPNOTSUPP;
+	}
+
+	_nl_cache_write_begin(cache);
+	nl_cache_remove(old);
+	if (__cache_add(cache, upd) < 0) {
+		NL_DBG(2, "Failed to replace %p in cache %p <%s>\n",
+		       old, cache, nl_cache_name(cache));
+		nl_object_put(upd);
+		upd = NULL;
+	}
+	_nl_cache_write_end(cache);
+
+	if (cb_v2)
+		cb_v2(cache, old, obj, diff, NL_ACT_CHANGE, data);
+	else if (cb && upd)
+		cb(cache, upd, NL_ACT_CHANGE, data);
+
+	return 0;
+}
+
+/* Returns true if @obj, looked up in @cache, is part of a snapshot */
+static int cache_obj_in_snapshot(struct nl_cache *cache, struct nl_object *obj)
+{
+	/* references of the cache and of the lookup */
+	int own = (cache->hashtable ? 2 : 1) + 1;
+
+	if (!(obj->ce_flags & NL_OBJ_SNAPSHOT))
+		return 0;
+
+	if (__atomic_load_n(&obj->ce_refcnt, __ATOMIC_ACQUIRE) > own)
+		return 1;
+
+	/* all snapshots are gone */
+	obj->ce_flags &= ~NL_OBJ_SNAPSHOT;
+
+	return 0;
+}
+
+/*
+ * @merged are changes already merged into @obj, e.g. by coalescing, which
+ * are reported in addition to the difference to the cached object. @resync
+ * is set while the object is included by nl_cache_resync().
+ */
 static int cache_include(struct nl_cache *cache, struct nl_object *obj,
-			 struct nl_msgtype *type, change_func_t cb,
-			 change_func_v2_t cb_v2, void *data)
+			 struct nl_msgtype *type, uint64_t merged, int resync,
+			 change_func_t cb, change_func_v2_t cb_v2, void *data)
 {
 	struct nl_object *old;
 	struct nl_object *clone = NULL;
 	uint64_t diff = 0;
+	int merge = 0;
 
 	switch (type->mt_act) {
 	case NL_ACT_NEW:
 	case NL_ACT_DEL:
 		old = nl_cache_search(cache, obj);
-		if (old) {
-			if (cb_v2 && old->ce_ops->oo_update) {
-				clone = nl_object_clone(old);
-				diff = nl_object_diff64(old, obj);
+		if (old && old->ce_ops->oo_update) {
+			/*
+			 * The diff is computed before anything is copied. An
+			 * update repeating the cached state changes nothing,
+			 * the cached object is kept and obj is dropped.
+			 */
+			diff = merged | nl_object_diff64(old, obj);
+			if (!diff && type->mt_act == NL_ACT_NEW) {
+				if (resync)
+					cache_stamp(cache, old);
+				nl_object_put(old);
+				return 0;
+			}
+			merge = 1;
+		}
+
+		if (merge && (_nl_cache_is_concurrent(cache) ||
+			      cache_obj_in_snapshot(cache, old))) {
+			if (cache_update_copy(cache, old, obj, diff, cb, cb_v2,
+					      data) == 0) {
+				nl_object_put(old);
+				return 0;
 			}
+		} else if (merge) {
+			/* The previous state is only kept for cb_v2 */
+			if (cb_v2)
+				clone = nl_object_clone(old);
 			/*
 			 * Some objects types might support merging the new
 			 * object with the old existing cache object.
 			 * Handle them first.
 			 */
 			if (nl_object_update(old, obj) == 0) {
+				if (resync)
+					cache_stamp(cache, old);
 				if (cb_v2) {
 					cb_v2(cache, clone, obj, diff,
 					      NL_ACT_CHANGE, data);
@@ -817,30 +1258,38 @@ static int cache_include(struct nl_cache *cache, struct nl_object *obj,
 				return 0;
 			}
 			nl_object_put(clone);
+		}
 
+		if (old && type->mt_act == NL_ACT_NEW) {
+			/* Lookups retry rather than miss the object while it
+			 * is being replaced */
+			_nl_cache_write_begin(cache);
 			nl_cache_remove(old);
-			if (type->mt_act == NL_ACT_DEL) {
-				if (cb_v2)
-					cb_v2(cache, old, NULL, 0, NL_ACT_DEL,
-					      data);
-				else if (cb)
-					cb(cache, old, NL_ACT_DEL, data);
-				nl_object_put(old);
-			}
+			nl_cache_move(cache, obj);
+			_nl_cache_write_end(cache);
+		} else if (old) {
+			nl_cache_remove(old);
+			if (cb_v2)
+				cb_v2(cache, old, NULL, 0, NL_ACT_DEL, data);
+			else if (cb)
+				cb(cache, old, NL_ACT_DEL, data);
+			nl_object_put(old);
 		}
 
 		if (type->mt_act == NL_ACT_NEW) {
-			nl_cache_move(cache, obj);
 			if (old == NULL) {
+				nl_cache_move(cache, obj);
 				if (cb_v2) {
 					cb_v2(cache, NULL, obj, 0, NL_ACT_NEW,
 					      data);
 				} else if (cb)
 					cb(cache, obj, NL_ACT_NEW, data);
 			} else if (old) {
-				diff = 0;
-				if (cb || cb_v2)
-					diff = nl_object_diff64(old, obj);
+				if (!old->ce_ops->oo_update) {
+					diff = merged;
+					if (cb || cb_v2)
+						diff |= nl_object_diff64(old, obj);
+				}
 				if (diff && cb_v2) {
 					cb_v2(cache, old, obj, diff, NL_ACT_CHANGE,
 					      data);
@@ -859,6 +1308,23 @@ static int cache_include(struct nl_cache *cache, struct nl_object *obj,
 	return 0;
 }
 
+/** @cond SKIP */
+/*
+ * Includes an object of a message type already looked up, @merged are
+ * changes already merged into it, see cache_include().
+ */
+int _nl_cache_include_msgtype(struct nl_cache *cache, struct nl_object *obj,
+			      struct nl_msgtype *type, uint64_t merged,
+			      change_func_t cb, change_func_v2_t cb_v2,
+			      void *data)
+{
+	if (cache->c_ops->co_obj_ops != obj->ce_ops)
+		return -NLE_OBJ_MISMATCH;
+
+	return cache_include(cache, obj, type, merged, 0, cb, cb_v2, data);
+}
+/** @endcond */
+
 int nl_cache_include(struct nl_cache *cache, struct nl_object *obj,
 		     change_func_t change_cb, void *data)
 {
@@ -871,7 +1337,7 @@ int nl_cache_include(struct nl_cache *cache, struct nl_object *obj,
 	for (i = 0; ops->co_msgtypes[i].mt_id >= 0; i++)
 		if (ops->co_msgtypes[i].mt_id == obj->ce_msgtype)
 			return cache_include(cache, obj, &ops->co_msgtypes[i],
-					     change_cb, NULL, data);
+					     0, 0, change_cb, NULL, data);
 
 	NL_DBG(3, "Object %p does not seem to belong to cache %p <%s>\n",
 	       obj, cache, nl_cache_name(cache));
@@ -891,7 +1357,7 @@ int nl_cache_include_v2(struct nl_cache *cache, struct nl_object *obj,
 	for (i = 0; ops->co_msgtypes[i].mt_id >= 0; i++)
 		if (ops->co_msgtypes[i].mt_id == obj->ce_msgtype)
 			return cache_include(cache, obj, &ops->co_msgtypes[i],
-						NULL, change_cb, data);
+					     0, 0, NULL, change_cb, data);
 
 	NL_DBG(3, "Object %p does not seem to belong to cache %p <%s>\n",
 	       obj, cache, nl_cache_name(cache));
@@ -902,29 +1368,80 @@ int nl_cache_include_v2(struct nl_cache *cache, struct nl_object *obj,
 static int resync_cb(struct nl_object *c, struct nl_parser_param *p)
 {
 	struct nl_cache_assoc *ca = p->pp_arg;
+	struct nl_cache *cache = ca->ca_cache;
+	struct nl_msgtype *type = p->pp_msgtype;
 
-	if (ca->ca_change_v2)
-		return nl_cache_include_v2(ca->ca_cache, c, ca->ca_change_v2,
-					   ca->ca_change_data);
-	else
-		return nl_cache_include(ca->ca_cache, c, ca->ca_change,
-					ca->ca_change_data);
+	cache->c_resync_stats.rs_received++;
+
+	if (cache->c_ops->co_obj_ops != c->ce_ops)
+		return -NLE_OBJ_MISMATCH;
+
+	if ((!type || type->mt_id != c->ce_msgtype) &&
+	    !(type = nl_msgtype_lookup(cache->c_ops, c->ce_msgtype)))
+		return -NLE_MSGTYPE_NOSUPPORT;
+
+	return cache_include(cache, c, type, 0, 1,
+			     ca->ca_change_v2 ? NULL : ca->ca_change,
+			     ca->ca_change_v2, ca->ca_change_data);
 }
 
+static uint64_t resync_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Synchronize cache with kernel
+ * @arg sk		Netlink socket
+ * @arg cache		Cache
+ * @arg change_cb	Callback invoked for every object added, changed or
+ *			removed, may be NULL
+ * @arg data		Argument passed to callback
+ *
+ * Requests a full dump and includes every object received into the cache.
+ * Objects not part of the dump are removed afterwards.
+ *
+ * Each resynchronization starts a new generation of the cache. Objects
+ * received are stamped with it and kept at the tail of the cache, the
+ * obsolete objects are therefore found at the head without visiting any
+ * other object. Timings are available through nl_cache_get_resync_stats().
+ *
+ * Address families are dumped concurrently if NL_CACHE_AF_PARALLEL is set,
+ * see nl_cache_refill().
+ *
+ * @return 0 on success or a negative error code.
+ */
 int nl_cache_resync(struct nl_sock *sk, struct nl_cache *cache,
 		    change_func_t change_cb, void *data)
 {
-	struct nl_object *obj, *next;
-	struct nl_af_group *grp;
 	struct nl_cache_assoc ca = {
 		.ca_cache = cache,
 		.ca_change = change_cb,
 		.ca_change_data = data,
 	};
+
+	return _nl_cache_resync_assoc(sk, &ca);
+}
+
+/** @cond SKIP */
+/* Resyncs the cache of an association, invoking its change callbacks */
+int _nl_cache_resync_assoc(struct nl_sock *sk, struct nl_cache_assoc *ca)
+{
+	struct nl_cache *cache = ca->ca_cache;
+	struct nl_cache_resync_stats *stats = &cache->c_resync_stats;
+	struct nl_object *obj, *next;
+	uint64_t start;
+	struct nl_af_group *grp;
 	struct nl_parser_param p = {
 		.pp_cb = resync_cb,
-		.pp_arg = &ca,
+		.pp_arg = ca,
+		.pp_flags = cache->c_flags,
 	};
+	struct nl_arena *arena, *prev;
 	int err;
 
 	if (sk->s_proto != cache->c_ops->co_protocol)
@@ -932,8 +1449,22 @@ int nl_cache_resync(struct nl_sock *sk, struct nl_cache *cache,
 
 	NL_DBG(1, "Resyncing cache %p <%s>...\n", cache, nl_cache_name(cache));
 
-	/* Mark all objects so we can see if some of them are obsolete */
-	nl_cache_mark_all(cache);
+	arena = cache_arena(cache, 1);
+
+	memset(stats, 0, sizeof(*stats));
+	start = resync_usec();
+
+	/* Objects not seen in the new generation are obsolete */
+	cache->c_gen++;
+
+	if (cache_dump_is_parallel(cache)) {
+#ifndef DISABLE_PTHREADS
+		err = cache_dump_parallel(sk, cache, &p);
+		if (err < 0)
+			goto errout;
+#endif
+		goto sweep;
+	}
 
 	grp = cache->c_ops->co_groups;
 	do {
@@ -946,7 +1477,9 @@ restart:
 		if (err < 0)
 			goto errout;
 
+		prev = _nl_arena_enter(arena);
 		err = __cache_pickup(sk, cache, &p);
+		_nl_arena_leave(prev);
 		if (err == -NLE_DUMP_INTR)
 			goto restart;
 		else if (err < 0)
@@ -957,22 +1490,38 @@ restart:
 	} while (grp && grp->ag_group &&
 		(cache->c_flags & NL_CACHE_AF_ITER));
 
+sweep:
+	stats->rs_dump_usec = resync_usec() - start;
+	start += stats->rs_dump_usec;
+
 	nl_list_for_each_entry_safe(obj, next, &cache->c_items, ce_list) {
-		if (nl_object_is_marked(obj)) {
-			nl_object_get(obj);
-			nl_cache_remove(obj);
-			if (change_cb)
-				change_cb(cache, obj, NL_ACT_DEL, data);
-			nl_object_put(obj);
-		}
+		if (obj->ce_gen == cache->c_gen)
+			break;
+
+		nl_object_get(obj);
+		nl_cache_remove(obj);
+		if (ca->ca_change_v2)
+			ca->ca_change_v2(cache, obj, NULL, 0, NL_ACT_DEL,
+					 ca->ca_change_data);
+		else if (ca->ca_change)
+			ca->ca_change(cache, obj, NL_ACT_DEL,
+				      ca->ca_change_data);
+		nl_object_put(obj);
+		stats->rs_removed++;
 	}
 
-	NL_DBG(1, "Finished resyncing %p <%s>\n", cache, nl_cache_name(cache));
+	stats->rs_sweep_usec = resync_usec() - start;
+
+	NL_DBG(1, "Finished resyncing %p <%s>: %u objects received, %u removed, "
+	       "dump %" PRIu64 "us, sweep %" PRIu64 "us\n", cache,
+	       nl_cache_name(cache), stats->rs_received, stats->rs_removed,
+	       stats->rs_dump_usec, stats->rs_sweep_usec);
 
 	err = 0;
 errout:
 	return err;
 }
+/** @endcond */
 
 /** @} */
 
@@ -982,26 +1531,36 @@ errout:
  */
 
 /** @cond SKIP */
+/* Parses a message of a type already looked up in the cache operations */
+int _nl_cache_parse_msgtype(struct nl_cache_ops *ops, struct nl_msgtype *mt,
+			    struct sockaddr_nl *who, struct nlmsghdr *nlh,
+			    struct nl_parser_param *params)
+{
+	int err;
+
+	if (!nlmsg_valid_hdr(nlh, ops->co_hdrsize))
+		return -NLE_MSG_TOOSHORT;
+
+	params->pp_msgtype = mt;
+	err = ops->co_msg_parser(ops, who, nlh, params);
+	if (err == -NLE_OPNOTSUPP)
+		err = -NLE_MSGTYPE_NOSUPPORT;
+
+	return err;
+}
+
 int nl_cache_parse(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 		   struct nlmsghdr *nlh, struct nl_parser_param *params)
 {
-	int i, err;
+	struct nl_msgtype *mt;
 
 	if (!nlmsg_valid_hdr(nlh, ops->co_hdrsize))
 		return -NLE_MSG_TOOSHORT;
 
-	for (i = 0; ops->co_msgtypes[i].mt_id >= 0; i++) {
-		if (ops->co_msgtypes[i].mt_id == nlh->nlmsg_type) {
-			err = ops->co_msg_parser(ops, who, nlh, params);
-			if (err != -NLE_OPNOTSUPP)
-				goto errout;
-		}
-	}
-
+	if (!(mt = nl_msgtype_lookup(ops, nlh->nlmsg_type)))
+		return -NLE_MSGTYPE_NOSUPPORT;
 
-	err = -NLE_MSGTYPE_NOSUPPORT;
-errout:
-	return err;
+	return _nl_cache_parse_msgtype(ops, mt, who, nlh, params);
 }
 /** @endcond */
 
@@ -1023,6 +1582,7 @@ int nl_cache_parse_and_add(struct nl_cache *cache, struct nl_msg *msg)
 	struct nl_parser_param p = {
 		.pp_cb = pickup_cb,
 		.pp_arg = cache,
+		.pp_flags = cache->c_flags,
 	};
 
 	return nl_cache_parse(cache->c_ops, NULL, nlmsg_hdr(msg), &p);
@@ -1036,6 +1596,13 @@ int nl_cache_parse_and_add(struct nl_cache *cache, struct nl_msg *msg)
  * Clears the specified cache and fills it with the current state in
  * the kernel.
  *
+ * If both NL_CACHE_AF_ITER and NL_CACHE_AF_PARALLEL are set, the address
+ * families are dumped concurrently, each over a new socket of the same
+ * protocol in the current network namespace and parsed on its own thread.
+ * The receive buffer and message buffer sizes of \c sk are applied to
+ * these sockets, its callbacks are not. The objects are added to the cache
+ * by the calling thread in the order of the address families.
+ *
  * @return 0 or a negative error code.
  */
 int nl_cache_refill(struct nl_sock *sk, struct nl_cache *cache)
@@ -1047,6 +1614,19 @@ int nl_cache_refill(struct nl_sock *sk, struct nl_cache *cache)
 		return -NLE_PROTO_MISMATCH;
 
 	nl_cache_clear(cache);
+
+	if (cache_dump_is_parallel(cache)) {
+#ifndef DISABLE_PTHREADS
+		struct nl_parser_param p = {
+			.pp_cb = pickup_cb,
+			.pp_arg = cache,
+			.pp_flags = cache->c_flags,
+		};
+
+		return cache_dump_parallel(sk, cache, &p);
+#endif
+	}
+
 	grp = cache->c_ops->co_groups;
 	do {
 		if (grp && grp->ag_group &&
@@ -1076,17 +1656,365 @@ restart:
 	return err;
 }
 
+/** @cond SKIP */
+struct stream_xdata {
+	struct nl_cache_ops *	ops;
+	nl_cache_stream_func_t	func;
+	void *			arg;
+	int			count;
+	int			stopped;
+};
+
+static int stream_cb(struct nl_object *obj, struct nl_parser_param *p)
+{
+	struct stream_xdata *x = p->pp_arg;
+
+	x->count++;
+	if (x->func(obj, x->arg) == NL_STOP)
+		x->stopped = 1;
+
+	return 0;
+}
+
+static int stream_msg_parser(struct nl_msg *msg, void *arg)
+{
+	struct nl_parser_param *p = arg;
+	struct stream_xdata *x = p->pp_arg;
+	int err;
+
+	/* The rest of the dump is still read to keep the socket usable
+	 * but no longer parsed */
+	if (x->stopped)
+		return NL_SKIP;
+
+	err = nl_cache_parse(x->ops, &msg->nm_src, msg->nm_nlh, p);
+	if (err == -NLE_EXIST)
+		return NL_SKIP;
+
+	return err;
+}
+/** @endcond */
+
+/**
+ * Dump objects from the kernel without adding them to a cache
+ * @arg sk		Netlink socket
+ * @arg cache		Cache
+ * @arg func		Callback function invoked for each object
+ * @arg arg		Argument passed to callback function
+ *
+ * Requests a dump like nl_cache_refill() but hands each object to \p func
+ * as soon as it has been parsed instead of adding it to \p cache, which
+ * is left untouched. The cache only provides the type and the dump
+ * parameters, e.g. as set by nl_cache_set_arg1() or `NL_CACHE_AF_ITER`.
+ * Memory use is thus bounded by the receive buffer rather than the
+ * number of objects dumped.
+ *
+ * The object is released after \p func returns, acquire a reference with
+ * nl_object_get() to keep it. Returning NL_STOP from \p func stops the
+ * dump, remaining messages are read from the socket but not parsed.
+ *
+ * Unlike nl_cache_refill(), an inconsistent dump is not restarted since
+ * objects have already been delivered. `NL_CACHE_AF_PARALLEL` is ignored.
+ *
+ * @code
+ * static int count_cb(struct nl_object *obj, void *arg)
+ * {
+ *         (*(int *) arg)++;
+ *         return NL_OK;
+ * }
+ *
+ * nl_cache_alloc_name("netfilter/ct", &cache);
+ * nl_cache_stream(sk, cache, count_cb, &count);
+ * @endcode
+ *
+ * @return Number of objects delivered or a negative error code.
+ * @retval -NLE_DUMP_INTR The dump was interrupted, objects may have been
+ *                        missed or delivered twice.
+ */
+int nl_cache_stream(struct nl_sock *sk, struct nl_cache *cache,
+		    nl_cache_stream_func_t func, void *arg)
+{
+	struct stream_xdata x = {
+		.ops = cache->c_ops,
+		.func = func,
+		.arg = arg,
+	};
+	struct nl_parser_param p = {
+		.pp_cb = stream_cb,
+		.pp_arg = &x,
+		.pp_flags = cache->c_flags,
+	};
+	struct nl_af_group *grp;
+	struct nl_cb *cb;
+	int err;
+
+	if (sk->s_proto != cache->c_ops->co_protocol)
+		return -NLE_PROTO_MISMATCH;
+
+	cb = nl_cb_clone(sk->s_cb);
+	if (cb == NULL)
+		return -NLE_NOMEM;
+
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, stream_msg_parser, &p);
+
+	grp = cache->c_ops->co_groups;
+	do {
+		if (grp && grp->ag_group &&
+			(cache->c_flags & NL_CACHE_AF_ITER))
+			nl_cache_set_arg1(cache, grp->ag_family);
+
+		err = nl_cache_request_full_dump(sk, cache);
+		if (err < 0)
+			break;
+
+		NL_DBG(2, "Streaming dump of <%s> for family %u\n",
+		       nl_cache_name(cache), grp ? grp->ag_family : AF_UNSPEC);
+
+		err = nl_recvmsgs(sk, cb);
+		if (err < 0)
+			break;
+
+		if (grp)
+			grp++;
+	} while (!x.stopped && grp && grp->ag_group &&
+			(cache->c_flags & NL_CACHE_AF_ITER));
+
+	nl_cb_put(cb);
+
+	return err < 0 ? err : x.count;
+}
+
+/** @} */
+
+/**
+ * @name Snapshots
+ * @{
+ */
+
+/**
+ * Take snapshot of cache
+ * @arg cache		Cache
+ *
+ * Creates a point-in-time view of the objects of the cache. Unlike
+ * nl_cache_clone(), no object is copied, the snapshot references the
+ * objects of the cache. Objects are copied on write instead: while an
+ * object is referenced by a snapshot, cache updates such as
+ * nl_cache_include() replace it with an updated copy rather than
+ * modifying it. Objects of a snapshot must not be modified and remain
+ * associated with the cache as long as they are part of it.
+ *
+ * Objects not modified between two snapshots are thus shared, which
+ * allows nl_cache_snapshot_diff() to skip them by comparing pointers.
+ *
+ * For a cache with `NL_CACHE_CONCURRENT` set, snapshots must be taken
+ * by the thread updating the cache. Caches with `NL_CACHE_LAZY_PARSE`
+ * set can not be taken snapshots of, reading an object may decode it.
+ *
+ * @see nl_cache_snapshot_free()
+ *
+ * @return Newly allocated snapshot or NULL.
+ */
+struct nl_cache_snapshot *nl_cache_snapshot(struct nl_cache *cache)
+{
+	struct nl_cache_snapshot *snap;
+	struct nl_object *obj;
+	int i = 0;
+
+	if (cache->c_flags & NL_CACHE_LAZY_PARSE)
+		return NULL;
+
+	snap = calloc(1, sizeof(*snap));
+	if (!snap)
+		return NULL;
+
+	if (cache->c_nitems > 0) {
+		snap->cs_objs = malloc(cache->c_nitems * sizeof(*snap->cs_objs));
+		if (!snap->cs_objs) {
+			free(snap);
+			return NULL;
+		}
+	}
+
+	snap->cs_ops = cache->c_ops;
+
+	nl_list_for_each_entry(obj, &cache->c_items, ce_list) {
+		obj->ce_flags |= NL_OBJ_SNAPSHOT;
+		nl_object_get(obj);
+		snap->cs_objs[i++] = obj;
+	}
+	snap->cs_nitems = i;
+
+	NL_DBG(2, "Took snapshot %p of cache %p <%s>, %d objects\n",
+	       snap, cache, nl_cache_name(cache), i);
+
+	return snap;
+}
+
+/**
+ * Free cache snapshot
+ * @arg snap		Snapshot
+ *
+ * Releases the references to all objects of the snapshot.
+ */
+void nl_cache_snapshot_free(struct nl_cache_snapshot *snap)
+{
+	int i;
+
+	if (!snap)
+		return;
+
+	for (i = 0; i < snap->cs_nitems; i++)
+		nl_object_put(snap->cs_objs[i]);
+
+	free(snap->cs_objs);
+	free(snap);
+}
+
+/**
+ * Return number of objects in snapshot
+ * @arg snap		Snapshot
+ */
+int nl_cache_snapshot_nitems(const struct nl_cache_snapshot *snap)
+{
+	return snap->cs_nitems;
+}
+
+/**
+ * Return object of snapshot
+ * @arg snap		Snapshot
+ * @arg i		Position, starting at 0
+ *
+ * Objects are ordered as they were in the cache. No reference is
+ * acquired, the object stays valid as long as the snapshot.
+ *
+ * @return Object or NULL if \p i is out of range.
+ */
+struct nl_object *nl_cache_snapshot_get(const struct nl_cache_snapshot *snap,
+					int i)
+{
+	if (i < 0 || i >= snap->cs_nitems)
+		return NULL;
+
+	return snap->cs_objs[i];
+}
+
+/**
+ * Compare two snapshots of a cache
+ * @arg old		Earlier snapshot
+ * @arg new		Later snapshot
+ * @arg cb		Callback function invoked for each difference
+ * @arg arg		Argument passed to callback function
+ *
+ * Matches the objects of both snapshots by identity and invokes \p cb
+ * for every object added, with a NULL old object, removed, with a NULL
+ * new object, or changed, with both. Objects shared by both snapshots
+ * are unchanged and skipped without comparing them, the cost is thus
+ * dominated by the hash lookups.
+ *
+ * The object type must support hashing.
+ *
+ * @return Number of differences or a negative error code.
+ * @retval -NLE_OBJ_MISMATCH Snapshots of different cache types
+ * @retval -NLE_OPNOTSUPP Object type does not support hashing
+ */
+int nl_cache_snapshot_diff(struct nl_cache_snapshot *old,
+			   struct nl_cache_snapshot *new,
+			   void (*cb)(struct nl_object *, struct nl_object *,
+				      void *),
+			   void *arg)
+{
+	nl_hash_table_t *ht;
+	struct nl_object *a, *b;
+	int i, err, ndiff = 0;
+
+	if (old->cs_ops != new->cs_ops)
+		return -NLE_OBJ_MISMATCH;
+
+	if (!old->cs_ops->co_obj_ops->oo_keygen)
+		return -NLE_OPNOTSUPP;
+
+	ht = nl_hash_table_alloc_flags(old->cs_nitems, NL_HASH_TABLE_OPEN);
+	if (!ht)
+		return -NLE_NOMEM;
+
+	for (i = 0; i < old->cs_nitems; i++) {
+		err = nl_hash_table_add(ht, old->cs_objs[i]);
+		if (err < 0 && err != -NLE_EXIST)
+			goto errout;
+	}
+
+	for (i = 0; i < new->cs_nitems; i++) {
+		b = new->cs_objs[i];
+		a = nl_hash_table_lookup(ht, b);
+
+		if (!a) {
+			cb(NULL, b, arg);
+			ndiff++;
+			continue;
+		}
+
+		if (a != b && nl_object_diff64(a, b)) {
+			cb(a, b, arg);
+			ndiff++;
+		}
+
+		/* whatever remains has been removed */
+		nl_hash_table_del(ht, a);
+	}
+
+	for (i = 0; i < old->cs_nitems; i++) {
+		a = old->cs_objs[i];
+		if (nl_hash_table_lookup(ht, a) == a) {
+			cb(a, NULL, arg);
+			ndiff++;
+		}
+	}
+
+	err = ndiff;
+errout:
+	nl_hash_table_free(ht);
+	return err;
+}
+
 /** @} */
 
 /**
  * @name Utillities
  * @{
  */
+static struct nl_object *cache_lookup_concurrent(struct nl_cache *cache,
+						 struct nl_object *needle)
+{
+	struct nl_object *obj;
+	unsigned int seq;
+
+	if (__nl_epoch_enter() < 0)
+		return NULL;
+
+	/* A miss is only trusted if the cache was not modified meanwhile,
+	 * an object being replaced may be missing temporarily. */
+	do {
+		seq = _nl_cache_read_begin(cache);
+		obj = nl_hash_table_lookup(cache->hashtable, needle);
+		if (obj) {
+			nl_object_get(obj);
+			break;
+		}
+	} while (_nl_cache_read_retry(cache, seq));
+
+	__nl_epoch_exit();
+
+	return obj;
+}
+
 static struct nl_object *__cache_fast_lookup(struct nl_cache *cache,
 					     struct nl_object *needle)
 {
 	struct nl_object *obj;
 
+	if (_nl_cache_is_concurrent(cache))
+		return cache_lookup_concurrent(cache, needle);
+
 	obj = nl_hash_table_lookup(cache->hashtable, needle);
 	if (obj) {
 		nl_object_get(obj);
@@ -42,6 +42,34 @@
 /** @cond SKIP */
 #define NASSOC_INIT		16
 #define NASSOC_EXPAND		8
+
+/* Update of an object held back by the coalescing window */
+struct nl_cache_pending
+{
+	struct nl_cache_pending *cp_next;
+	struct nl_list_head	cp_list;
+	struct nl_object *	cp_obj;
+	struct nl_msgtype *	cp_msgtype;
+	uint64_t		cp_merged;
+	uint64_t		cp_deadline;
+	int			cp_assoc;
+};
+
+/* Parser argument of coalesce_cb() */
+struct mngr_coalesce
+{
+	struct nl_cache_mngr *	mc_mngr;
+	int			mc_assoc;
+};
+
+static uint64_t mngr_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 /** @endcond */
 
 static int include_cb(struct nl_object *obj, struct nl_parser_param *p)
@@ -63,6 +91,13 @@ static int include_cb(struct nl_object *obj, struct nl_parser_param *p)
 		return ops->co_include_event(ca->ca_cache, obj, ca->ca_change,
 					     ca->ca_change_v2,
 					     ca->ca_change_data);
+	else if (p->pp_msgtype && p->pp_msgtype->mt_id == obj->ce_msgtype)
+		return _nl_cache_include_msgtype(ca->ca_cache, obj,
+						 p->pp_msgtype, 0,
+						 ca->ca_change_v2 ? NULL :
+						 ca->ca_change,
+						 ca->ca_change_v2,
+						 ca->ca_change_data);
 	else {
 		if (ca->ca_change_v2)
 			return nl_cache_include_v2(ca->ca_cache, obj, ca->ca_change_v2, ca->ca_change_data);
@@ -72,13 +107,385 @@ static int include_cb(struct nl_object *obj, struct nl_parser_param *p)
 
 }
 
+/** @cond SKIP */
+/*
+ * Coalescing of updates
+ *
+ * With a coalescing window set, the first update of an object is held
+ * back for the duration of the window. Further updates of the object
+ * received meanwhile replace it, the changes between them are merged,
+ * and the last one is included into the cache once the window expired.
+ * Held back updates are kept in a list in the order their windows
+ * expire and in a hash table by object identity.
+ */
+static int mngr_coalesces(struct nl_cache_mngr *mngr, struct nl_cache *cache)
+{
+	struct nl_cache_ops *ops = cache->c_ops;
+
+	/* Types merging updates into the cached object see every update */
+	return mngr->cm_coalesce_msec && !ops->co_include_event &&
+	       ops->co_obj_ops->oo_keygen && !ops->co_obj_ops->oo_update;
+}
+
+static struct nl_cache_pending **pending_slot(struct nl_cache_mngr *mngr,
+					      struct nl_object *obj, int assoc)
+{
+	struct nl_cache_pending **pp;
+
+	pp = &mngr->cm_pending[_nl_object_hash(obj) &
+			       (mngr->cm_pending_size - 1)];
+	for (; *pp; pp = &(*pp)->cp_next)
+		if ((*pp)->cp_assoc == assoc &&
+		    nl_object_identical((*pp)->cp_obj, obj))
+			break;
+
+	return pp;
+}
+
+static int pending_grow(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache_pending **tab, *cp;
+	unsigned int size = mngr->cm_pending_size ?
+			    mngr->cm_pending_size * 2 : 64;
+
+	if (!(tab = calloc(size, sizeof(*tab))))
+		return -NLE_NOMEM;
+
+	free(mngr->cm_pending);
+	mngr->cm_pending = tab;
+	mngr->cm_pending_size = size;
+
+	nl_list_for_each_entry(cp, &mngr->cm_pending_list, cp_list) {
+		struct nl_cache_pending **pp;
+
+		pp = &tab[_nl_object_hash(cp->cp_obj) & (size - 1)];
+		cp->cp_next = *pp;
+		*pp = cp;
+	}
+
+	return 0;
+}
+
+static int coalesce_cb(struct nl_object *obj, struct nl_parser_param *p)
+{
+	struct mngr_coalesce *mc = p->pp_arg;
+	struct nl_cache_mngr *mngr = mc->mc_mngr;
+	struct nl_cache_assoc *ca = &mngr->cm_assocs[mc->mc_assoc];
+	struct nl_cache_ops *ops = ca->ca_cache->c_ops;
+	struct nl_msgtype *mt = p->pp_msgtype;
+	struct nl_parser_param q = *p;
+	struct nl_cache_pending *cp, **pp;
+
+	if (!mt || mt->mt_id != obj->ce_msgtype)
+		goto include;
+
+	if (ops->co_event_filter &&
+	    ops->co_event_filter(ca->ca_cache, obj) != NL_OK)
+		return 0;
+
+	/*
+	 * A held back update is always replaced, including this one right
+	 * away would have the older update applied after it.
+	 */
+	if (mngr->cm_pending_size &&
+	    (cp = *(pp = pending_slot(mngr, obj, mc->mc_assoc)))) {
+		if (cp->cp_msgtype->mt_act == NL_ACT_NEW &&
+		    mt->mt_act == NL_ACT_NEW)
+			cp->cp_merged |= nl_object_diff64(cp->cp_obj, obj);
+
+		NL_DBG(3, "Cache manager %p, coalescing %p into %p\n",
+		       mngr, obj, cp->cp_obj);
+
+		nl_object_put(cp->cp_obj);
+		nl_object_get(obj);
+		cp->cp_obj = obj;
+		cp->cp_msgtype = mt;
+		return 0;
+	}
+
+	if (mngr->cm_npending >= mngr->cm_pending_size &&
+	    pending_grow(mngr) < 0)
+		goto include;
+
+	if (!(cp = calloc(1, sizeof(*cp))))
+		goto include;
+
+	pp = pending_slot(mngr, obj, mc->mc_assoc);
+
+	nl_object_get(obj);
+	cp->cp_obj = obj;
+	cp->cp_msgtype = mt;
+	cp->cp_assoc = mc->mc_assoc;
+	cp->cp_deadline = mngr_usec() + mngr->cm_coalesce_msec * 1000ULL;
+	*pp = cp;
+	nl_list_add_tail(&cp->cp_list, &mngr->cm_pending_list);
+	mngr->cm_npending++;
+
+	return 0;
+
+include:
+	q.pp_arg = ca;
+	return include_cb(obj, &q);
+}
+
+/* Includes held back updates whose window expired, or all if @all is set.
+ * Returns the number of updates included. */
+static int mngr_flush(struct nl_cache_mngr *mngr, int all)
+{
+	struct nl_cache_pending *cp, **pp;
+	struct nl_cache_assoc *ca;
+	uint64_t now = all ? 0 : mngr_usec();
+	int n = 0;
+
+	while (!nl_list_empty(&mngr->cm_pending_list)) {
+		cp = nl_list_first_entry(&mngr->cm_pending_list,
+					 struct nl_cache_pending, cp_list);
+		if (!all && cp->cp_deadline > now)
+			break;
+
+		pp = &mngr->cm_pending[_nl_object_hash(cp->cp_obj) &
+				       (mngr->cm_pending_size - 1)];
+		while (*pp != cp)
+			pp = &(*pp)->cp_next;
+		*pp = cp->cp_next;
+		nl_list_del(&cp->cp_list);
+		mngr->cm_npending--;
+
+		ca = &mngr->cm_assocs[cp->cp_assoc];
+		_nl_cache_include_msgtype(ca->ca_cache, cp->cp_obj,
+					  cp->cp_msgtype, cp->cp_merged,
+					  ca->ca_change_v2 ? NULL : ca->ca_change,
+					  ca->ca_change_v2, ca->ca_change_data);
+
+		nl_object_put(cp->cp_obj);
+		free(cp);
+		n++;
+	}
+
+	return n;
+}
+
+/*
+ * Worker threads
+ *
+ * With workers set, the thread receiving notifications only looks up the
+ * cache handling each message and copies the message onto the ring of
+ * the worker the cache is assigned to. The worker parses the message,
+ * includes the object and calls the change callbacks. Every cache is
+ * modified by a single worker, in the order the notifications arrived.
+ *
+ * A ring has a single producer, the receiving thread, and a single
+ * consumer, its worker. The worker advances cw_head only after it
+ * applied an event, the receiving thread therefore knows the caches of
+ * a worker are idle once cw_head reached cw_tail. Either side sleeps on
+ * cw_cond and announces it in cw_idle or cw_waiting for the other side
+ * to wake it.
+ */
+#ifndef DISABLE_PTHREADS
+#define WORKER_RING_SIZE	1024
+
+/* Notification copied out of the receive buffer */
+struct mngr_event
+{
+	struct nl_msgtype *	ev_msgtype;
+	int			ev_assoc;
+	struct nlmsghdr		ev_hdr[];
+};
+
+struct nl_cache_worker
+{
+	struct nl_cache_mngr *	cw_mngr;
+	pthread_t		cw_thread;
+	pthread_mutex_t		cw_lock;
+	pthread_cond_t		cw_cond;
+	unsigned int		cw_head;
+	unsigned int		cw_tail;
+	int			cw_idle;
+	int			cw_waiting;
+	int			cw_stop;
+	struct mngr_event *	cw_ring[WORKER_RING_SIZE];
+};
+
+static void worker_wakeup(struct nl_cache_worker *cw, int *flag)
+{
+	if (__atomic_load_n(flag, __ATOMIC_SEQ_CST)) {
+		nl_lock(&cw->cw_lock);
+		pthread_cond_broadcast(&cw->cw_cond);
+		nl_unlock(&cw->cw_lock);
+	}
+}
+
+static void worker_apply(struct nl_cache_mngr *mngr, struct mngr_event *ev)
+{
+	struct nl_cache_assoc *ca = &mngr->cm_assocs[ev->ev_assoc];
+	struct nl_parser_param p = {
+		.pp_cb = include_cb,
+		.pp_arg = ca,
+		.pp_flags = ca->ca_cache->c_flags,
+	};
+	int err;
+
+	err = _nl_cache_parse_msgtype(ca->ca_cache->c_ops, ev->ev_msgtype,
+				      NULL, ev->ev_hdr, &p);
+	if (err < 0)
+		NL_DBG(1, "Cache manager %p, event for cache %p failed: %s\n",
+		       mngr, ca->ca_cache, nl_geterror(err));
+}
+
+static void *worker_thread(void *arg)
+{
+	struct nl_cache_worker *cw = arg;
+	unsigned int head = cw->cw_head;
+	struct mngr_event *ev;
+	int stop;
+
+	for (;;) {
+		if (head == __atomic_load_n(&cw->cw_tail, __ATOMIC_ACQUIRE)) {
+			nl_lock(&cw->cw_lock);
+			__atomic_store_n(&cw->cw_idle, 1, __ATOMIC_SEQ_CST);
+			while (head == __atomic_load_n(&cw->cw_tail,
+						       __ATOMIC_SEQ_CST) &&
+			       !cw->cw_stop)
+				pthread_cond_wait(&cw->cw_cond, &cw->cw_lock);
+			__atomic_store_n(&cw->cw_idle, 0, __ATOMIC_RELAXED);
+			stop = cw->cw_stop;
+			nl_unlock(&cw->cw_lock);
+
+			if (stop)
+				break;
+			continue;
+		}
+
+		ev = cw->cw_ring[head % WORKER_RING_SIZE];
+		worker_apply(cw->cw_mngr, ev);
+		free(ev);
+
+		__atomic_store_n(&cw->cw_head, ++head, __ATOMIC_SEQ_CST);
+		worker_wakeup(cw, &cw->cw_waiting);
+	}
+
+	return NULL;
+}
+
+/* Waits until no more than @max events are queued on the worker */
+static void worker_wait(struct nl_cache_worker *cw, unsigned int max)
+{
+	if (cw->cw_tail - __atomic_load_n(&cw->cw_head, __ATOMIC_ACQUIRE) <= max)
+		return;
+
+	nl_lock(&cw->cw_lock);
+	__atomic_store_n(&cw->cw_waiting, 1, __ATOMIC_SEQ_CST);
+	while (cw->cw_tail - __atomic_load_n(&cw->cw_head,
+					     __ATOMIC_SEQ_CST) > max)
+		pthread_cond_wait(&cw->cw_cond, &cw->cw_lock);
+	__atomic_store_n(&cw->cw_waiting, 0, __ATOMIC_RELAXED);
+	nl_unlock(&cw->cw_lock);
+}
+
+static int mngr_dispatch(struct nl_cache_mngr *mngr,
+			 struct nl_cache_dispatch *cd, struct nlmsghdr *nlh)
+{
+	struct nl_cache_worker *cw;
+	struct mngr_event *ev;
+
+	if (!(ev = malloc(sizeof(*ev) + nlh->nlmsg_len)))
+		return -NLE_NOMEM;
+
+	ev->ev_msgtype = cd->cd_msgtype;
+	ev->ev_assoc = cd->cd_assoc;
+	memcpy(ev->ev_hdr, nlh, nlh->nlmsg_len);
+
+	cw = &mngr->cm_workers[cd->cd_assoc % mngr->cm_nworkers];
+
+	/* A full ring blocks reading until the worker caught up */
+	worker_wait(cw, WORKER_RING_SIZE - 1);
+
+	cw->cw_ring[cw->cw_tail % WORKER_RING_SIZE] = ev;
+	__atomic_store_n(&cw->cw_tail, cw->cw_tail + 1, __ATOMIC_SEQ_CST);
+	worker_wakeup(cw, &cw->cw_idle);
+
+	return 0;
+}
+
+/*
+ * Parsers look up caches provided with nl_cache_mngt_provide(), e.g.
+ * addresses look up their link. A provided cache is therefore read by
+ * other workers while its own worker updates it.
+ */
+static void mngr_share_provided(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache *cache;
+	int i;
+
+	for (i = 0; i < mngr->cm_nassocs; i++) {
+		cache = mngr->cm_assocs[i].ca_cache;
+		if (cache && cache->c_ops->co_major_cache == cache)
+			nl_cache_set_flags(cache, NL_CACHE_CONCURRENT);
+	}
+}
+
+/* Waits until the workers applied all events dispatched to them */
+static void mngr_quiesce(struct nl_cache_mngr *mngr)
+{
+	int i;
+
+	for (i = 0; i < mngr->cm_nworkers; i++)
+		worker_wait(&mngr->cm_workers[i], 0);
+}
+
+static void mngr_stop_workers(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache_worker *cw;
+	int i;
+
+	mngr_quiesce(mngr);
+
+	for (i = 0; i < mngr->cm_nworkers; i++) {
+		cw = &mngr->cm_workers[i];
+
+		nl_lock(&cw->cw_lock);
+		cw->cw_stop = 1;
+		pthread_cond_broadcast(&cw->cw_cond);
+		nl_unlock(&cw->cw_lock);
+
+		pthread_join(cw->cw_thread, NULL);
+		pthread_cond_destroy(&cw->cw_cond);
+		pthread_mutex_destroy(&cw->cw_lock);
+	}
+
+	free(mngr->cm_workers);
+	mngr->cm_workers = NULL;
+	mngr->cm_nworkers = 0;
+}
+#else
+static void mngr_share_provided(struct nl_cache_mngr *mngr)
+{
+}
+
+static int mngr_dispatch(struct nl_cache_mngr *mngr,
+			 struct nl_cache_dispatch *cd, struct nlmsghdr *nlh)
+{
+	return -NLE_OPNOTSUPP;
+}
+
+static void mngr_quiesce(struct nl_cache_mngr *mngr)
+{
+}
+
+static void mngr_stop_workers(struct nl_cache_mngr *mngr)
+{
+}
+#endif
+/** @endcond */
+
 static int event_input(struct nl_msg *msg, void *arg)
 {
 	struct nl_cache_mngr *mngr = arg;
 	int protocol = nlmsg_get_proto(msg);
 	int type = nlmsg_hdr(msg)->nlmsg_type;
-	struct nl_cache_ops *ops;
-	int i, n;
+	struct nl_cache_dispatch *cd;
+	struct nl_cache_assoc *ca;
+	struct mngr_coalesce mc;
 	struct nl_parser_param p = {
 		.pp_cb = include_cb,
 	};
@@ -93,23 +500,76 @@ static int event_input(struct nl_msg *msg, void *arg)
 	if (mngr->cm_protocol != protocol)
 		BUG();
 
+	if (type >= mngr->cm_ndispatch ||
+	    !(cd = &mngr->cm_dispatch[type])->cd_msgtype)
+		return NL_SKIP;
+
+	ca = &mngr->cm_assocs[cd->cd_assoc];
+
+	NL_DBG(2, "Associated message %p to cache %p\n", msg, ca->ca_cache);
+
+	if (mngr->cm_nworkers)
+		return mngr_dispatch(mngr, cd, nlmsg_hdr(msg));
+
+	p.pp_arg = ca;
+	p.pp_flags = ca->ca_cache->c_flags;
+
+	if (mngr_coalesces(mngr, ca->ca_cache)) {
+		mc.mc_mngr = mngr;
+		mc.mc_assoc = cd->cd_assoc;
+		p.pp_cb = coalesce_cb;
+		p.pp_arg = &mc;
+	}
+
+	return _nl_cache_parse_msgtype(ca->ca_cache->c_ops, cd->cd_msgtype,
+				       NULL, nlmsg_hdr(msg), &p);
+}
+
+/*
+ * Rebuilds the table mapping message types to the cache associations
+ * handling them. The first association listing a type handles it.
+ */
+static int mngr_update_dispatch(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache_dispatch *dispatch;
+	struct nl_cache_ops *ops;
+	int i, n, ndispatch = 0;
+
 	for (i = 0; i < mngr->cm_nassocs; i++) {
-		if (mngr->cm_assocs[i].ca_cache) {
-			ops = mngr->cm_assocs[i].ca_cache->c_ops;
-			for (n = 0; ops->co_msgtypes[n].mt_id >= 0; n++)
-				if (ops->co_msgtypes[n].mt_id == type)
-					goto found;
-		}
+		if (!mngr->cm_assocs[i].ca_cache)
+			continue;
+
+		ops = mngr->cm_assocs[i].ca_cache->c_ops;
+		for (n = 0; ops->co_msgtypes[n].mt_id >= 0; n++)
+			if (ops->co_msgtypes[n].mt_id >= ndispatch)
+				ndispatch = ops->co_msgtypes[n].mt_id + 1;
 	}
 
-	return NL_SKIP;
+	dispatch = calloc(ndispatch ? ndispatch : 1, sizeof(*dispatch));
+	if (!dispatch)
+		return -NLE_NOMEM;
 
-found:
-	NL_DBG(2, "Associated message %p to cache %p\n",
-	       msg, mngr->cm_assocs[i].ca_cache);
-	p.pp_arg = &mngr->cm_assocs[i];
+	for (i = 0; i < mngr->cm_nassocs; i++) {
+		if (!mngr->cm_assocs[i].ca_cache)
+			continue;
+
+		ops = mngr->cm_assocs[i].ca_cache->c_ops;
+		for (n = 0; ops->co_msgtypes[n].mt_id >= 0; n++) {
+			struct nl_cache_dispatch *cd;
+
+			cd = &dispatch[ops->co_msgtypes[n].mt_id];
+			if (!cd->cd_msgtype) {
+				cd->cd_msgtype = &ops->co_msgtypes[n];
+				cd->cd_assoc = i;
+			}
+		}
+	}
+
+	free(mngr->cm_dispatch);
+	mngr->cm_dispatch = dispatch;
+	mngr->cm_ndispatch = ndispatch;
 
-	return nl_cache_parse(ops, NULL, nlmsg_hdr(msg), &p);
+	return 0;
 }
 
 /**
@@ -154,6 +614,8 @@ int nl_cache_mngr_alloc(struct nl_sock *sk, int protocol, int flags,
 	if (!mngr)
 		return -NLE_NOMEM;
 
+	nl_init_list_head(&mngr->cm_pending_list);
+
 	if (!sk) {
 		if (!(sk = nl_socket_alloc()))
 			goto errout;
@@ -188,6 +650,12 @@ int nl_cache_mngr_alloc(struct nl_sock *sk, int protocol, int flags,
 	if ((err = nl_connect(mngr->cm_sync_sock, protocol)) < 0)
 		goto errout_free_sync_sock;
 
+	/* Messages are only handed to the cache parsers, there is no need
+	 * to copy them out of the receive buffer. */
+	nl_socket_enable_zero_copy(mngr->cm_sync_sock);
+	if (flags & NL_ALLOCATED_SOCK)
+		nl_socket_enable_zero_copy(mngr->cm_sock);
+
 	NL_DBG(1, "Allocated cache manager %p, protocol %d, %d caches\n",
 	       mngr, protocol, mngr->cm_nassocs);
 
@@ -259,6 +727,7 @@ static int nl_cache_mngr_set_change_func_v2(struct nl_cache_mngr *mngr,
 		return -NLE_RANGE;
 	}
 
+	mngr_quiesce(mngr);
 	mngr->cm_assocs[i].ca_change_v2 = cb;
 	mngr->cm_assocs[i].ca_change_data = data;
 
@@ -289,6 +758,8 @@ static int nl_cache_mngr_set_change_func_v2(struct nl_cache_mngr *mngr,
  * 			       cache type
  * @return -NLE_OPNOTSUPP Cache type does not support updates
  * @return -NLE_EXIST Cache of this type already being managed
+ * @return -NLE_INVAL Cache with \c NL_CACHE_LAZY_PARSE set would be
+ *		      provided to workers, see nl_cache_mngr_set_workers()
  */
 int nl_cache_mngr_add_cache(struct nl_cache_mngr *mngr, struct nl_cache *cache,
 		      change_func_t cb, void *data)
@@ -312,6 +783,14 @@ int nl_cache_mngr_add_cache(struct nl_cache_mngr *mngr, struct nl_cache *cache,
 		    mngr->cm_assocs[i].ca_cache->c_ops == ops)
 			return -NLE_EXIST;
 
+	/* A provided cache is read by all workers, see mngr_share_provided() */
+	if (mngr->cm_nworkers && (cache->c_flags & NL_CACHE_LAZY_PARSE) &&
+	    ((mngr->cm_flags & NL_AUTO_PROVIDE) || ops->co_major_cache == cache))
+		return -NLE_INVAL;
+
+	/* Workers must not access the associations while they change */
+	mngr_quiesce(mngr);
+
 	for (i = 0; i < mngr->cm_nassocs; i++)
 		if (!mngr->cm_assocs[i].ca_cache)
 			break;
@@ -348,9 +827,17 @@ int nl_cache_mngr_add_cache(struct nl_cache_mngr *mngr, struct nl_cache *cache,
 	mngr->cm_assocs[i].ca_change = cb;
 	mngr->cm_assocs[i].ca_change_data = data;
 
+	if ((err = mngr_update_dispatch(mngr)) < 0) {
+		memset(&mngr->cm_assocs[i], 0, sizeof(mngr->cm_assocs[i]));
+		goto errout_drop_membership;
+	}
+
 	if (mngr->cm_flags & NL_AUTO_PROVIDE)
 		nl_cache_mngt_provide(cache);
 
+	if (mngr->cm_nworkers)
+		mngr_share_provided(mngr);
+
 	NL_DBG(1, "Added cache %p <%s> to cache manager %p\n",
 	       cache, nl_cache_name(cache), mngr);
 
@@ -494,12 +981,18 @@ int nl_cache_mngr_get_fd(struct nl_cache_mngr *mngr)
  */
 int nl_cache_mngr_poll(struct nl_cache_mngr *mngr, int timeout)
 {
-	int ret;
+	int ret, wait;
 	struct pollfd fds = {
 		.fd = nl_socket_get_fd(mngr->cm_sock),
 		.events = POLLIN,
 	};
 
+	/* Do not wait for new events longer than held back updates or
+	 * caches which lost updates have to */
+	wait = nl_cache_mngr_get_timeout(mngr);
+	if (wait >= 0 && (timeout < 0 || wait < timeout))
+		timeout = wait;
+
 	NL_DBG(3, "Cache manager %p, poll() fd %d\n", mngr, fds.fd);
 	ret = poll(&fds, 1, timeout);
 	NL_DBG(3, "Cache manager %p, poll() returned %d\n", mngr, ret);
@@ -509,13 +1002,120 @@ int nl_cache_mngr_poll(struct nl_cache_mngr *mngr, int timeout)
 		return -nl_syserr2nlerr(errno);
 	}
 
-	/* No events, return */
-	if (ret == 0)
+	/* No events, deliver held back updates which are due */
+	if (ret == 0 && !mngr->cm_recover_pending) {
+		mngr_flush(mngr, 0);
 		return 0;
+	}
 
 	return nl_cache_mngr_data_ready(mngr);
 }
 
+/** @cond SKIP */
+/* Doubles the receive buffer of the notification socket, up to the limit */
+static void mngr_grow_rxbuf(struct nl_cache_mngr *mngr)
+{
+	socklen_t len = sizeof(int);
+	int rxbuf;
+
+	if (!mngr->cm_rxbuf) {
+		if (getsockopt(nl_socket_get_fd(mngr->cm_sock), SOL_SOCKET,
+			       SO_RCVBUF, &rxbuf, &len) < 0)
+			return;
+
+		/* the kernel reports twice the size set */
+		mngr->cm_rxbuf = rxbuf / 2;
+	}
+
+	if (mngr->cm_rxbuf >= mngr->cm_rxbuf_max)
+		return;
+
+	rxbuf = mngr->cm_rxbuf < mngr->cm_rxbuf_max / 2 ?
+		mngr->cm_rxbuf * 2 : mngr->cm_rxbuf_max;
+
+	if (nl_socket_set_buffer_size(mngr->cm_sock, rxbuf, 0) < 0)
+		return;
+
+	NL_DBG(1, "Cache manager %p, increased receive buffer to %d\n",
+	       mngr, rxbuf);
+
+	mngr->cm_rxbuf = rxbuf;
+	mngr->cm_recovery.rv_rxbuf = rxbuf;
+}
+
+static int drain_input(struct nl_msg *msg, void *arg)
+{
+	return NL_SKIP;
+}
+
+/* Drops all queued notifications, they predate the following resync */
+static void mngr_drain(struct nl_cache_mngr *mngr)
+{
+	struct nl_cb *cb;
+	int err;
+
+	if (!(cb = nl_cb_clone(mngr->cm_sock->s_cb)))
+		return;
+
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, drain_input, NULL);
+
+	do {
+		err = nl_recvmsgs_report(mngr->cm_sock, cb);
+	} while (err > 0 || err == -NLE_NOMEM || err == -NLE_MSG_OVERFLOW ||
+		 err == -NLE_MSG_TRUNC);
+
+	nl_cb_put(cb);
+}
+
+/*
+ * Notifications were lost, every cache may have missed updates and is
+ * resynced over the synchronization socket. Notifications arriving in
+ * the meantime remain queued on the notification socket.
+ */
+static int mngr_recover(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache_mngr_recovery_stats *stats = &mngr->cm_recovery;
+	uint64_t start = mngr_usec();
+	int i, err, ret = 0;
+
+	mngr->cm_recover_pending = 0;
+
+	/* Updates dispatched to workers or held back predate the resync */
+	mngr_quiesce(mngr);
+	mngr_flush(mngr, 1);
+
+	mngr_grow_rxbuf(mngr);
+	mngr_drain(mngr);
+
+	for (i = 0; i < mngr->cm_nassocs; i++) {
+		if (!mngr->cm_assocs[i].ca_cache)
+			continue;
+
+		err = _nl_cache_resync_assoc(mngr->cm_sync_sock,
+					     &mngr->cm_assocs[i]);
+		if (err < 0) {
+			NL_DBG(1, "Cache manager %p, resync of cache %p "
+				  "failed: %s\n", mngr,
+			       mngr->cm_assocs[i].ca_cache, nl_geterror(err));
+			mngr->cm_recover_pending = 1;
+			stats->rv_failures++;
+			ret = err;
+		} else
+			stats->rv_resyncs++;
+	}
+
+	stats->rv_last_usec = mngr_usec() - start;
+	stats->rv_total_usec += stats->rv_last_usec;
+	if (stats->rv_last_usec > stats->rv_max_usec)
+		stats->rv_max_usec = stats->rv_last_usec;
+
+	NL_DBG(1, "Cache manager %p, recovered in %" PRIu64 "us\n",
+	       mngr, stats->rv_last_usec);
+
+	return ret;
+}
+/** @endcond */
+
 /**
  * Receive available event notifications
  * @arg mngr		Cache manager
@@ -527,37 +1127,299 @@ int nl_cache_mngr_poll(struct nl_cache_mngr *mngr, int timeout)
  * The function will process messages until there is no more data to
  * be read from the socket.
  *
+ * If notifications were lost because the receive buffer of the socket
+ * overflowed or a notification did not fit into the message buffer (see
+ * nl_socket_set_msg_buf_size()), the notifications still queued are
+ * dropped, all caches of the manager are resynced with the kernel using
+ * nl_cache_resync(), calling the change callbacks for every difference
+ * found, and the receive buffer is enlarged up to the limit set with
+ * nl_cache_mngr_set_rxbuf_max(). Losing notifications again
+ * while reading the ones queued meanwhile defers the next recovery to
+ * the following call. Recoveries are counted and timed, see
+ * nl_cache_mngr_get_recovery_stats().
+ *
+ * With workers set, the messages are passed on to the workers and may
+ * not have been applied yet on return, see nl_cache_mngr_set_workers().
+ *
  * @see nl_cache_mngr_poll()
  *
  * @return The number of messages processed or a negative error code.
  */
 int nl_cache_mngr_data_ready(struct nl_cache_mngr *mngr)
 {
-	int err, nread = 0;
+	int err, nread = 0, recovered = 0;
 	struct nl_cb *cb;
 
 	NL_DBG(2, "Cache manager %p, reading new data from fd %d\n",
 	       mngr, nl_socket_get_fd(mngr->cm_sock));
 
+	if (mngr->cm_recover_pending) {
+		if ((err = mngr_recover(mngr)) < 0)
+			return err;
+		recovered = 1;
+	}
+
 	cb = nl_cb_clone(mngr->cm_sock->s_cb);
 	if (cb == NULL)
 		return -NLE_NOMEM;
 
 	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, event_input, mngr);
 
-	while ((err = nl_recvmsgs_report(mngr->cm_sock, cb)) > 0) {
-		NL_DBG(2, "Cache manager %p, recvmsgs read %d messages\n",
-		       mngr, err);
-		nread += err;
+	for (;;) {
+		while ((err = nl_recvmsgs_report(mngr->cm_sock, cb)) > 0) {
+			NL_DBG(2, "Cache manager %p, recvmsgs read %d "
+				  "messages\n", mngr, err);
+			nread += err;
+		}
+
+		/* ENOBUFS is reported as -NLE_NOMEM. A message dropped for
+		 * a lack of memory or truncated is recovered from the same
+		 * way. */
+		if (err != -NLE_NOMEM && err != -NLE_MSG_OVERFLOW &&
+		    err != -NLE_MSG_TRUNC)
+			break;
+
+		NL_DBG(1, "Cache manager %p, notifications lost\n", mngr);
+		mngr->cm_recovery.rv_overruns++;
+
+		if (recovered) {
+			mngr->cm_recover_pending = 1;
+			err = 0;
+			break;
+		}
+
+		if ((err = mngr_recover(mngr)) < 0)
+			break;
+		recovered = 1;
 	}
 
 	nl_cb_put(cb);
 	if (err < 0 && err != -NLE_AGAIN)
 		return err;
 
+	mngr_flush(mngr, 0);
+
 	return nread;
 }
 
+/**
+ * Set limit of the receive buffer size of a cache manager
+ * @arg mngr		Cache manager
+ * @arg rxbuf		Receive buffer size limit in bytes
+ *
+ * Each time notifications are lost, the receive buffer of the socket of
+ * the cache manager is doubled, using nl_socket_set_buffer_size(), until
+ * it reaches \c rxbuf. The buffer is not enlarged by default.
+ *
+ * @return 0 on success or a negative error code.
+ */
+int nl_cache_mngr_set_rxbuf_max(struct nl_cache_mngr *mngr, int rxbuf)
+{
+	if (rxbuf < 0)
+		return -NLE_INVAL;
+
+	mngr->cm_rxbuf_max = rxbuf;
+
+	return 0;
+}
+
+/**
+ * Retrieve statistics of recoveries from lost notifications
+ * @arg mngr		Cache manager
+ * @arg stats		Statistics to fill out
+ *
+ * @see nl_cache_mngr_data_ready()
+ */
+void nl_cache_mngr_get_recovery_stats(struct nl_cache_mngr *mngr,
+				      struct nl_cache_mngr_recovery_stats *stats)
+{
+	*stats = mngr->cm_recovery;
+}
+
+/**
+ * Set coalescing window of a cache manager
+ * @arg mngr		Cache manager
+ * @arg msec		Window in milliseconds or 0 to disable coalescing
+ *
+ * With a window set, an update of an object received as event
+ * notification is held back for \c msec milliseconds. Updates of the
+ * same object received in the meantime replace it. Once the window
+ * expired, the last update is included into the cache and the change
+ * callback is invoked once. A change callback registered with
+ * nl_cache_mngr_add_cache_v2() is passed the changes of all coalesced
+ * updates in its diff argument. An object added and deleted again
+ * within the window is not reported at all.
+ *
+ * Held back updates are delivered by nl_cache_mngr_poll() and
+ * nl_cache_mngr_data_ready(). Applications calling the latter from
+ * their own event loop must also call it once the time returned by
+ * nl_cache_mngr_get_timeout() passed. Coalescing reorders updates of
+ * different objects. Object types merging updates into the cached
+ * object, such as routes, are never coalesced.
+ *
+ * Disabling coalescing delivers all held back updates.
+ *
+ * @return 0 on success or a negative error code.
+ * @return -NLE_OPNOTSUPP Workers are set, see nl_cache_mngr_set_workers()
+ */
+int nl_cache_mngr_set_coalesce(struct nl_cache_mngr *mngr, int msec)
+{
+	if (msec < 0)
+		return -NLE_INVAL;
+
+	if (msec && mngr->cm_nworkers)
+		return -NLE_OPNOTSUPP;
+
+	mngr->cm_coalesce_msec = msec;
+	if (!msec)
+		mngr_flush(mngr, 1);
+
+	return 0;
+}
+
+/**
+ * Deliver all updates held back by a cache manager
+ * @arg mngr		Cache manager
+ *
+ * Includes all updates held back by the coalescing window into their
+ * caches immediately. With workers set, waits until they applied all
+ * notifications received.
+ *
+ * @see nl_cache_mngr_set_coalesce()
+ *
+ * @return Number of updates delivered.
+ */
+int nl_cache_mngr_flush(struct nl_cache_mngr *mngr)
+{
+	mngr_quiesce(mngr);
+
+	return mngr_flush(mngr, 1);
+}
+
+/**
+ * Return time until a cache manager has updates to deliver
+ * @arg mngr		Cache manager
+ *
+ * Returns the time until the coalescing window of the first held back
+ * update expires, or 0 if caches have to be resynced after notifications
+ * were lost, see nl_cache_mngr_data_ready().
+ *
+ * @return Time in milliseconds or -1 if nothing is pending.
+ */
+int nl_cache_mngr_get_timeout(struct nl_cache_mngr *mngr)
+{
+	struct nl_cache_pending *cp;
+	uint64_t now;
+
+	if (mngr->cm_recover_pending)
+		return 0;
+
+	if (nl_list_empty(&mngr->cm_pending_list))
+		return -1;
+
+	cp = nl_list_first_entry(&mngr->cm_pending_list,
+				 struct nl_cache_pending, cp_list);
+	now = mngr_usec();
+	if (cp->cp_deadline <= now)
+		return 0;
+
+	return (cp->cp_deadline - now + 999) / 1000;
+}
+
+/**
+ * Apply event notifications on worker threads
+ * @arg mngr		Cache manager
+ * @arg nworkers	Number of worker threads or 0 to disable them
+ *
+ * By default, nl_cache_mngr_data_ready() parses every notification and
+ * includes it into its cache before reading the next one. With workers
+ * set, it only passes each notification on to the worker thread the
+ * cache handling it is assigned to and returns once the socket is
+ * drained. The worker parses the notification, includes the object into
+ * the cache and calls the change callback. Caches are assigned to the
+ * workers in the order they were added, each cache to one worker, so
+ * notifications of a cache are applied in the order they were received.
+ * More workers than caches are of no use.
+ *
+ * Change callbacks are therefore called on the worker threads, those of
+ * caches assigned to different workers concurrently. During a recovery
+ * from lost notifications, they are called on the thread calling
+ * nl_cache_mngr_data_ready(). Other threads may only read a cache which
+ * has \c NL_CACHE_CONCURRENT set. Use nl_cache_mngr_flush() to wait
+ * until all notifications received were applied.
+ *
+ * Parsers of some cache types look up objects in caches provided with
+ * nl_cache_mngt_provide(), e.g. addresses and neighbours look up their
+ * link. \c NL_CACHE_CONCURRENT is therefore set on every cache of the
+ * manager which is provided, e.g. due to \c NL_AUTO_PROVIDE, and remains
+ * set. A cache of the manager provided after workers were set must have
+ * the flag set by the caller. Provided caches may not have
+ * \c NL_CACHE_LAZY_PARSE set, see nl_cache_set_flags().
+ *
+ * Changing the number of workers waits for the current workers to apply
+ * all notifications passed to them. Workers cannot be combined with the
+ * coalescing window of nl_cache_mngr_set_coalesce().
+ *
+ * @return 0 on success or a negative error code.
+ * @return -NLE_OPNOTSUPP Coalescing is enabled or threads are not supported
+ * @return -NLE_INVAL A provided cache has \c NL_CACHE_LAZY_PARSE set
+ */
+int nl_cache_mngr_set_workers(struct nl_cache_mngr *mngr, int nworkers)
+{
+#ifndef DISABLE_PTHREADS
+	struct nl_cache_worker *workers;
+	int i, err;
+
+	if (nworkers < 0)
+		return -NLE_INVAL;
+
+	if (nworkers && mngr->cm_coalesce_msec)
+		return -NLE_OPNOTSUPP;
+
+	for (i = 0; nworkers && i < mngr->cm_nassocs; i++) {
+		struct nl_cache *cache = mngr->cm_assocs[i].ca_cache;
+
+		if (cache && cache->c_ops->co_major_cache == cache &&
+		    (cache->c_flags & NL_CACHE_LAZY_PARSE))
+			return -NLE_INVAL;
+	}
+
+	mngr_stop_workers(mngr);
+	if (!nworkers)
+		return 0;
+
+	if (!(workers = calloc(nworkers, sizeof(*workers))))
+		return -NLE_NOMEM;
+
+	mngr_share_provided(mngr);
+
+	mngr->cm_workers = workers;
+	for (i = 0; i < nworkers; i++) {
+		struct nl_cache_worker *cw = &workers[i];
+
+		cw->cw_mngr = mngr;
+		pthread_mutex_init(&cw->cw_lock, NULL);
+		pthread_cond_init(&cw->cw_cond, NULL);
+
+		if ((err = pthread_create(&cw->cw_thread, NULL,
+					  worker_thread, cw))) {
+			pthread_cond_destroy(&cw->cw_cond);
+			pthread_mutex_destroy(&cw->cw_lock);
+			mngr_stop_workers(mngr);
+			return -nl_syserr2nlerr(err);
+		}
+
+		mngr->cm_nworkers = i + 1;
+	}
+
+	NL_DBG(1, "Cache manager %p, started %d workers\n", mngr, nworkers);
+
+	return 0;
+#else
+	return nworkers ? -NLE_OPNOTSUPP : 0;
+#endif
+}
+
 /**
  * Print information about cache manager
  * @arg mngr		Cache manager
@@ -572,12 +1434,16 @@ void nl_cache_mngr_info(struct nl_cache_mngr *mngr, struct nl_dump_params *p)
 	char buf[128];
 	int i;
 
+	mngr_quiesce(mngr);
+
 	nl_dump_line(p, "cache-manager <%p>\n", mngr);
 	nl_dump_line(p, "  .protocol = %s\n",
 		     nl_nlfamily2str(mngr->cm_protocol, buf, sizeof(buf)));
 	nl_dump_line(p, "  .flags    = %#x\n", mngr->cm_flags);
 	nl_dump_line(p, "  .nassocs  = %u\n", mngr->cm_nassocs);
 	nl_dump_line(p, "  .sock     = <%p>\n", mngr->cm_sock);
+	nl_dump_line(p, "  .overruns = %u\n", mngr->cm_recovery.rv_overruns);
+	nl_dump_line(p, "  .workers  = %d\n", mngr->cm_nworkers);
 
 	for (i = 0; i < mngr->cm_nassocs; i++) {
 		struct nl_cache_assoc *assoc = &mngr->cm_assocs[i];
@@ -608,11 +1474,14 @@ void nl_cache_mngr_info(struct nl_cache_mngr *mngr, struct nl_dump_params *p)
  */
 void nl_cache_mngr_free(struct nl_cache_mngr *mngr)
 {
+	struct nl_cache_pending *cp, *next;
 	int i;
 
 	if (!mngr)
 		return;
 
+	mngr_stop_workers(mngr);
+
 	if (mngr->cm_sock)
 		nl_close(mngr->cm_sock);
 
@@ -624,6 +1493,13 @@ void nl_cache_mngr_free(struct nl_cache_mngr *mngr)
 	if (mngr->cm_flags & NL_ALLOCATED_SOCK)
 		nl_socket_free(mngr->cm_sock);
 
+	/* Held back updates are dropped */
+	nl_list_for_each_entry_safe(cp, next, &mngr->cm_pending_list, cp_list) {
+		nl_object_put(cp->cp_obj);
+		free(cp);
+	}
+	free(mngr->cm_pending);
+
 	for (i = 0; i < mngr->cm_nassocs; i++) {
 		if (mngr->cm_assocs[i].ca_cache) {
 			nl_cache_mngt_unprovide(mngr->cm_assocs[i].ca_cache);
@@ -632,6 +1508,7 @@ void nl_cache_mngr_free(struct nl_cache_mngr *mngr)
 	}
 
 	free(mngr->cm_assocs);
+	free(mngr->cm_dispatch);
 
 	NL_DBG(1, "Cache manager %p freed\n", mngr);
 
@@ -0,0 +1,269 @@
+/* SPDX-License-Identifier: LGPL-2.1-only */
+/*
+ * lib/epoch.c		Epoch Based Reclamation
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+/** @cond SKIP */
+
+/*
+ * Caches with NL_CACHE_CONCURRENT set are read by other threads without
+ * taking any lock while a single thread modifies them. Readers enclose
+ * their accesses in __nl_epoch_enter()/__nl_epoch_exit(). Memory which
+ * may still be referenced by readers, e.g. an object just removed from
+ * the hashtable of a cache, is passed to __nl_epoch_retire() instead of
+ * being released directly.
+ *
+ * Every reader records the global epoch it has observed on entry. The
+ * global epoch is advanced once all active readers have observed the
+ * current one. Memory retired during epoch E is released once the global
+ * epoch has reached E + 2, at that point no reader active during E can
+ * be left. If no reader is active at all, memory is released right away.
+ */
+
+#include <netlink-private/netlink.h>
+#include <netlink/netlink.h>
+
+#ifndef DISABLE_PTHREADS
+
+#include <sched.h>
+
+struct nl_epoch_reader
+{
+	/* Epoch observed on entry or 0 if not active */
+	unsigned long		er_epoch;
+	unsigned int		er_nesting;
+	int			er_used;
+	struct nl_epoch_reader *er_next;
+};
+
+struct nl_epoch_retired
+{
+	void			(*rt_func)(void *);
+	void *			rt_arg;
+	unsigned long		rt_epoch;
+	struct nl_epoch_retired *rt_next;
+};
+
+static NL_LOCK(epoch_lock);
+static unsigned long epoch_global = 1;
+static struct nl_epoch_reader *epoch_readers;
+static struct nl_epoch_retired *epoch_retired;
+static pthread_key_t epoch_key;
+static __thread struct nl_epoch_reader *epoch_self;
+
+static void epoch_thread_exit(void *arg)
+{
+	struct nl_epoch_reader *r = arg;
+
+	/* The record is reused by the next thread registering */
+	__atomic_store_n(&r->er_epoch, 0, __ATOMIC_RELEASE);
+	r->er_nesting = 0;
+
+	nl_lock(&epoch_lock);
+	r->er_used = 0;
+	nl_unlock(&epoch_lock);
+}
+
+static struct nl_epoch_reader *epoch_register(void)
+{
+	struct nl_epoch_reader *r;
+
+	nl_lock(&epoch_lock);
+
+	for (r = epoch_readers; r; r = r->er_next)
+		if (!r->er_used)
+			break;
+
+	if (!r && (r = calloc(1, sizeof(*r)))) {
+		r->er_next = epoch_readers;
+		__atomic_store_n(&epoch_readers, r, __ATOMIC_RELEASE);
+	}
+
+	if (r)
+		r->er_used = 1;
+
+	nl_unlock(&epoch_lock);
+
+	if (r) {
+		pthread_setspecific(epoch_key, r);
+		epoch_self = r;
+	}
+
+	return r;
+}
+
+/*
+ * Returns the minimal epoch observed by an active reader or 0 if no
+ * reader is active.
+ */
+static unsigned long epoch_min_active(void)
+{
+	struct nl_epoch_reader *r;
+	unsigned long e, min = 0;
+
+	/* Orders the unlinking of retired memory before the check */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	for (r = __atomic_load_n(&epoch_readers, __ATOMIC_ACQUIRE); r;
+	     r = r->er_next) {
+		e = __atomic_load_n(&r->er_epoch, __ATOMIC_ACQUIRE);
+		if (e && (!min || e < min))
+			min = e;
+	}
+
+	return min;
+}
+
+/* Must be called with epoch_lock held, returns the list of expired items */
+static struct nl_epoch_retired *epoch_collect(void)
+{
+	struct nl_epoch_retired *rt, **prev, *expired = NULL;
+	unsigned long min = epoch_min_active();
+
+	if (!min || min == epoch_global)
+		__atomic_add_fetch(&epoch_global, 1, __ATOMIC_RELAXED);
+
+	for (prev = &epoch_retired; (rt = *prev); ) {
+		if (!min || rt->rt_epoch + 2 <= epoch_global) {
+			*prev = rt->rt_next;
+			rt->rt_next = expired;
+			expired = rt;
+		} else
+			prev = &rt->rt_next;
+	}
+
+	return expired;
+}
+
+static void epoch_release(struct nl_epoch_retired *rt)
+{
+	struct nl_epoch_retired *next;
+
+	for (; rt; rt = next) {
+		next = rt->rt_next;
+		rt->rt_func(rt->rt_arg);
+		free(rt);
+	}
+}
+
+/* Waits until every reader has left the section it was in, if any */
+static void epoch_synchronize(void)
+{
+	struct nl_epoch_reader *r;
+	unsigned long target;
+
+	nl_lock(&epoch_lock);
+	target = __atomic_add_fetch(&epoch_global, 1, __ATOMIC_RELAXED);
+	nl_unlock(&epoch_lock);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	for (r = __atomic_load_n(&epoch_readers, __ATOMIC_ACQUIRE); r;
+	     r = r->er_next) {
+		unsigned long e;
+
+		while ((e = __atomic_load_n(&r->er_epoch, __ATOMIC_ACQUIRE)) &&
+		       e < target)
+			sched_yield();
+	}
+}
+
+int __nl_epoch_enter(void)
+{
+	struct nl_epoch_reader *r = epoch_self;
+
+	if (!r && !(r = epoch_register()))
+		return -NLE_NOMEM;
+
+	if (r->er_nesting++ == 0) {
+		__atomic_store_n(&r->er_epoch,
+				 __atomic_load_n(&epoch_global, __ATOMIC_RELAXED),
+				 __ATOMIC_RELAXED);
+		/* Publish the epoch before reading any shared pointer */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+
+	return 0;
+}
+
+void __nl_epoch_exit(void)
+{
+	struct nl_epoch_reader *r = epoch_self;
+
+	if (--r->er_nesting == 0)
+		__atomic_store_n(&r->er_epoch, 0, __ATOMIC_RELEASE);
+}
+
+void __nl_epoch_retire(void (*func)(void *), void *arg)
+{
+	struct nl_epoch_retired *rt, *expired;
+
+	if (!(rt = malloc(sizeof(*rt)))) {
+		epoch_synchronize();
+		func(arg);
+		return;
+	}
+
+	rt->rt_func = func;
+	rt->rt_arg = arg;
+
+	nl_lock(&epoch_lock);
+	rt->rt_epoch = epoch_global;
+	rt->rt_next = epoch_retired;
+	epoch_retired = rt;
+	expired = epoch_collect();
+	nl_unlock(&epoch_lock);
+
+	epoch_release(expired);
+}
+
+static void __init epoch_init(void)
+{
+	pthread_key_create(&epoch_key, epoch_thread_exit);
+}
+
+static void __exit epoch_exit(void)
+{
+	struct nl_epoch_retired *rt;
+	struct nl_epoch_reader *r, *next;
+
+	nl_lock(&epoch_lock);
+	rt = epoch_retired;
+	epoch_retired = NULL;
+	nl_unlock(&epoch_lock);
+
+	epoch_release(rt);
+
+	pthread_key_delete(epoch_key);
+
+	for (r = epoch_readers; r; r = next) {
+		next = r->er_next;
+		free(r);
+	}
+	epoch_readers = NULL;
+}
+
+#else
+
+int __nl_epoch_enter(void)
+{
+	return 0;
+}
+
+void __nl_epoch_exit(void)
+{
+}
+
+void __nl_epoch_retire(void (*func)(void *), void *arg)
+{
+	func(arg);
+}
+
+#endif
+
+/** @endcond */
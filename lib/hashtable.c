@@ -10,6 +10,9 @@
  * Copyright (c) 2012 Cumulus Networks, Inc
  */
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <netlink-private/netlink.h>
 #include <netlink/object.h>
 #include <netlink/hash.h>
@@ -21,27 +24,563 @@
  * @{
  */
 
+/** @cond SKIP */
+/* Resize state, kept apart to leave the layout of nl_hash_table_t as is */
+struct nl_hash_table_priv {
+	nl_hash_table_t		ht;
+	int			min_size;
+	int			entries;
+	/* buckets not yet moved to nodes while resizing */
+	int			old_size;
+	nl_hash_node_t **	old_nodes;
+	int			rehash_idx;
+	/* open addressing index, used instead of nodes if set */
+	struct nl_hash_index *	index;
+};
+
+static inline struct nl_hash_table_priv *ht_priv(nl_hash_table_t *ht)
+{
+	return (struct nl_hash_table_priv *) ht;
+}
+
+/* Number of buckets moved to the resized table per add or delete */
+#define NL_HASH_REHASH_STEP	4
+/* Grow once there are more objects than buckets, shrink once less than
+ * one eighth of the buckets would be used. */
+#define NL_HASH_SHRINK_RATIO	8
+
+static void ht_rehash_step(nl_hash_table_t *ht, int nsteps)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	int empty_visits = nsteps * 10;
+
+	while (nsteps > 0 && priv->rehash_idx < priv->old_size) {
+		nl_hash_node_t *node = priv->old_nodes[priv->rehash_idx];
+
+		if (!node) {
+			priv->rehash_idx++;
+			if (--empty_visits == 0)
+				break;
+			continue;
+		}
+
+		while (node) {
+			nl_hash_node_t *next = node->next;
+			uint32_t bucket = node->key % ht->size;
+
+			node->next = ht->nodes[bucket];
+			ht->nodes[bucket] = node;
+			node = next;
+		}
+
+		priv->old_nodes[priv->rehash_idx++] = NULL;
+		nsteps--;
+	}
+
+	if (priv->rehash_idx >= priv->old_size) {
+		NL_DBG(3, "hashtable %p: Rehashing to %d buckets completed\n",
+		       ht, ht->size);
+		free(priv->old_nodes);
+		priv->old_nodes = NULL;
+		priv->old_size = 0;
+		priv->rehash_idx = 0;
+	}
+}
+
+static void ht_resize(nl_hash_table_t *ht, int size)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	nl_hash_node_t **nodes;
+
+	/* Failing to resize is not fatal, chains just get longer */
+	nodes = calloc(size, sizeof(*nodes));
+	if (!nodes)
+		return;
+
+	NL_DBG(3, "hashtable %p: Resizing from %d to %d buckets, %d entries\n",
+	       ht, ht->size, size, priv->entries);
+
+	priv->old_nodes = ht->nodes;
+	priv->old_size = ht->size;
+	priv->rehash_idx = 0;
+	ht->nodes = nodes;
+	ht->size = size;
+}
+
+static void ht_update(nl_hash_table_t *ht)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+
+	if (priv->old_nodes) {
+		ht_rehash_step(ht, NL_HASH_REHASH_STEP);
+		return;
+	}
+
+	if (priv->entries > ht->size && ht->size <= INT_MAX / 2)
+		ht_resize(ht, ht->size * 2);
+	else if (ht->size > priv->min_size &&
+		 priv->entries < ht->size / NL_HASH_SHRINK_RATIO)
+		ht_resize(ht, max(ht->size / 2, priv->min_size));
+}
+
+static nl_hash_node_t **ht_find(nl_hash_table_t *ht, struct nl_object *obj,
+				uint32_t key_hash)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	nl_hash_node_t **pnode;
+
+	pnode = &ht->nodes[key_hash % ht->size];
+	while (*pnode) {
+		if ((*pnode)->key == key_hash &&
+		    nl_object_identical((*pnode)->obj, obj))
+			return pnode;
+		pnode = &(*pnode)->next;
+	}
+
+	if (!priv->old_nodes)
+		return NULL;
+
+	pnode = &priv->old_nodes[key_hash % priv->old_size];
+	while (*pnode) {
+		if ((*pnode)->key == key_hash &&
+		    nl_object_identical((*pnode)->obj, obj))
+			return pnode;
+		pnode = &(*pnode)->next;
+	}
+
+	return NULL;
+}
+
+static void ht_free_chains(nl_hash_node_t **nodes, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		nl_hash_node_t *node = nodes[i];
+		nl_hash_node_t *saved_node;
+
+		while (node) {
+			saved_node = node;
+			node = node->next;
+			nl_object_put(saved_node->obj);
+			free(saved_node);
+		}
+	}
+
+	free(nodes);
+}
+
+static void ht_count_chains(nl_hash_node_t **nodes, int size,
+			    struct nl_hash_table_stats *stats)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		nl_hash_node_t *node;
+		unsigned int len = 0;
+
+		for (node = nodes[i]; node; node = node->next)
+			len++;
+
+		if (len) {
+			stats->hs_used++;
+			stats->hs_entries += len;
+		}
+
+		stats->hs_max_chain = max(stats->hs_max_chain, len);
+		stats->hs_chains[min_t(unsigned int, len, NL_HASH_STATS_CHAINS - 1)]++;
+	}
+}
+
+/*
+ * Open addressing index
+ *
+ * Objects are stored in a flat array of slots divided into groups of 16.
+ * A control byte per slot holds either the low 7 bits of the hash of the
+ * object stored (H2) or marks the slot as empty or deleted. A lookup
+ * starts at the group selected by the remaining hash bits (H1) and
+ * compares all 16 control bytes of a group at once, only slots with a
+ * matching H2 are looked at. Groups are probed quadratically until one
+ * containing an empty slot is found.
+ *
+ * Lookups may run concurrently with a single thread modifying the index,
+ * see NL_CACHE_CONCURRENT. A slot is filled before its control byte is
+ * published and indexes replaced by a resize are retired rather than
+ * freed. Such lookups may miss objects being moved and must be retried.
+ */
+#define HI_GROUP		16
+#define HI_EMPTY		((int8_t) -128)
+#define HI_DELETED		((int8_t) -2)
+
+struct nl_hash_slot
+{
+	struct nl_object *	hs_obj;
+	uint32_t		hs_hash;
+};
+
+struct nl_hash_index
+{
+	int8_t *		hi_ctrl;
+	struct nl_hash_slot *	hi_slots;
+	/* number of groups - 1 */
+	uint32_t		hi_mask;
+	/* number of empty slots that may be used before resizing */
+	uint32_t		hi_growth_left;
+	/* index being moved into this one after a resize */
+	struct nl_hash_index *	hi_old;
+};
+
+#ifdef __SSE2__
+static inline uint32_t hi_match(const int8_t *ctrl, int8_t h)
+{
+	__m128i group = _mm_loadu_si128((const __m128i *) ctrl);
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h)));
+}
+
+static inline uint32_t hi_match_free(const int8_t *ctrl)
+{
+	/* empty and deleted slots have the sign bit set */
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) ctrl));
+}
+#else
+static inline uint32_t hi_match(const int8_t *ctrl, int8_t h)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < HI_GROUP; i++)
+		if (ctrl[i] == h)
+			mask |= 1U << i;
+
+	return mask;
+}
+
+static inline uint32_t hi_match_free(const int8_t *ctrl)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < HI_GROUP; i++)
+		if (ctrl[i] < 0)
+			mask |= 1U << i;
+
+	return mask;
+}
+#endif
+
+static inline uint32_t hi_capacity(const struct nl_hash_index *hi)
+{
+	return (hi->hi_mask + 1) * HI_GROUP;
+}
+
+static struct nl_hash_index *hi_alloc(uint32_t ngroups)
+{
+	struct nl_hash_index *hi;
+
+	hi = calloc(1, sizeof(*hi));
+	if (!hi)
+		return NULL;
+
+	hi->hi_ctrl = malloc(ngroups * HI_GROUP);
+	hi->hi_slots = malloc(ngroups * HI_GROUP * sizeof(*hi->hi_slots));
+	if (!hi->hi_ctrl || !hi->hi_slots) {
+		free(hi->hi_ctrl);
+		free(hi->hi_slots);
+		free(hi);
+		return NULL;
+	}
+
+	memset(hi->hi_ctrl, HI_EMPTY, ngroups * HI_GROUP);
+	hi->hi_mask = ngroups - 1;
+	hi->hi_growth_left = hi_capacity(hi) / 8 * 7;
+
+	return hi;
+}
+
+static void hi_free(struct nl_hash_index *hi)
+{
+	uint32_t i;
+
+	for (i = 0; i < hi_capacity(hi); i++)
+		if (hi->hi_ctrl[i] >= 0)
+			nl_object_put(hi->hi_slots[i].hs_obj);
+
+	free(hi->hi_ctrl);
+	free(hi->hi_slots);
+	free(hi);
+}
+
+/* Number of groups required to hold @n objects without resizing */
+static uint32_t hi_groups_for(uint32_t n)
+{
+	uint32_t ngroups = 1;
+
+	while (ngroups * HI_GROUP / 8 * 7 < n && ngroups < (1U << 24))
+		ngroups <<= 1;
+
+	return ngroups;
+}
+
+/* Returns the slot index, the object found is stored in @found if set */
+static int hi_find(const struct nl_hash_index *hi, struct nl_object *obj,
+		   uint32_t key_hash, struct nl_object **found)
+{
+	uint32_t group = (key_hash >> 7) & hi->hi_mask;
+	int8_t h2 = key_hash & 0x7f;
+	uint32_t probe;
+
+	for (probe = 0; probe <= hi->hi_mask; probe++) {
+		const int8_t *ctrl = hi->hi_ctrl + group * HI_GROUP;
+		uint32_t match = hi_match(ctrl, h2);
+
+		/* pairs with the release of the control byte in hi_insert() */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		while (match) {
+			uint32_t idx = group * HI_GROUP + __builtin_ctz(match);
+			const struct nl_hash_slot *slot = &hi->hi_slots[idx];
+			struct nl_object *cand;
+
+			/* the slot may be reused by a concurrent update */
+			cand = __atomic_load_n(&slot->hs_obj, __ATOMIC_RELAXED);
+			if (slot->hs_hash == key_hash &&
+			    nl_object_identical(cand, obj)) {
+				if (found)
+					*found = cand;
+				return idx;
+			}
+
+			match &= match - 1;
+		}
+
+		if (hi_match(ctrl, HI_EMPTY))
+			break;
+
+		group = (group + probe + 1) & hi->hi_mask;
+	}
+
+	return -1;
+}
+
+/* Inserts without checking for duplicates, the index may not be full */
+static void hi_insert(struct nl_hash_index *hi, struct nl_object *obj,
+		      uint32_t key_hash)
+{
+	uint32_t group = (key_hash >> 7) & hi->hi_mask;
+	uint32_t probe, match, idx;
+
+	for (probe = 0; ; probe++) {
+		match = hi_match_free(hi->hi_ctrl + group * HI_GROUP);
+		if (match)
+			break;
+
+		group = (group + probe + 1) & hi->hi_mask;
+	}
+
+	idx = group * HI_GROUP + __builtin_ctz(match);
+	if (hi->hi_ctrl[idx] == HI_EMPTY && hi->hi_growth_left > 0)
+		hi->hi_growth_left--;
+
+	__atomic_store_n(&hi->hi_slots[idx].hs_obj, obj, __ATOMIC_RELAXED);
+	hi->hi_slots[idx].hs_hash = key_hash;
+	__atomic_store_n(&hi->hi_ctrl[idx], key_hash & 0x7f, __ATOMIC_RELEASE);
+}
+
+static void hi_erase(struct nl_hash_index *hi, uint32_t idx)
+{
+	const int8_t *ctrl = hi->hi_ctrl + (idx & ~(HI_GROUP - 1));
+
+	/* A probe never continued past a group with an empty slot, the slot
+	 * may be marked empty again. Otherwise, leave a tombstone. */
+	if (hi_match(ctrl, HI_EMPTY)) {
+		hi->hi_ctrl[idx] = HI_EMPTY;
+		hi->hi_growth_left++;
+	} else
+		hi->hi_ctrl[idx] = HI_DELETED;
+}
+
+static void hi_free_retired(void *arg)
+{
+	/* all objects have been moved, nothing left to put */
+	hi_free(arg);
+}
+
+static void hi_rehash_step(nl_hash_table_t *ht, uint32_t ngroups)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	struct nl_hash_index *old = priv->index->hi_old;
+
+	while (ngroups-- && (uint32_t) priv->rehash_idx <= old->hi_mask) {
+		uint32_t base = priv->rehash_idx++ * HI_GROUP;
+		uint32_t i;
+
+		for (i = base; i < base + HI_GROUP; i++) {
+			if (old->hi_ctrl[i] < 0)
+				continue;
+
+			hi_insert(priv->index, old->hi_slots[i].hs_obj,
+				  old->hi_slots[i].hs_hash);
+
+			/* Tombstone keeps probes for objects not yet moved
+			 * going */
+			old->hi_ctrl[i] = HI_DELETED;
+		}
+	}
+
+	if ((uint32_t) priv->rehash_idx > old->hi_mask) {
+		NL_DBG(3, "hashtable %p: Rehashing to %d slots completed\n",
+		       ht, ht->size);
+		__atomic_store_n(&priv->index->hi_old, NULL, __ATOMIC_RELEASE);
+		priv->rehash_idx = 0;
+		__nl_epoch_retire(hi_free_retired, old);
+	}
+}
+
+static void hi_resize(nl_hash_table_t *ht, uint32_t ngroups)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	struct nl_hash_index *hi;
+
+	hi = hi_alloc(ngroups);
+	if (!hi)
+		return;
+
+	NL_DBG(3, "hashtable %p: Resizing from %d to %u slots, %d entries\n",
+	       ht, ht->size, ngroups * HI_GROUP, priv->entries);
+
+	/* Lookups check the new index first, objects are found in the old
+	 * one until moved. */
+	hi->hi_old = priv->index;
+	priv->rehash_idx = 0;
+	__atomic_store_n(&priv->index, hi, __ATOMIC_RELEASE);
+	ht->size = hi_capacity(hi);
+}
+
+static void hi_update(nl_hash_table_t *ht)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	struct nl_hash_index *hi = priv->index;
+	uint32_t ngroups = hi->hi_mask + 1;
+
+	if (hi->hi_old) {
+		hi_rehash_step(ht, NL_HASH_REHASH_STEP);
+
+		/* can not happen unless objects are added much faster than
+		 * moved, finish up and resize right away */
+		if (hi->hi_old && hi->hi_growth_left == 0)
+			hi_rehash_step(ht, UINT32_MAX);
+		if (hi->hi_old || hi->hi_growth_left > 0)
+			return;
+	}
+
+	if (hi->hi_growth_left == 0) {
+		/* Rehash into a table of the same size if most of the used
+		 * up slots are tombstones */
+		if ((uint32_t) priv->entries > hi_capacity(hi) / 16 * 7 &&
+		    ngroups < (1U << 24))
+			hi_resize(ht, ngroups * 2);
+		else
+			hi_resize(ht, ngroups);
+	} else if (ht->size > priv->min_size &&
+		   priv->entries < ht->size / NL_HASH_SHRINK_RATIO)
+		hi_resize(ht, ngroups / 2);
+}
+
+static void hi_count_probes(const struct nl_hash_index *hi,
+			    struct nl_hash_table_stats *stats)
+{
+	uint32_t i;
+
+	for (i = 0; i < hi_capacity(hi); i++) {
+		uint32_t group, probe = 0;
+
+		if (hi->hi_ctrl[i] < 0)
+			continue;
+
+		group = (hi->hi_slots[i].hs_hash >> 7) & hi->hi_mask;
+		while (group != i / HI_GROUP) {
+			probe++;
+			group = (group + probe) & hi->hi_mask;
+		}
+
+		stats->hs_entries++;
+		stats->hs_used++;
+		stats->hs_max_chain = max(stats->hs_max_chain, probe + 1);
+		stats->hs_chains[min_t(unsigned int, probe + 1,
+				       NL_HASH_STATS_CHAINS - 1)]++;
+	}
+}
+/** @endcond */
+
 /**
  * Allocate hashtable
  * @arg size		Size of hashtable in number of elements
  *
+ * The hashtable grows as objects are added to keep chains short and
+ * shrinks back down to `size` as they are removed. Objects are moved to
+ * the resized table a few buckets at a time on each following add or
+ * delete.
+ *
+ * @see nl_hash_table_alloc_flags()
+ *
  * @return Allocated hashtable or NULL.
  */
 nl_hash_table_t *nl_hash_table_alloc(int size)
 {
+	return nl_hash_table_alloc_flags(size, 0);
+}
+
+/**
+ * Allocate hashtable with a specific implementation
+ * @arg size		Initial number of elements
+ * @arg flags		Flags
+ *
+ * By default, objects are kept on a chain of nodes per bucket. With
+ * `NL_HASH_TABLE_OPEN` set, objects are instead stored in a flat array
+ * using open addressing with a control byte per slot. Lookups then
+ * compare up to 16 control bytes at once, using SSE2 where available,
+ * and touch about one cache line of slots instead of following a pointer
+ * per chain element. The `nodes` field is not used by such hashtables.
+ * The index starts out with room for `size` objects and grows with the
+ * number of objects stored, it never shrinks below its initial size.
+ *
+ * @return Allocated hashtable or NULL.
+ */
+nl_hash_table_t *nl_hash_table_alloc_flags(int size, int flags)
+{
+	struct nl_hash_table_priv *priv;
 	nl_hash_table_t *ht;
 
-	ht = calloc(1, sizeof (*ht));
-	if (!ht)
+	if (size < 1)
+		size = 1;
+
+	priv = calloc(1, sizeof (*priv));
+	if (!priv)
 		goto errout;
+	ht = &priv->ht;
+
+	if (flags & NL_HASH_TABLE_OPEN) {
+		priv->index = hi_alloc(hi_groups_for(size));
+		if (!priv->index) {
+			free(priv);
+			goto errout;
+		}
+
+		ht->size = hi_capacity(priv->index);
+		priv->min_size = ht->size;
+
+		return ht;
+	}
 
 	ht->nodes = calloc(size, sizeof (*ht->nodes));
 	if (!ht->nodes) {
-		free(ht);
+		free(priv);
 		goto errout;
 	}
 
 	ht->size = size;
+	priv->min_size = size;
 
 	return ht;
 errout:
@@ -56,22 +595,21 @@ errout:
  */
 void nl_hash_table_free(nl_hash_table_t *ht)
 {
-	int i;
+	struct nl_hash_table_priv *priv = ht_priv(ht);
 
-	for(i = 0; i < ht->size; i++) {
-	    nl_hash_node_t *node = ht->nodes[i];
-	    nl_hash_node_t *saved_node;
-
-	    while (node) {
-		   saved_node = node;
-		   node = node->next;
-		   nl_object_put(saved_node->obj);
-		   free(saved_node);
-	    }
+	if (priv->index) {
+		if (priv->index->hi_old)
+			hi_free(priv->index->hi_old);
+		hi_free(priv->index);
+		free(priv);
+		return;
 	}
 
-	free(ht->nodes);
-	free(ht);
+	ht_free_chains(ht->nodes, ht->size);
+	if (priv->old_nodes)
+		ht_free_chains(priv->old_nodes, priv->old_size);
+
+	free(priv);
 }
 
 /**
@@ -80,26 +618,40 @@ void nl_hash_table_free(nl_hash_table_t *ht)
  * @arg	obj		Object to lookup
  *
  * Generates hashkey for `obj` and traverses the corresponding chain calling
- * `nl_object_identical()` on each trying to find a match.
+ * `nl_object_identical()` on each object with the same hashkey trying to
+ * find a match.
+ *
+ * Hashtables allocated with `NL_HASH_TABLE_OPEN` may be looked up while
+ * another thread modifies them, provided the lookup is retried if it
+ * fails meanwhile and objects removed are released only once lookups
+ * are done with them. See `NL_CACHE_CONCURRENT`.
  *
  * @return Pointer to object if match was found or NULL.
  */
 struct nl_object* nl_hash_table_lookup(nl_hash_table_t *ht,
 				       struct nl_object *obj)
 {
-	nl_hash_node_t *node;
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	struct nl_hash_index *hi;
+	struct nl_object *found;
+	nl_hash_node_t **pnode;
 	uint32_t key_hash;
 
-	nl_object_keygen(obj, &key_hash, ht->size);
-	node = ht->nodes[key_hash];
+	key_hash = _nl_object_hash(obj);
 
-	while (node) {
-	       if (nl_object_identical(node->obj, obj))
-		   return node->obj;
-	       node = node->next;
+	if ((hi = __atomic_load_n(&priv->index, __ATOMIC_ACQUIRE))) {
+		if (hi_find(hi, obj, key_hash, &found) < 0) {
+			hi = __atomic_load_n(&hi->hi_old, __ATOMIC_ACQUIRE);
+			if (!hi || hi_find(hi, obj, key_hash, &found) < 0)
+				return NULL;
+		}
+
+		return found;
 	}
 
-	return NULL;
+	pnode = ht_find(ht, obj, key_hash);
+
+	return pnode ? (*pnode)->obj : NULL;
 }
 
 /**
@@ -117,18 +669,33 @@ struct nl_object* nl_hash_table_lookup(nl_hash_table_t *ht,
  */
 int nl_hash_table_add(nl_hash_table_t *ht, struct nl_object *obj)
 {
+	struct nl_hash_table_priv *priv = ht_priv(ht);
 	nl_hash_node_t *node;
-	uint32_t key_hash;
+	uint32_t key_hash, bucket;
+
+	key_hash = _nl_object_hash(obj);
+
+	if (priv->index) {
+		struct nl_hash_index *old = priv->index->hi_old;
+
+		if (hi_find(priv->index, obj, key_hash, NULL) >= 0 ||
+		    (old && hi_find(old, obj, key_hash, NULL) >= 0)) {
+			NL_DBG(2, "Warning: Add to hashtable found duplicate...\n");
+			return -NLE_EXIST;
+		}
+
+		nl_object_get(obj);
+		hi_insert(priv->index, obj, key_hash);
+		priv->entries++;
 
-	nl_object_keygen(obj, &key_hash, ht->size);
-	node = ht->nodes[key_hash];
+		hi_update(ht);
 
-	while (node) {
-	       if (nl_object_identical(node->obj, obj)) {
-		   NL_DBG(2, "Warning: Add to hashtable found duplicate...\n");
-		   return -NLE_EXIST;
-	       }
-	       node = node->next;
+		return 0;
+	}
+
+	if (ht_find(ht, obj, key_hash)) {
+		NL_DBG(2, "Warning: Add to hashtable found duplicate...\n");
+		return -NLE_EXIST;
 	}
 
 	NL_DBG (5, "adding cache entry of obj %p in table %p, with hash 0x%x\n",
@@ -141,8 +708,13 @@ int nl_hash_table_add(nl_hash_table_t *ht, struct nl_object *obj)
 	node->obj = obj;
 	node->key = key_hash;
 	node->key_size = sizeof(uint32_t);
-	node->next = ht->nodes[key_hash];
-	ht->nodes[key_hash] = node;
+
+	bucket = key_hash % ht->size;
+	node->next = ht->nodes[bucket];
+	ht->nodes[bucket] = node;
+	priv->entries++;
+
+	ht_update(ht);
 
 	return 0;
 }
@@ -161,33 +733,95 @@ int nl_hash_table_add(nl_hash_table_t *ht, struct nl_object *obj)
  */
 int nl_hash_table_del(nl_hash_table_t *ht, struct nl_object *obj)
 {
-	nl_hash_node_t *node, *prev;
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+	nl_hash_node_t **pnode, *node;
 	uint32_t key_hash;
 
-	nl_object_keygen(obj, &key_hash, ht->size);
-	prev = node = ht->nodes[key_hash];
+	key_hash = _nl_object_hash(obj);
+
+	if (priv->index) {
+		struct nl_hash_index *hi = priv->index;
+		int idx;
+
+		if ((idx = hi_find(hi, obj, key_hash, NULL)) < 0) {
+			hi = priv->index->hi_old;
+			if (!hi || (idx = hi_find(hi, obj, key_hash, NULL)) < 0)
+				return -NLE_OBJ_NOTFOUND;
+		}
+
+		nl_object_put(hi->hi_slots[idx].hs_obj);
+
+		if (hi == priv->index)
+			hi_erase(hi, idx);
+		else
+			hi->hi_ctrl[idx] = HI_DELETED;
+		priv->entries--;
+
+		hi_update(ht);
+
+		return 0;
+	}
+
+	pnode = ht_find(ht, obj, key_hash);
+	if (!pnode)
+		return -NLE_OBJ_NOTFOUND;
+
+	node = *pnode;
+	nl_object_put(node->obj);
 
-	while (node) {
-	       if (nl_object_identical(node->obj, obj)) {
-		   nl_object_put(obj);
+	NL_DBG (5, "deleting cache entry of obj %p in table %p, with"
+		" hash 0x%x\n", obj, ht, key_hash);
 
-		   NL_DBG (5, "deleting cache entry of obj %p in table %p, with"
-			   " hash 0x%x\n", obj, ht, key_hash);
+	*pnode = node->next;
+	free(node);
+	priv->entries--;
 
-	           if (node == ht->nodes[key_hash])
-		       ht->nodes[key_hash] = node->next;
-	           else
-		       prev->next = node->next;
+	ht_update(ht);
 
-	           free(node);
+	return 0;
+}
+
+/**
+ * Retrieve chain length statistics
+ * @arg ht		Hashtable
+ * @arg stats		Pointer to store statistics in.
+ *
+ * Walks all chains of the hashtable. While the hashtable is being resized,
+ * the buckets of both the old and new table are accounted for.
+ *
+ * For hashtables allocated with `NL_HASH_TABLE_OPEN`, buckets are slots
+ * and the chain length of an object is the number of groups probed to
+ * find it.
+ */
+void nl_hash_table_get_stats(nl_hash_table_t *ht,
+			     struct nl_hash_table_stats *stats)
+{
+	struct nl_hash_table_priv *priv = ht_priv(ht);
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (priv->index) {
+		struct nl_hash_index *old = priv->index->hi_old;
 
-	           return 0;
+		stats->hs_size = ht->size;
+		stats->hs_rehashing = !!old;
+
+		hi_count_probes(priv->index, stats);
+		if (old) {
+			stats->hs_size += hi_capacity(old);
+			hi_count_probes(old, stats);
 		}
-		prev = node;
-		node = node->next;
+		return;
 	}
 
-	return -NLE_OBJ_NOTFOUND;
+	stats->hs_size = ht->size;
+	stats->hs_rehashing = !!priv->old_nodes;
+
+	ht_count_chains(ht->nodes, ht->size, stats);
+	if (priv->old_nodes) {
+		stats->hs_size += priv->old_size;
+		ht_count_chains(priv->old_nodes, priv->old_size, stats);
+	}
 }
 
 uint32_t nl_hash(void *k, size_t length, uint32_t initval)
@@ -180,6 +180,7 @@ void idiagnl_msg_set_family(struct idiagnl_msg *msg, uint8_t family)
 {
 	msg->idiag_family = family;
 	msg->ce_mask |= IDIAGNL_ATTR_FAMILY;
+	nl_object_invalidate_hash(OBJ_CAST(msg));
 }
 
 uint8_t idiagnl_msg_get_state(const struct idiagnl_msg *msg)
@@ -224,6 +225,7 @@ void idiagnl_msg_set_sport(struct idiagnl_msg *msg, uint16_t port)
 {
 	msg->idiag_sport = port;
 	msg->ce_mask |= IDIAGNL_ATTR_SPORT;
+	nl_object_invalidate_hash(OBJ_CAST(msg));
 }
 
 uint16_t idiagnl_msg_get_dport(struct idiagnl_msg *msg)
@@ -235,6 +237,7 @@ void idiagnl_msg_set_dport(struct idiagnl_msg *msg, uint16_t port)
 {
 	msg->idiag_dport = port;
 	msg->ce_mask |= IDIAGNL_ATTR_DPORT;
+	nl_object_invalidate_hash(OBJ_CAST(msg));
 }
 
 struct nl_addr *idiagnl_msg_get_src(const struct idiagnl_msg *msg)
@@ -250,6 +253,7 @@ int idiagnl_msg_set_src(struct idiagnl_msg *msg, struct nl_addr *addr)
 	nl_addr_get(addr);
 	msg->idiag_src = addr;
 	msg->ce_mask |= IDIAGNL_ATTR_SRC;
+	nl_object_invalidate_hash(OBJ_CAST(msg));
 
 	return 0;
 }
@@ -267,6 +271,7 @@ int idiagnl_msg_set_dst(struct idiagnl_msg *msg, struct nl_addr *addr)
 	nl_addr_get(addr);
 	msg->idiag_dst = addr;
 	msg->ce_mask |= IDIAGNL_ATTR_DST;
+	nl_object_invalidate_hash(OBJ_CAST(msg));
 
 	return 0;
 }
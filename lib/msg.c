@@ -260,23 +260,230 @@ int nlmsg_validate(struct nlmsghdr *nlh, int hdrlen, int maxtype,
  * @{
  */
 
+/** @cond SKIP */
+/*
+ * Messages are cached together with their payload buffer on a free list
+ * per power of two size class, from 256 bytes up to 64KiB. Larger
+ * messages and messages whose payload lives in a receive buffer are
+ * never pooled. Every thread has free lists of its own, a message is
+ * cached by the thread freeing it. The lists of a thread are flushed
+ * when it exits.
+ */
+#define NL_MSG_POOL_MIN_SHIFT	8
+#define NL_MSG_POOL_CLASSES	9
+#define NL_MSG_POOL_LIMIT	32
+
+struct nl_msg_pool
+{
+	struct nl_msg *		mp_free[NL_MSG_POOL_CLASSES];
+	/* Written by the owning thread only, read for statistics */
+	unsigned int		mp_count[NL_MSG_POOL_CLASSES];
+	uint64_t		mp_hits;
+	uint64_t		mp_misses;
+	int			mp_used;
+	struct nl_msg_pool *	mp_next;
+};
+
+/* Protects the list of pools, not the pools themselves */
+static NL_LOCK(msg_pool_lock);
+static unsigned int msg_pool_limit = NL_MSG_POOL_LIMIT;
+
+#ifndef DISABLE_PTHREADS
+static struct nl_msg_pool *msg_pools;
+static pthread_key_t msg_pool_key;
+static __thread struct nl_msg_pool *msg_pool_self;
+#else
+static struct nl_msg_pool msg_pool_main = { .mp_used = 1 };
+static struct nl_msg_pool *msg_pools = &msg_pool_main;
+#endif
+
+static unsigned int msg_pool_class(size_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < NL_MSG_POOL_CLASSES; i++)
+		if (len <= ((size_t) 1 << (NL_MSG_POOL_MIN_SHIFT + i)))
+			return i + 1;
+
+	return 0;
+}
+
+static size_t msg_pool_class_size(unsigned int class)
+{
+	return (size_t) 1 << (NL_MSG_POOL_MIN_SHIFT + class - 1);
+}
+
+static void msg_pool_trim(struct nl_msg_pool *p, unsigned int limit)
+{
+	struct nl_msg *nm;
+	unsigned int i;
+
+	for (i = 0; i < NL_MSG_POOL_CLASSES; i++) {
+		while (p->mp_count[i] > limit) {
+			nm = p->mp_free[i];
+			p->mp_free[i] = nm->nm_pool_next;
+			__atomic_store_n(&p->mp_count[i], p->mp_count[i] - 1,
+					 __ATOMIC_RELAXED);
+
+			free(nm->nm_nlh);
+			free(nm);
+		}
+	}
+}
+
+#ifndef DISABLE_PTHREADS
+static void msg_pool_thread_exit(void *arg)
+{
+	struct nl_msg_pool *p = arg;
+
+	msg_pool_trim(p, 0);
+	msg_pool_self = NULL;
+
+	/* The pool is reused by the next thread registering */
+	nl_lock(&msg_pool_lock);
+	p->mp_used = 0;
+	nl_unlock(&msg_pool_lock);
+}
+
+static struct nl_msg_pool *msg_pool_register(void)
+{
+	struct nl_msg_pool *p;
+
+	nl_lock(&msg_pool_lock);
+
+	for (p = msg_pools; p; p = p->mp_next)
+		if (!p->mp_used)
+			break;
+
+	if (!p && (p = calloc(1, sizeof(*p)))) {
+		p->mp_next = msg_pools;
+		msg_pools = p;
+	}
+
+	if (p)
+		p->mp_used = 1;
+
+	nl_unlock(&msg_pool_lock);
+
+	if (p) {
+		pthread_setspecific(msg_pool_key, p);
+		msg_pool_self = p;
+	}
+
+	return p;
+}
+
+static struct nl_msg_pool *msg_pool_this(void)
+{
+	return msg_pool_self ? msg_pool_self : msg_pool_register();
+}
+
+static void __init msg_pool_init(void)
+{
+	pthread_key_create(&msg_pool_key, msg_pool_thread_exit);
+}
+#else
+static struct nl_msg_pool *msg_pool_this(void)
+{
+	return &msg_pool_main;
+}
+#endif
+
+static struct nl_msg *msg_pool_get(unsigned int class)
+{
+	struct nl_msg_pool *p = msg_pool_this();
+	struct nl_msg *nm;
+
+	if (!p)
+		return NULL;
+
+	if (class && (nm = p->mp_free[class - 1])) {
+		p->mp_free[class - 1] = nm->nm_pool_next;
+		__atomic_store_n(&p->mp_count[class - 1],
+				 p->mp_count[class - 1] - 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&p->mp_hits, p->mp_hits + 1, __ATOMIC_RELAXED);
+		return nm;
+	}
+
+	__atomic_store_n(&p->mp_misses, p->mp_misses + 1, __ATOMIC_RELAXED);
+
+	return NULL;
+}
+
+static int msg_pool_put(struct nl_msg *nm)
+{
+	unsigned int class = nm->nm_pool_class;
+	unsigned int limit = __atomic_load_n(&msg_pool_limit, __ATOMIC_RELAXED);
+	struct nl_msg_pool *p;
+
+	if (!class || nm->nm_rbuf || !(p = msg_pool_this()))
+		return 0;
+
+	if (p->mp_count[class - 1] >= limit) {
+		/* The limit may have been lowered by another thread */
+		msg_pool_trim(p, limit);
+		return 0;
+	}
+
+	nm->nm_pool_next = p->mp_free[class - 1];
+	p->mp_free[class - 1] = nm;
+	__atomic_store_n(&p->mp_count[class - 1], p->mp_count[class - 1] + 1,
+			 __ATOMIC_RELAXED);
+
+	return 1;
+}
+
+static void __exit msg_pool_exit(void)
+{
+	struct nl_msg_pool *p, *next;
+
+	for (p = msg_pools; p; p = next) {
+		next = p->mp_next;
+		msg_pool_trim(p, 0);
+#ifndef DISABLE_PTHREADS
+		free(p);
+#endif
+	}
+
+#ifndef DISABLE_PTHREADS
+	msg_pools = NULL;
+	pthread_key_delete(msg_pool_key);
+#endif
+}
+/** @endcond */
+
 static struct nl_msg *__nlmsg_alloc(size_t len)
 {
+	struct nlmsghdr *nlh;
 	struct nl_msg *nm;
+	unsigned int class;
 
 	if (len < sizeof(struct nlmsghdr))
 		len = sizeof(struct nlmsghdr);
 
-	nm = calloc(1, sizeof(*nm));
-	if (!nm)
-		goto errout;
-
-	nm->nm_refcnt = 1;
+	class = msg_pool_class(len);
+
+	nm = msg_pool_get(class);
+	if (nm) {
+		nlh = nm->nm_nlh;
+		memset(nm, 0, sizeof(*nm));
+		nm->nm_nlh = nlh;
+	} else {
+		nm = calloc(1, sizeof(*nm));
+		if (!nm)
+			goto errout;
+
+		/* Only the header is cleared, nlmsg_reserve() and
+		 * nla_reserve() clear whatever is appended. */
+		nm->nm_nlh = malloc(class ? msg_pool_class_size(class) : len);
+		if (!nm->nm_nlh)
+			goto errout;
+	}
 
-	nm->nm_nlh = calloc(1, len);
-	if (!nm->nm_nlh)
-		goto errout;
+	memset(nm->nm_nlh, 0, sizeof(struct nlmsghdr));
 
+	nm->nm_refcnt = 1;
+	nm->nm_pool_class = class;
 	nm->nm_protocol = -1;
 	nm->nm_size = len;
 	nm->nm_nlh->nlmsg_len = nlmsg_total_size(0);
@@ -374,6 +581,64 @@ void nlmsg_set_default_size(size_t max)
 	default_msg_size = max;
 }
 
+/**
+ * Set maximum number of cached messages per size class
+ * @arg limit		Maximum number of messages, 0 disables the pool.
+ *
+ * Freed messages are kept on a free list per size class together with
+ * their payload buffer and handed out again by the allocation functions
+ * without calling malloc() or clearing the buffer. Every thread has free
+ * lists of its own. The limit applies to each of the size classes of
+ * each thread, messages above the limit are freed immediately. Defaults
+ * to 32.
+ *
+ * Messages cached by the calling thread beyond the new limit are freed
+ * right away, those cached by other threads when these free the next
+ * message or exit.
+ *
+ * @see nlmsg_get_pool_stats()
+ */
+void nlmsg_set_pool_limit(unsigned int limit)
+{
+	struct nl_msg_pool *p;
+
+	__atomic_store_n(&msg_pool_limit, limit, __ATOMIC_RELAXED);
+
+	if ((p = msg_pool_this()))
+		msg_pool_trim(p, limit);
+}
+
+/**
+ * Retrieve message pool statistics
+ * @arg stats		Pointer to store statistics in.
+ *
+ * The statistics are the sum over the free lists of all threads.
+ *
+ * @see nlmsg_set_pool_limit()
+ */
+void nlmsg_get_pool_stats(struct nl_msg_pool_stats *stats)
+{
+	struct nl_msg_pool *p;
+	unsigned int i;
+
+	stats->mps_hits = 0;
+	stats->mps_misses = 0;
+	stats->mps_cached = 0;
+
+	nl_lock(&msg_pool_lock);
+	for (p = msg_pools; p; p = p->mp_next) {
+		stats->mps_hits += __atomic_load_n(&p->mp_hits,
+						   __ATOMIC_RELAXED);
+		stats->mps_misses += __atomic_load_n(&p->mp_misses,
+						     __ATOMIC_RELAXED);
+		for (i = 0; i < NL_MSG_POOL_CLASSES; i++)
+			stats->mps_cached +=
+				__atomic_load_n(&p->mp_count[i],
+						__ATOMIC_RELAXED);
+	}
+	nl_unlock(&msg_pool_lock);
+}
+
 /**
  * Convert a netlink message received from a netlink socket to a nl_msg
  * @arg hdr		Netlink message received from netlink socket.
@@ -396,6 +661,122 @@ struct nl_msg *nlmsg_convert(struct nlmsghdr *hdr)
 	return nm;
 }
 
+/**
+ * Create a private copy of a netlink message
+ * @arg msg		Netlink message to copy.
+ *
+ * Allocates a new netlink message and copies the message payload as well
+ * as the protocol, addressing and credentials information of \a msg into
+ * it. This is the recommended way of holding on to a message received
+ * in zero-copy mode (see nl_socket_enable_zero_copy()) beyond the return
+ * of the callback as a reference acquired with nlmsg_get() keeps the whole
+ * receive buffer alive.
+ *
+ * @return Newly allocated netlink message or NULL.
+ */
+struct nl_msg *nlmsg_clone(struct nl_msg *msg)
+{
+	struct nl_msg *nm;
+
+	nm = nlmsg_convert(msg->nm_nlh);
+	if (!nm)
+		return NULL;
+
+	nm->nm_protocol = msg->nm_protocol;
+	nm->nm_flags = msg->nm_flags;
+	nm->nm_src = msg->nm_src;
+	nm->nm_dst = msg->nm_dst;
+	nm->nm_creds = msg->nm_creds;
+
+	return nm;
+}
+
+/** @cond SKIP */
+struct nl_recvbuf *_nl_recvbuf_alloc(unsigned char *data, size_t size)
+{
+	struct nl_recvbuf *rb;
+
+	rb = calloc(1, sizeof(*rb));
+	if (!rb)
+		return NULL;
+
+	rb->rb_data = data;
+	rb->rb_size = size;
+	rb->rb_refcnt = 1;
+
+	return rb;
+}
+
+void _nl_recvbuf_get(struct nl_recvbuf *rb)
+{
+	rb->rb_refcnt++;
+}
+
+void _nl_recvbuf_put(struct nl_recvbuf *rb)
+{
+	if (!rb)
+		return;
+
+	if (rb->rb_refcnt <= 0)
+		BUG();
+
+	if (--rb->rb_refcnt == 0) {
+		if (rb->rb_release)
+			rb->rb_release(rb);
+		else {
+			free(rb->rb_data);
+			free(rb);
+		}
+	}
+}
+
+static void nlmsg_release_payload(struct nl_msg *msg)
+{
+	if (msg->nm_rbuf)
+		_nl_recvbuf_put(msg->nm_rbuf);
+	else
+		free(msg->nm_nlh);
+}
+
+/*
+ * Wraps the netlink message @hdr which is located in the receive buffer @rb
+ * into a struct nl_msg without copying it. The message holds a reference
+ * on @rb for as long as it lives. The reference of the caller on @msg is
+ * consumed, if the caller was the last user, @msg is reused.
+ */
+struct nl_msg *_nlmsg_convert_in_place(struct nl_msg *msg, struct nlmsghdr *hdr,
+				       struct nl_recvbuf *rb)
+{
+	struct nl_recvbuf *old_rb = NULL;
+
+	if (msg && msg->nm_refcnt == 1) {
+		if (msg->nm_rbuf)
+			old_rb = msg->nm_rbuf;
+		else
+			free(msg->nm_nlh);
+		memset(msg, 0, sizeof(*msg));
+	} else {
+		nlmsg_free(msg);
+		msg = calloc(1, sizeof(*msg));
+		if (!msg)
+			return NULL;
+	}
+
+	if (old_rb != rb) {
+		_nl_recvbuf_get(rb);
+		_nl_recvbuf_put(old_rb);
+	}
+
+	msg->nm_refcnt = 1;
+	msg->nm_protocol = -1;
+	msg->nm_nlh = hdr;
+	msg->nm_size = hdr->nlmsg_len;
+	msg->nm_rbuf = rb;
+
+	return msg;
+}
+/** @endcond */
+
 /**
  * Reserve room for additional data in a netlink message
  * @arg n		netlink message
@@ -403,8 +784,8 @@ struct nl_msg *nlmsg_convert(struct nlmsghdr *hdr)
  * @arg pad		number of bytes to align data to
  *
  * Reserves room for additional data at the tail of the an
- * existing netlink message. Eventual padding required will
- * be zeroed out.
+ * existing netlink message. The reserved room including
+ * eventual padding will be zeroed out.
  *
  * @return Pointer to start of additional data tailroom or NULL.
  */
@@ -425,8 +806,7 @@ void *nlmsg_reserve(struct nl_msg *n, size_t len, int pad)
 	buf += nlmsg_len;
 	n->nm_nlh->nlmsg_len += tlen;
 
-	if (tlen > len)
-		memset(buf + len, 0, tlen - len);
+	memset(buf, 0, tlen);
 
 	NL_DBG(2, "msg %p: Reserved %zu (%zu) bytes, pad=%d, nlmsg_len=%d\n",
 		  n, tlen, len, pad, n->nm_nlh->nlmsg_len);
@@ -481,12 +861,33 @@ int nlmsg_expand(struct nl_msg *n, size_t newlen)
 	if (newlen <= n->nm_size)
 		return -NLE_INVAL;
 
-	tmp = realloc(n->nm_nlh, newlen);
-	if (tmp == NULL)
-		return -NLE_NOMEM;
+	if (n->nm_pool_class && newlen <= msg_pool_class_size(n->nm_pool_class)) {
+		/* pooled buffer is large enough already */
+		n->nm_size = newlen;
+		return 0;
+	}
+
+	if (n->nm_rbuf) {
+		/* Message still lives in a shared receive buffer, move it
+		 * into a buffer of its own. */
+		tmp = malloc(newlen);
+		if (tmp == NULL)
+			return -NLE_NOMEM;
+
+		memcpy(tmp, n->nm_nlh, n->nm_nlh->nlmsg_len);
+		_nl_recvbuf_put(n->nm_rbuf);
+		n->nm_rbuf = NULL;
+	} else {
+		tmp = realloc(n->nm_nlh, newlen);
+		if (tmp == NULL)
+			return -NLE_NOMEM;
+	}
 
 	n->nm_nlh = tmp;
 	n->nm_size = newlen;
+	n->nm_pool_class = msg_pool_class(newlen);
+	if (n->nm_pool_class && msg_pool_class_size(n->nm_pool_class) != newlen)
+		n->nm_pool_class = 0;
 
 	return 0;
 }
@@ -575,8 +976,10 @@ void nlmsg_free(struct nl_msg *msg)
 		BUG();
 
 	if (msg->nm_refcnt <= 0) {
-		free(msg->nm_nlh);
 		NL_DBG(2, "msg %p: Freed\n", msg);
+		if (msg_pool_put(msg))
+			return;
+		nlmsg_release_payload(msg);
 		free(msg);
 	}
 }
@@ -230,6 +230,8 @@ errout:
  */
 void nl_close(struct nl_sock *sk)
 {
+	nl_socket_disable_io_uring(sk);
+
 	if (sk->s_fd >= 0) {
 		close(sk->s_fd);
 		sk->s_fd = -1;
@@ -608,86 +610,68 @@ errout:
  * @{
  */
 
-/**
- * Receive data from netlink socket
- * @arg sk		Netlink socket (required)
- * @arg nla		Netlink socket structure to hold address of peer (required)
- * @arg buf		Destination pointer for message content (required)
- * @arg creds		Destination pointer for credentials (optional)
- *
- * Receives data from a connected netlink socket using recvmsg() and returns
- * the number of bytes read. The read data is stored in a newly allocated
- * buffer that is assigned to \c *buf. The peer's netlink address will be
- * stored in \c *nla.
- *
- * This function blocks until data is available to be read unless the socket
- * has been put into non-blocking mode using nl_socket_set_nonblocking() in
- * which case this function will return immediately with a return value of
- * -NLA_AGAIN (versions before 3.2.22 returned instead 0, in which case you
- * should check first clear errno and then check for errno EAGAIN).
- *
- * The buffer size used when reading from the netlink socket and thus limiting
- * the maximum size of a netlink message that can be read defaults to the size
- * of a memory page (getpagesize()). The buffer size can be modified on a per
- * socket level using the function nl_socket_set_msg_buf_size().
- *
- * If message peeking is enabled using nl_socket_enable_msg_peek() the size of
- * the message to be read will be determined using the MSG_PEEK flag prior to
- * performing the actual read. This leads to an additional recvmsg() call for
- * every read operation which has performance implications and is not
- * recommended for high throughput protocols.
- *
- * An eventual interruption of the recvmsg() system call is automatically
- * handled by retrying the operation.
- *
- * If receiving of credentials has been enabled using the function
- * nl_socket_set_passcred(), this function will allocate a new struct ucred
- * filled with the received credentials and assign it to \c *creds. The caller
- * is responsible for freeing the buffer.
- *
- * @note The caller is responsible to free the returned data buffer and if
- *       enabled, the credentials buffer.
- *
- * @see nl_socket_set_nonblocking()
- * @see nl_socket_set_msg_buf_size()
- * @see nl_socket_enable_msg_peek()
- * @see nl_socket_set_passcred()
- *
- * @return Number of bytes read, 0 on EOF, 0 on no data event (non-blocking
- *         mode), or a negative error code.
+/** @cond SKIP */
+/* The kernel builds dump messages of up to 32KiB unless a single message
+ * is larger */
+#define NL_RECV_BUFSIZE_MIN	32768
+
+size_t _nl_socket_recv_bufsize(struct nl_sock *sk)
+{
+	static size_t page_size = 0;
+
+	if (sk->s_bufsize)
+		return sk->s_bufsize;
+
+	if (page_size == 0)
+		page_size = getpagesize() * 4;
+
+	return max_t(size_t, page_size, NL_RECV_BUFSIZE_MIN);
+}
+
+/*
+ * Returns the overflow buffer of the socket, the second part of the I/O
+ * vector when receiving without MSG_PEEK. A datagram which does not fit
+ * into the receive buffer continues in the overflow buffer and is copied
+ * into the enlarged receive buffer, it is neither lost nor read twice.
+ * Not used if a message buffer size has been set explicitly.
  */
-int nl_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
-	    unsigned char **buf, struct ucred **creds)
+static void *recv_overflow(struct nl_sock *sk)
+{
+	if (sk->s_bufsize)
+		return NULL;
+
+	if (!sk->s_overflow)
+		sk->s_overflow = malloc(NL_RECV_OVERFLOW);
+
+	return sk->s_overflow;
+}
+
+/*
+ * Receives a single datagram into the buffer described by @iov. The buffer
+ * must have been allocated with malloc() and is enlarged as needed, @iov is
+ * updated accordingly. The buffer remains owned by the caller, even on
+ * failure.
+ */
+static int __nl_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		     struct iovec *iov, struct ucred **creds)
 {
 	ssize_t n;
-	int flags = 0;
-	static int page_size = 0;
-	struct iovec iov;
+	int flags = MSG_TRUNC;
+	struct iovec vec[2] = { *iov };
 	struct msghdr msg = {
 		.msg_name = (void *) nla,
 		.msg_namelen = sizeof(struct sockaddr_nl),
-		.msg_iov = &iov,
+		.msg_iov = vec,
 		.msg_iovlen = 1,
 	};
 	struct ucred* tmpcreds = NULL;
 	int retval = 0;
 
-	if (!buf || !nla)
-		return -NLE_INVAL;
-
-	if (   (sk->s_flags & NL_MSG_PEEK)
-	    || (!(sk->s_flags & NL_MSG_PEEK_EXPLICIT) && sk->s_bufsize == 0))
-		flags |= MSG_PEEK | MSG_TRUNC;
-
-	if (page_size == 0)
-		page_size = getpagesize() * 4;
-
-	iov.iov_len = sk->s_bufsize ? sk->s_bufsize : page_size;
-	iov.iov_base = malloc(iov.iov_len);
-
-	if (!iov.iov_base) {
-		retval = -NLE_NOMEM;
-		goto abort;
+	if (sk->s_flags & NL_MSG_PEEK)
+		flags |= MSG_PEEK;
+	else if ((vec[1].iov_base = recv_overflow(sk))) {
+		vec[1].iov_len = NL_RECV_OVERFLOW;
+		msg.msg_iovlen = 2;
 	}
 
 	if (creds && (sk->s_flags & NL_SOCK_PASSCRED)) {
@@ -736,32 +720,40 @@ retry:
 		goto retry;
 	}
 
-	if (iov.iov_len < n || (msg.msg_flags & MSG_TRUNC)) {
+	if (iov->iov_len < n || (msg.msg_flags & MSG_TRUNC)) {
+		size_t len = iov->iov_len;
 		void *tmp;
 
-		/* respond with error to an incomplete message */
-		if (flags == 0) {
-			retval = -NLE_MSG_TRUNC;
-			goto abort;
-		}
-
 		/* Provided buffer is not long enough, enlarge it
-		 * to size of n (which should be total length of the message)
-		 * and try again. */
-		iov.iov_len = n;
-		tmp = realloc(iov.iov_base, iov.iov_len);
+		 * to size of n (which is the total length of the message
+		 * thanks to MSG_TRUNC). */
+		tmp = realloc(iov->iov_base, n);
 		if (!tmp) {
 			retval = -NLE_NOMEM;
 			goto abort;
 		}
-		iov.iov_base = tmp;
-		flags = 0;
-		goto retry;
+		iov->iov_base = tmp;
+		iov->iov_len = n;
+		vec[0] = *iov;
+
+		if (msg.msg_iovlen > 1 && !(msg.msg_flags & MSG_TRUNC)) {
+			/* the rest of the message went to the overflow
+			 * buffer */
+			memcpy((char *) tmp + len, vec[1].iov_base, n - len);
+		} else if (!(flags & MSG_PEEK)) {
+			/* respond with error to an incomplete message, the
+			 * enlarged buffer only helps subsequent reads */
+			retval = -NLE_MSG_TRUNC;
+			goto abort;
+		} else {
+			flags &= ~MSG_PEEK;
+			goto retry;
+		}
 	}
 
-	if (flags != 0) {
+	if (flags & MSG_PEEK) {
 		/* Buffer is big enough, do the actual reading */
-		flags = 0;
+		flags &= ~MSG_PEEK;
 		goto retry;
 	}
 
@@ -793,12 +785,9 @@ abort:
 	free(msg.msg_control);
 
 	if (retval <= 0) {
-		free(iov.iov_base);
-		iov.iov_base = NULL;
 		free(tmpcreds);
 		tmpcreds = NULL;
-	} else
-		*buf = iov.iov_base;
+	}
 
 	if (creds)
 		*creds = tmpcreds;
@@ -806,6 +795,320 @@ abort:
 	return retval;
 }
 
+#ifdef HAVE_RECVMMSG
+/*
+ * Returns the buffer of batch slot @i, ready to receive into. Buffers still
+ * referenced by messages received in zero-copy mode are replaced.
+ */
+static struct nl_recvbuf *recv_batch_slot(struct nl_sock *sk, unsigned int i)
+{
+	struct nl_recv_batch *bt = sk->s_batch;
+	struct nl_recvbuf *rb = bt->bt_bufs[i];
+
+	if (rb && rb->rb_refcnt > 1) {
+		_nl_recvbuf_put(rb);
+		rb = bt->bt_bufs[i] = NULL;
+	}
+
+	if (!rb) {
+		size_t size = _nl_socket_recv_bufsize(sk);
+		unsigned char *data;
+
+		data = malloc(size);
+		if (!data)
+			return NULL;
+
+		rb = _nl_recvbuf_alloc(data, size);
+		if (!rb) {
+			free(data);
+			return NULL;
+		}
+
+		bt->bt_bufs[i] = rb;
+	}
+
+	return rb;
+}
+
+static int recv_batch_fill(struct nl_sock *sk)
+{
+	struct nl_recv_batch *bt = sk->s_batch;
+	unsigned int i;
+	int n;
+
+	/* Every slot has its own overflow buffer, see recv_overflow() */
+	if (!sk->s_bufsize && !bt->bt_overflow)
+		bt->bt_overflow = malloc(bt->bt_size * NL_RECV_OVERFLOW);
+
+	for (i = 0; i < bt->bt_size; i++) {
+		struct nl_recvbuf *rb;
+		struct msghdr *hdr = &bt->bt_msgs[i].msg_hdr;
+		struct iovec *iov = &bt->bt_iov[2 * i];
+
+		rb = recv_batch_slot(sk, i);
+		if (!rb)
+			return -NLE_NOMEM;
+
+		iov[0].iov_base = rb->rb_data;
+		iov[0].iov_len = rb->rb_size;
+
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->msg_name = &bt->bt_addrs[i];
+		hdr->msg_namelen = sizeof(struct sockaddr_nl);
+		hdr->msg_iov = iov;
+		hdr->msg_iovlen = 1;
+
+		if (!sk->s_bufsize && bt->bt_overflow) {
+			iov[1].iov_base = bt->bt_overflow +
+					  (size_t) i * NL_RECV_OVERFLOW;
+			iov[1].iov_len = NL_RECV_OVERFLOW;
+			hdr->msg_iovlen = 2;
+		}
+	}
+
+retry:
+	/* Block for the first datagram only, then take what is queued */
+	n = recvmmsg(sk->s_fd, bt->bt_msgs, bt->bt_size,
+		     MSG_WAITFORONE | MSG_TRUNC, NULL);
+	if (n < 0) {
+		if (errno == EINTR) {
+			NL_DBG(3, "recvmmsg() returned EINTR, retrying\n");
+			goto retry;
+		}
+
+		NL_DBG(4, "recv_batch_fill(%p): recvmmsg() failed with %d (%s)\n",
+			sk, errno, nl_strerror_l(errno));
+		return -nl_syserr2nlerr(errno);
+	}
+
+	bt->bt_count = n;
+	bt->bt_next = 0;
+
+	if (n > 0) {
+		bt->bt_stats.rbs_calls++;
+		bt->bt_stats.rbs_datagrams += n;
+		if (n == bt->bt_size)
+			bt->bt_stats.rbs_full++;
+	}
+	bt->bt_stats.rbs_last = n;
+
+	NL_DBG(3, "recv_batch_fill(%p): Received %d datagrams\n", sk, n);
+
+	return n;
+}
+
+/*
+ * Hands out the next datagram of the current batch, receiving a new batch
+ * if all datagrams have been consumed.
+ */
+static int nl_recv_batch(struct nl_sock *sk, struct sockaddr_nl *nla,
+			 struct nl_recvbuf **rbuf)
+{
+	struct nl_recv_batch *bt = sk->s_batch;
+	struct mmsghdr *mm;
+	struct nl_recvbuf *rb;
+	unsigned int i;
+	int err;
+
+	if (bt->bt_next >= bt->bt_count) {
+		err = recv_batch_fill(sk);
+		if (err <= 0)
+			return err;
+	}
+
+	i = bt->bt_next++;
+	mm = &bt->bt_msgs[i];
+	rb = bt->bt_bufs[i];
+
+	if (mm->msg_len == 0)
+		return 0;
+
+	if (mm->msg_len > rb->rb_size || (mm->msg_hdr.msg_flags & MSG_TRUNC)) {
+		size_t len = rb->rb_size;
+		void *tmp;
+
+		/* Enlarge the slot, the rest of the message is taken from
+		 * the overflow buffer. If it did not fit there either, the
+		 * message is lost and the slot only fits subsequent reads. */
+		tmp = realloc(rb->rb_data, mm->msg_len);
+		if (!tmp)
+			return -NLE_NOMEM;
+
+		rb->rb_data = tmp;
+		rb->rb_size = mm->msg_len;
+
+		if (mm->msg_hdr.msg_iovlen < 2 ||
+		    (mm->msg_hdr.msg_flags & MSG_TRUNC))
+			return -NLE_MSG_TRUNC;
+
+		memcpy(rb->rb_data + len, mm->msg_hdr.msg_iov[1].iov_base,
+		       mm->msg_len - len);
+	}
+
+	if (mm->msg_hdr.msg_namelen != sizeof(struct sockaddr_nl))
+		return -NLE_NOADDR;
+
+	*nla = bt->bt_addrs[i];
+	_nl_recvbuf_get(rb);
+	*rbuf = rb;
+
+	return mm->msg_len;
+}
+#endif
+
+/*
+ * Receives a single datagram into the receive buffer owned by the socket.
+ * The buffer is allocated on first use and reused for subsequent reads
+ * unless messages received in zero-copy mode are still referencing it.
+ * On success, a new reference to the buffer is returned in @rbuf.
+ */
+static int nl_recv_sock_buf(struct nl_sock *sk, struct sockaddr_nl *nla,
+			    struct nl_recvbuf **rbuf, struct ucred **creds)
+{
+	struct nl_recvbuf *rb = sk->s_rbuf;
+	struct iovec iov;
+	int n;
+
+	if (sk->s_uring) {
+		if (creds)
+			*creds = NULL;
+		return _nl_uring_recv(sk, nla, rbuf);
+	}
+
+#ifdef HAVE_RECVMMSG
+	/* Datagrams already received in a batch are handed out first */
+	if (sk->s_batch &&
+	    (sk->s_batch->bt_next < sk->s_batch->bt_count ||
+	     !(sk->s_flags & (NL_MSG_PEEK | NL_SOCK_PASSCRED)))) {
+		if (creds)
+			*creds = NULL;
+		return nl_recv_batch(sk, nla, rbuf);
+	}
+#endif
+
+	if (rb && rb->rb_refcnt > 1) {
+		/* still in use by messages, leave it to them */
+		_nl_recvbuf_put(rb);
+		rb = sk->s_rbuf = NULL;
+	}
+
+	if (!rb) {
+		size_t size = _nl_socket_recv_bufsize(sk);
+		unsigned char *data;
+
+		data = malloc(size);
+		if (!data)
+			return -NLE_NOMEM;
+
+		rb = _nl_recvbuf_alloc(data, size);
+		if (!rb) {
+			free(data);
+			return -NLE_NOMEM;
+		}
+
+		sk->s_rbuf = rb;
+	}
+
+	iov.iov_base = rb->rb_data;
+	iov.iov_len = rb->rb_size;
+
+	n = __nl_recv(sk, nla, &iov, creds);
+
+	rb->rb_data = iov.iov_base;
+	rb->rb_size = iov.iov_len;
+
+	if (n > 0) {
+		_nl_recvbuf_get(rb);
+		*rbuf = rb;
+	}
+
+	return n;
+}
+/** @endcond */
+
+/**
+ * Receive data from netlink socket
+ * @arg sk		Netlink socket (required)
+ * @arg nla		Netlink socket structure to hold address of peer (required)
+ * @arg buf		Destination pointer for message content (required)
+ * @arg creds		Destination pointer for credentials (optional)
+ *
+ * Receives data from a connected netlink socket using recvmsg() and returns
+ * the number of bytes read. The read data is stored in a newly allocated
+ * buffer that is assigned to \c *buf. The peer's netlink address will be
+ * stored in \c *nla.
+ *
+ * This function blocks until data is available to be read unless the socket
+ * has been put into non-blocking mode using nl_socket_set_nonblocking() in
+ * which case this function will return immediately with a return value of
+ * -NLA_AGAIN (versions before 3.2.22 returned instead 0, in which case you
+ * should check first clear errno and then check for errno EAGAIN).
+ *
+ * The buffer size used when reading from the netlink socket and thus limiting
+ * the maximum size of a netlink message that can be read defaults to the
+ * larger of 32KiB, which is the largest message size the kernel uses for
+ * dumps, and four memory pages. The buffer size can be modified on a per
+ * socket level using the function nl_socket_set_msg_buf_size().
+ *
+ * If message peeking is enabled using nl_socket_enable_msg_peek() the size of
+ * the message to be read will be determined using the MSG_PEEK flag prior to
+ * performing the actual read. This leads to an additional recvmsg() call for
+ * every read operation which has performance implications and is not
+ * recommended for high throughput protocols. Without message peeking, a
+ * message exceeding the buffer size is received into an overflow buffer by
+ * the same recvmsg() call unless the buffer size has been set explicitly,
+ * see nl_socket_set_msg_buf_size(). A message which still did not fit is
+ * reported as -NLE_MSG_TRUNC.
+ *
+ * An eventual interruption of the recvmsg() system call is automatically
+ * handled by retrying the operation.
+ *
+ * If receiving of credentials has been enabled using the function
+ * nl_socket_set_passcred(), this function will allocate a new struct ucred
+ * filled with the received credentials and assign it to \c *creds. The caller
+ * is responsible for freeing the buffer.
+ *
+ * @note The caller is responsible to free the returned data buffer and if
+ *       enabled, the credentials buffer.
+ *
+ * @note nl_recvmsgs() does not use this function unless overwritten, it
+ *       reads into a buffer owned by the socket which is reused across
+ *       calls.
+ *
+ * @see nl_socket_set_nonblocking()
+ * @see nl_socket_set_msg_buf_size()
+ * @see nl_socket_enable_msg_peek()
+ * @see nl_socket_set_passcred()
+ *
+ * @return Number of bytes read, 0 on EOF, 0 on no data event (non-blocking
+ *         mode), or a negative error code.
+ */
+int nl_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+	    unsigned char **buf, struct ucred **creds)
+{
+	struct iovec iov;
+	int retval;
+
+	if (!buf || !nla)
+		return -NLE_INVAL;
+
+	iov.iov_len = _nl_socket_recv_bufsize(sk);
+	iov.iov_base = malloc(iov.iov_len);
+	if (!iov.iov_base) {
+		if (creds)
+			*creds = NULL;
+		return -NLE_NOMEM;
+	}
+
+	retval = __nl_recv(sk, nla, &iov, creds);
+	if (retval <= 0)
+		free(iov.iov_base);
+	else
+		*buf = iov.iov_base;
+
+	return retval;
+}
+
 /** @cond SKIP */
 #define NL_CB_CALL(cb, type, msg) \
 do { \
@@ -827,6 +1130,7 @@ do { \
 static int recvmsgs(struct nl_sock *sk, struct nl_cb *cb)
 {
 	int n, err = 0, multipart = 0, interrupted = 0, nrecv = 0;
+	int zero_copy = !!(sk->s_flags & NL_MSG_ZERO_COPY);
 	unsigned char *buf = NULL;
 	struct nlmsghdr *hdr;
 
@@ -838,25 +1142,42 @@ static int recvmsgs(struct nl_sock *sk, struct nl_cb *cb)
 	struct sockaddr_nl nla = {0};
 	struct nl_msg *msg = NULL;
 	struct ucred *creds = NULL;
+	struct nl_recvbuf *rbuf = NULL;
 
 continue_reading:
 	NL_DBG(3, "Attempting to read from %p\n", sk);
 	if (cb->cb_recv_ow)
 		n = cb->cb_recv_ow(sk, &nla, &buf, &creds);
 	else
-		n = nl_recv(sk, &nla, &buf, &creds);
+		n = nl_recv_sock_buf(sk, &nla, &rbuf, &creds);
 
 	if (n <= 0)
 		return n;
 
 	NL_DBG(3, "recvmsgs(%p): Read %d bytes\n", sk, n);
 
-	hdr = (struct nlmsghdr *) buf;
+	if (buf && zero_copy) {
+		/* The buffer returned by the overwritten receive function
+		 * is handed over to the messages and released when the last
+		 * of them is freed. */
+		rbuf = _nl_recvbuf_alloc(buf, n);
+		if (!rbuf) {
+			err = -NLE_NOMEM;
+			goto out;
+		}
+		buf = NULL;
+	}
+
+	hdr = (struct nlmsghdr *) (rbuf ? rbuf->rb_data : buf);
 	while (nlmsg_ok(hdr, n)) {
 		NL_DBG(3, "recvmsgs(%p): Processing valid message...\n", sk);
 
-		nlmsg_free(msg);
-		msg = nlmsg_convert(hdr);
+		if (zero_copy)
+			msg = _nlmsg_convert_in_place(msg, hdr, rbuf);
+		else {
+			nlmsg_free(msg);
+			msg = nlmsg_convert(hdr);
+		}
 		if (!msg) {
 			err = -NLE_NOMEM;
 			goto out;
@@ -1014,9 +1335,11 @@ skip:
 	nlmsg_free(msg);
 	free(buf);
 	free(creds);
+	_nl_recvbuf_put(rbuf);
 	buf = NULL;
 	msg = NULL;
 	creds = NULL;
+	rbuf = NULL;
 
 	if (multipart) {
 		/* Multipart message not yet complete, continue reading */
@@ -1028,6 +1351,7 @@ out:
 	nlmsg_free(msg);
 	free(buf);
 	free(creds);
+	_nl_recvbuf_put(rbuf);
 
 	if (interrupted)
 		err = -NLE_DUMP_INTR;
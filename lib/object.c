@@ -59,8 +59,9 @@ struct nl_object *nl_object_alloc(struct nl_object_ops *ops)
 	if (ops->oo_size < sizeof(*new))
 		BUG();
 
-	new = calloc(1, ops->oo_size);
-	if (!new)
+	if ((new = _nl_arena_zalloc(ops->oo_size)))
+		new->ce_flags |= NL_OBJ_ARENA;
+	else if (!(new = calloc(1, ops->oo_size)))
 		return NULL;
 
 	new->ce_refcnt = 1;
@@ -130,6 +131,8 @@ struct nl_object *nl_object_clone(struct nl_object *obj)
 	new->ce_ops = obj->ce_ops;
 	new->ce_msgtype = obj->ce_msgtype;
 	new->ce_mask = obj->ce_mask;
+	new->ce_hash = obj->ce_hash;
+	new->ce_flags |= obj->ce_flags & NL_OBJ_HASH_VALID;
 
 	if (size)
 		memcpy((char *)new + doff, (char *)obj + doff, size);
@@ -188,7 +191,10 @@ void nl_object_free(struct nl_object *obj)
 
 	NL_DBG(4, "Freed object %p\n", obj);
 
-	free(obj);
+	if (obj->ce_flags & NL_OBJ_ARENA)
+		_nl_arena_release(obj);
+	else
+		free(obj);
 }
 
 /** @} */
@@ -204,9 +210,14 @@ void nl_object_free(struct nl_object *obj)
  */
 void nl_object_get(struct nl_object *obj)
 {
-	obj->ce_refcnt++;
+	int refcnt;
+
+	/* Atomic, references are taken concurrently by the parsers of
+	 * address families dumped in parallel and by readers of a cache
+	 * with NL_CACHE_CONCURRENT set while it is being updated. */
+	refcnt = __atomic_add_fetch(&obj->ce_refcnt, 1, __ATOMIC_RELAXED);
 	NL_DBG(4, "New reference to object %p, total %d\n",
-	       obj, obj->ce_refcnt);
+	       obj, refcnt);
 }
 
 /**
@@ -215,17 +226,19 @@ void nl_object_get(struct nl_object *obj)
  */
 void nl_object_put(struct nl_object *obj)
 {
+	int refcnt;
+
 	if (!obj)
 		return;
 
-	obj->ce_refcnt--;
+	refcnt = __atomic_sub_fetch(&obj->ce_refcnt, 1, __ATOMIC_ACQ_REL);
 	NL_DBG(4, "Returned object reference %p, %d remaining\n",
-	       obj, obj->ce_refcnt);
+	       obj, refcnt);
 
-	if (obj->ce_refcnt < 0)
+	if (refcnt < 0)
 		BUG();
 
-	if (obj->ce_refcnt <= 0)
+	if (refcnt <= 0)
 		nl_object_free(obj);
 }
 
@@ -236,7 +249,7 @@ void nl_object_put(struct nl_object *obj)
  */
 int nl_object_shared(struct nl_object *obj)
 {
-	return obj->ce_refcnt > 1;
+	return __atomic_load_n(&obj->ce_refcnt, __ATOMIC_RELAXED) > 1;
 }
 
 /** @} */
@@ -462,16 +475,32 @@ char *nl_object_attr_list(struct nl_object *obj, char *buf, size_t len)
  */
 void nl_object_keygen(struct nl_object *obj, uint32_t *hashkey,
 		      uint32_t hashtbl_sz)
+{
+	*hashkey = _nl_object_hash(obj) % hashtbl_sz;
+}
+
+/** @cond SKIP */
+/*
+ * Returns the full 32 bit hash of the identifying attributes. It is
+ * computed on first use and cached in the object until one of these
+ * attributes is changed, see nl_object_invalidate_hash().
+ */
+uint32_t _nl_object_hash(struct nl_object *obj)
 {
 	struct nl_object_ops *ops = obj_ops(obj);
 
-	if (ops->oo_keygen)
-		ops->oo_keygen(obj, hashkey, hashtbl_sz);
-	else
-		*hashkey = 0;
+	if (!(obj->ce_flags & NL_OBJ_HASH_VALID)) {
+		if (ops->oo_keygen)
+			ops->oo_keygen(obj, &obj->ce_hash, UINT32_MAX);
+		else
+			obj->ce_hash = 0;
+
+		obj->ce_flags |= NL_OBJ_HASH_VALID;
+	}
 
-	return;
+	return obj->ce_hash;
 }
+/** @endcond */
 
 /** @} */
 
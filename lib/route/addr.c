@@ -110,6 +110,7 @@
 #include <netlink-private/netlink.h>
 #include <netlink/netlink.h>
 #include <netlink/route/rtnl.h>
+#include <netlink/hashtable.h>
 #include <netlink/route/addr.h>
 #include <netlink/route/route.h>
 #include <netlink/route/link.h>
@@ -147,11 +148,11 @@ static void addr_free_data(struct nl_object *obj)
 	if (!addr)
 		return;
 
-	nl_addr_put(addr->a_peer);
-	nl_addr_put(addr->a_local);
-	nl_addr_put(addr->a_bcast);
-	nl_addr_put(addr->a_multicast);
-	nl_addr_put(addr->a_anycast);
+	__nl_addr_owner_put(obj, addr->a_peer);
+	__nl_addr_owner_put(obj, addr->a_local);
+	__nl_addr_owner_put(obj, addr->a_bcast);
+	__nl_addr_owner_put(obj, addr->a_multicast);
+	__nl_addr_owner_put(obj, addr->a_anycast);
 	rtnl_link_put(addr->a_link);
 }
 
@@ -166,11 +167,13 @@ static int addr_clone(struct nl_object *_dst, struct nl_object *_src)
 	}
 
 	if (src->a_peer)
-		if (!(dst->a_peer = nl_addr_clone(src->a_peer)))
+		if (!(dst->a_peer = __nl_addr_inline_clone(&dst->a_peer_buf,
+							   _dst, src->a_peer)))
 			return -NLE_NOMEM;
 	
 	if (src->a_local)
-		if (!(dst->a_local = nl_addr_clone(src->a_local)))
+		if (!(dst->a_local = __nl_addr_inline_clone(&dst->a_local_buf,
+							    _dst, src->a_local)))
 			return -NLE_NOMEM;
 
 	if (src->a_bcast)
@@ -194,6 +197,14 @@ static struct nla_policy addr_policy[IFA_MAX+1] = {
 	[IFA_CACHEINFO]	= { .minlen = sizeof(struct ifa_cacheinfo) },
 };
 
+static struct nl_addr *addr_inline_attr(struct rtnl_addr *addr,
+					struct nl_addr_inline *ai,
+					struct nlattr *nla)
+{
+	return __nl_addr_inline_build(ai, OBJ_CAST(addr), addr->a_family,
+				      nla_data(nla), nla_len(nla));
+}
+
 static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 			   struct nlmsghdr *nlh, struct nl_parser_param *pp)
 {
@@ -248,17 +259,23 @@ static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 		/* for IPv4/AF_INET, kernel always sets IFA_LOCAL and IFA_ADDRESS, unless it
 		 * is effectively 0.0.0.0. */
 		if (tb[IFA_LOCAL])
-			addr->a_local = nl_addr_alloc_attr(tb[IFA_LOCAL], family);
+			addr->a_local = addr_inline_attr(addr, &addr->a_local_buf,
+							 tb[IFA_LOCAL]);
 		else
-			addr->a_local = nl_addr_build(family, &null, sizeof (null));
+			addr->a_local = __nl_addr_inline_build(&addr->a_local_buf,
+							       OBJ_CAST(addr), family,
+							       &null, sizeof (null));
 		if (!addr->a_local)
 			goto errout_nomem;
 		addr->ce_mask |= ADDR_ATTR_LOCAL;
 
 		if (tb[IFA_ADDRESS])
-			addr->a_peer = nl_addr_alloc_attr(tb[IFA_ADDRESS], family);
+			addr->a_peer = addr_inline_attr(addr, &addr->a_peer_buf,
+							tb[IFA_ADDRESS]);
 		else
-			addr->a_peer = nl_addr_build(family, &null, sizeof (null));
+			addr->a_peer = __nl_addr_inline_build(&addr->a_peer_buf,
+							      OBJ_CAST(addr), family,
+							      &null, sizeof (null));
 		if (!addr->a_peer)
 			goto errout_nomem;
 
@@ -269,7 +286,7 @@ static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 			 *
 			 * Still, clear the peer and pretend it is unset for backward
 			 * compatibility. */
-			nl_addr_put(addr->a_peer);
+			__nl_addr_owner_put(OBJ_CAST(addr), addr->a_peer);
 			addr->a_peer = NULL;
 		} else
 			addr->ce_mask |= ADDR_ATTR_PEER;
@@ -277,7 +294,8 @@ static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 		plen_addr = addr->a_local;
 	} else {
 		if (tb[IFA_LOCAL]) {
-			addr->a_local = nl_addr_alloc_attr(tb[IFA_LOCAL], family);
+			addr->a_local = addr_inline_attr(addr, &addr->a_local_buf,
+							 tb[IFA_LOCAL]);
 			if (!addr->a_local)
 				goto errout_nomem;
 			addr->ce_mask |= ADDR_ATTR_LOCAL;
@@ -287,7 +305,8 @@ static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 		if (tb[IFA_ADDRESS]) {
 			struct nl_addr *a;
 
-			a = nl_addr_alloc_attr(tb[IFA_ADDRESS], family);
+			a = addr_inline_attr(addr, &addr->a_peer_buf,
+					     tb[IFA_ADDRESS]);
 			if (!a)
 				goto errout_nomem;
 
@@ -295,7 +314,7 @@ static int addr_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 			 * no IFA_LOCAL, IPv4 sends both IFA_LOCAL and IFA_ADDRESS
 			 * with IFA_ADDRESS being the peer address if they differ */
 			if (!tb[IFA_LOCAL] || !nl_addr_cmp(a, addr->a_local)) {
-				nl_addr_put(addr->a_local);
+				__nl_addr_owner_put(OBJ_CAST(addr), addr->a_local);
 				addr->a_local = a;
 				addr->ce_mask |= ADDR_ATTR_LOCAL;
 			} else {
@@ -465,6 +484,32 @@ static void addr_dump_stats(struct nl_object *obj, struct nl_dump_params *p)
 	addr_dump_details(obj, p);
 }
 
+static void addr_keygen(struct nl_object *obj, uint32_t *hashkey,
+			uint32_t table_sz)
+{
+	struct rtnl_addr *addr = (struct rtnl_addr *) obj;
+	struct addr_hash_key {
+		uint32_t	a_family;
+		uint32_t	a_ifindex;
+	} __attribute__((packed)) akey;
+	uint32_t hash;
+
+	akey.a_family = addr->a_family;
+	akey.a_ifindex = addr->a_ifindex;
+
+	/* Prefix length and peer are part of the identity of some
+	 * addresses only, they are left out */
+	hash = nl_hash(&akey, sizeof(akey), 0);
+	if (addr->a_local)
+		hash = nl_hash(nl_addr_get_binary_addr(addr->a_local),
+			       nl_addr_get_len(addr->a_local), hash);
+
+	*hashkey = hash % table_sz;
+
+	NL_DBG(5, "addr %p key (fam %d dev %d) hash 0x%x\n",
+	       addr, akey.a_family, akey.a_ifindex, *hashkey);
+}
+
 static uint32_t addr_id_attrs_get(struct nl_object *obj)
 {
 	struct rtnl_addr *addr = (struct rtnl_addr *)obj;
@@ -596,11 +641,29 @@ int rtnl_addr_alloc_cache(struct nl_sock *sk, struct nl_cache **result)
 struct rtnl_addr *rtnl_addr_get(struct nl_cache *cache, int ifindex,
 				struct nl_addr *addr)
 {
-	struct rtnl_addr *a;
+	struct rtnl_addr *a, *needle;
 
 	if (cache->c_ops != &rtnl_addr_ops)
 		return NULL;
 
+	/* Addresses with a peer are not identified by the local address
+	 * alone and are only found by walking the cache */
+	if (cache->hashtable && ifindex) {
+		if (!(needle = rtnl_addr_alloc()))
+			return NULL;
+
+		rtnl_addr_set_ifindex(needle, ifindex);
+		if (rtnl_addr_set_local(needle, addr) == 0)
+			a = (struct rtnl_addr *) nl_cache_search(cache,
+							OBJ_CAST(needle));
+		else
+			a = NULL;
+		rtnl_addr_put(needle);
+
+		if (a)
+			return a;
+	}
+
 	nl_list_for_each_entry(a, &cache->c_items, ce_list) {
 		if (ifindex && a->a_ifindex != ifindex)
 			continue;
@@ -863,6 +926,7 @@ void rtnl_addr_set_ifindex(struct rtnl_addr *addr, int ifindex)
 {
 	addr->a_ifindex = ifindex;
 	addr->ce_mask |= ADDR_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(addr));
 }
 
 int rtnl_addr_get_ifindex(struct rtnl_addr *addr)
@@ -881,6 +945,7 @@ void rtnl_addr_set_link(struct rtnl_addr *addr, struct rtnl_link *link)
 	addr->a_link = link;
 	addr->a_ifindex = link->l_index;
 	addr->ce_mask |= ADDR_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(addr));
 }
 
 struct rtnl_link *rtnl_addr_get_link(struct rtnl_addr *addr)
@@ -897,6 +962,7 @@ void rtnl_addr_set_family(struct rtnl_addr *addr, int family)
 {
 	addr->a_family = family;
 	addr->ce_mask |= ADDR_ATTR_FAMILY;
+	nl_object_invalidate_hash(OBJ_CAST(addr));
 }
 
 int rtnl_addr_get_family(struct rtnl_addr *addr)
@@ -977,6 +1043,8 @@ unsigned int rtnl_addr_get_flags(struct rtnl_addr *addr)
 static inline int __assign_addr(struct rtnl_addr *addr, struct nl_addr **pos,
 			        struct nl_addr *new, int flag)
 {
+	nl_object_invalidate_hash(OBJ_CAST(addr));
+
 	if (new) {
 		if (addr->ce_mask & ADDR_ATTR_FAMILY) {
 			if (new->a_family != addr->a_family)
@@ -985,13 +1053,13 @@ static inline int __assign_addr(struct rtnl_addr *addr, struct nl_addr **pos,
 			addr->a_family = new->a_family;
 
 		if (*pos)
-			nl_addr_put(*pos);
+			__nl_addr_owner_put(OBJ_CAST(addr), *pos);
 
-		*pos = nl_addr_get(new);
+		*pos = __nl_addr_owner_get(OBJ_CAST(addr), new);
 		addr->ce_mask |= (flag | ADDR_ATTR_FAMILY);
 	} else {
 		if (*pos)
-			nl_addr_put(*pos);
+			__nl_addr_owner_put(OBJ_CAST(addr), *pos);
 
 		*pos = NULL;
 		addr->ce_mask &= ~flag;
@@ -1169,6 +1237,7 @@ static struct nl_object_ops addr_obj_ops = {
 	    [NL_DUMP_STATS]	= addr_dump_stats,
 	},
 	.oo_compare		= addr_compare,
+	.oo_keygen		= addr_keygen,
 	.oo_attrs2str		= addr_attrs2str,
 	.oo_id_attrs_get	= addr_id_attrs_get,
 	.oo_id_attrs		= (ADDR_ATTR_FAMILY | ADDR_ATTR_IFINDEX |
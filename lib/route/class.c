@@ -354,11 +354,25 @@ int rtnl_class_alloc_cache(struct nl_sock *sk, int ifindex,
 struct rtnl_class *rtnl_class_get(struct nl_cache *cache, int ifindex,
 				  uint32_t handle)
 {
-	struct rtnl_class *class;
+	struct rtnl_class *class, *needle;
 	
 	if (cache->c_ops != &rtnl_class_ops)
 		return NULL;
 
+	if (cache->hashtable) {
+		if (!(needle = rtnl_class_alloc()))
+			return NULL;
+
+		rtnl_tc_set_ifindex(TC_CAST(needle), ifindex);
+		rtnl_tc_set_handle(TC_CAST(needle), handle);
+
+		class = (struct rtnl_class *) nl_cache_search(cache,
+							       OBJ_CAST(needle));
+		rtnl_class_put(needle);
+
+		return class;
+	}
+
 	nl_list_for_each_entry(class, &cache->c_items, ce_list) {
 		if (class->c_handle == handle && class->c_ifindex == ifindex) {
 			nl_object_get((struct nl_object *) class);
@@ -473,6 +487,7 @@ static struct nl_object_ops class_obj_ops = {
 	    [NL_DUMP_STATS]	= rtnl_tc_dump_stats,
 	},
 	.oo_compare		= rtnl_tc_compare,
+	.oo_keygen		= rtnl_tc_keygen,
 	.oo_id_attrs		= (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE),
 };
 
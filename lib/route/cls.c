@@ -13,6 +13,12 @@
 /**
  * @ingroup tc
  * @defgroup cls Classifiers
+ *
+ * A classifier handle is only unique per parent, chain, priority and
+ * protocol. All of these identify a classifier along with its interface
+ * index and handle, see nl_object_identical(). A chain, priority or
+ * protocol of zero is not reported by the kernel and only matches
+ * classifiers lacking it as well.
  * @{
  */
 
@@ -413,6 +419,33 @@ static int cls_request_update(struct nl_cache *cache, struct nl_sock *sk)
 			      sizeof(tchdr));
 }
 
+static uint64_t cls_compare(struct nl_object *_a, struct nl_object *_b,
+			    uint64_t attrs, int flags)
+{
+	struct rtnl_cls *a = (struct rtnl_cls *) _a;
+	struct rtnl_cls *b = (struct rtnl_cls *) _b;
+	uint64_t diff;
+
+	diff = rtnl_tc_compare(_a, _b, attrs, flags);
+
+#define CLS_DIFF(ATTR, EXPR) ATTR_DIFF(attrs, ATTR, a, b, EXPR)
+	diff |= CLS_DIFF(TCA_ATTR_CHAIN,	a->c_chain != b->c_chain);
+	diff |= CLS_DIFF(CLS_ATTR_PRIO,		a->c_prio != b->c_prio);
+	diff |= CLS_DIFF(CLS_ATTR_PROTOCOL,	a->c_protocol != b->c_protocol);
+#undef CLS_DIFF
+
+	return diff;
+}
+
+static uint32_t cls_id_attrs_get(struct nl_object *obj)
+{
+	/* Handles are only unique per chain, priority and protocol. These
+	 * are not reported if zero. */
+	return (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE | TCA_ATTR_PARENT) |
+	       (obj->ce_mask & (TCA_ATTR_CHAIN | CLS_ATTR_PRIO |
+				CLS_ATTR_PROTOCOL));
+}
+
 static struct rtnl_tc_type_ops cls_ops = {
 	.tt_type		= RTNL_TC_TYPE_CLS,
 	.tt_dump_prefix		= "cls",
@@ -447,7 +480,9 @@ static struct nl_object_ops cls_obj_ops = {
 	    [NL_DUMP_DETAILS]	= rtnl_tc_dump_details,
 	    [NL_DUMP_STATS]	= rtnl_tc_dump_stats,
 	},
-	.oo_compare		= rtnl_tc_compare,
+	.oo_compare		= cls_compare,
+	.oo_keygen		= rtnl_tc_keygen,
+	.oo_id_attrs_get	= cls_id_attrs_get,
 	.oo_id_attrs		= (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE),
 };
 
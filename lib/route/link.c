@@ -89,6 +89,423 @@ struct rtnl_link *link_lookup(struct nl_cache *cache, int ifindex)
 	return rtnl_link_get(cache, ifindex);
 }
 
+/** @cond SKIP */
+/*
+ * Secondary indexes of the link cache
+ *
+ * Translating interface indices and names is done for every route,
+ * address and neighbour dumped, the link cache therefore keeps a hash
+ * table for each of them, using linear probing. Objects sharing a key,
+ * e.g. the per family entries of a link, are counted in one entry
+ * which points to the first of them, the others are chained to it.
+ *
+ * Lookups in caches with NL_CACHE_CONCURRENT set run concurrently with
+ * updates. Entries are published by their count, tables replaced on
+ * growth are retired and every link found is matched against the key
+ * again.
+ */
+struct link_idx_ent
+{
+	struct rtnl_link *	e_link;
+	uint32_t		e_hash;
+	uint32_t		e_count;
+};
+
+struct link_idx_tab
+{
+	uint32_t		t_mask;
+	struct link_idx_ent	t_ents[];
+};
+
+struct link_idx
+{
+	struct link_idx_tab *	i_tab;
+	uint32_t		i_used;
+	/* chain of links sharing an entry, see rtnl_link::l_idx_next */
+	int			i_chain;
+};
+
+struct link_cache_index
+{
+	struct link_idx		ci_ifindex;
+	struct link_idx		ci_name;
+};
+
+typedef int (*link_idx_match_t)(const struct rtnl_link *, const void *);
+
+static int ifindex_match(const struct rtnl_link *link, const void *key)
+{
+	return link->l_index == *(const int *) key;
+}
+
+static int name_match(const struct rtnl_link *link, const void *key)
+{
+	return !strcmp(link->l_name, key);
+}
+
+static inline uint32_t ifindex_hash(int ifindex)
+{
+	return (uint32_t) ifindex * 2654435761U;
+}
+
+static inline uint32_t name_hash(const char *name)
+{
+	return nl_hash((void *) name, strlen(name), 0);
+}
+
+static inline uint32_t link_idx_count(struct link_idx_ent *ent)
+{
+	return __atomic_load_n(&ent->e_count, __ATOMIC_ACQUIRE);
+}
+
+static inline void link_idx_set(struct link_idx_ent *ent,
+				struct rtnl_link *link, uint32_t hash,
+				uint32_t count)
+{
+	__atomic_store_n(&ent->e_link, link, __ATOMIC_RELAXED);
+	ent->e_hash = hash;
+	__atomic_store_n(&ent->e_count, count, __ATOMIC_RELEASE);
+}
+
+static struct link_idx_ent *link_idx_find(struct link_idx_tab *tab,
+					  uint32_t hash,
+					  link_idx_match_t match,
+					  const void *key)
+{
+	uint32_t i;
+
+	for (i = hash & tab->t_mask; link_idx_count(&tab->t_ents[i]);
+	     i = (i + 1) & tab->t_mask) {
+		struct link_idx_ent *ent = &tab->t_ents[i];
+
+		if (ent->e_hash == hash &&
+		    match(__atomic_load_n(&ent->e_link, __ATOMIC_RELAXED), key))
+			return ent;
+	}
+
+	return NULL;
+}
+
+static struct link_idx_ent *link_idx_slot(struct link_idx_tab *tab,
+					  uint32_t hash)
+{
+	uint32_t i;
+
+	for (i = hash & tab->t_mask; tab->t_ents[i].e_count;
+	     i = (i + 1) & tab->t_mask)
+		;
+
+	return &tab->t_ents[i];
+}
+
+static int link_idx_grow(struct link_idx *idx)
+{
+	struct link_idx_tab *tab, *old = idx->i_tab;
+	uint32_t i, size = old ? (old->t_mask + 1) * 2 : 64;
+
+	tab = calloc(1, sizeof(*tab) + size * sizeof(tab->t_ents[0]));
+	if (!tab)
+		return -NLE_NOMEM;
+
+	tab->t_mask = size - 1;
+
+	if (old) {
+		for (i = 0; i <= old->t_mask; i++)
+			if (old->t_ents[i].e_count)
+				*link_idx_slot(tab, old->t_ents[i].e_hash) =
+					old->t_ents[i];
+	}
+
+	__atomic_store_n(&idx->i_tab, tab, __ATOMIC_RELEASE);
+
+	if (old)
+		__nl_epoch_retire(free, old);
+
+	return 0;
+}
+
+static int link_idx_add(struct link_idx *idx, struct rtnl_link *link,
+			uint32_t hash, link_idx_match_t match, const void *key)
+{
+	struct link_idx_ent *ent;
+	int err;
+
+	if (idx->i_tab && (ent = link_idx_find(idx->i_tab, hash, match, key))) {
+		link->l_idx_next[idx->i_chain] =
+			ent->e_link->l_idx_next[idx->i_chain];
+		ent->e_link->l_idx_next[idx->i_chain] = link;
+		__atomic_store_n(&ent->e_count, ent->e_count + 1,
+				 __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	/* keep load factor below 1/2 */
+	if (!idx->i_tab || (idx->i_used + 1) * 2 > idx->i_tab->t_mask + 1)
+		if ((err = link_idx_grow(idx)) < 0)
+			return err;
+
+	link->l_idx_next[idx->i_chain] = NULL;
+	link_idx_set(link_idx_slot(idx->i_tab, hash), link, hash, 1);
+	idx->i_used++;
+
+	return 0;
+}
+
+static void link_idx_del(struct link_idx *idx, struct rtnl_link *link,
+			 uint32_t hash, link_idx_match_t match, const void *key)
+{
+	struct link_idx_tab *tab = idx->i_tab;
+	struct link_idx_ent *ent;
+	struct rtnl_link *prev;
+	uint32_t i, j, home;
+	int c = idx->i_chain;
+
+	if (!tab || !(ent = link_idx_find(tab, hash, match, key)))
+		return;
+
+	if (ent->e_count > 1) {
+		__atomic_store_n(&ent->e_count, ent->e_count - 1,
+				 __ATOMIC_RELAXED);
+
+		/* the link shares its key with others, unchain it */
+		if (ent->e_link == link) {
+			__atomic_store_n(&ent->e_link, link->l_idx_next[c],
+					 __ATOMIC_RELEASE);
+			return;
+		}
+
+		for (prev = ent->e_link; prev; prev = prev->l_idx_next[c]) {
+			if (prev->l_idx_next[c] == link) {
+				prev->l_idx_next[c] = link->l_idx_next[c];
+				break;
+			}
+		}
+		return;
+	}
+
+	idx->i_used--;
+
+	/* Shift following entries back instead of leaving a tombstone */
+	i = ent - tab->t_ents;
+	for (j = (i + 1) & tab->t_mask; tab->t_ents[j].e_count;
+	     j = (j + 1) & tab->t_mask) {
+		home = tab->t_ents[j].e_hash & tab->t_mask;
+		if (((j - home) & tab->t_mask) >= ((j - i) & tab->t_mask)) {
+			link_idx_set(&tab->t_ents[i], tab->t_ents[j].e_link,
+				     tab->t_ents[j].e_hash,
+				     tab->t_ents[j].e_count);
+			i = j;
+		}
+	}
+
+	__atomic_store_n(&tab->t_ents[i].e_count, 0, __ATOMIC_RELEASE);
+}
+
+static void link_index_destroy(void *arg)
+{
+	struct link_cache_index *ci = arg;
+
+	free(ci->ci_ifindex.i_tab);
+	free(ci->ci_name.i_tab);
+	free(ci);
+}
+
+static void link_index_free(struct nl_cache *cache)
+{
+	struct link_cache_index *ci = cache->c_index;
+
+	if (!ci)
+		return;
+
+	__atomic_store_n(&cache->c_index, NULL, __ATOMIC_RELEASE);
+	__nl_epoch_retire(link_index_destroy, ci);
+}
+
+static int link_index_insert(struct link_cache_index *ci,
+			     struct rtnl_link *link)
+{
+	int err;
+
+	err = link_idx_add(&ci->ci_ifindex, link, ifindex_hash(link->l_index),
+			   ifindex_match, &link->l_index);
+	if (err < 0)
+		return err;
+
+	return link_idx_add(&ci->ci_name, link, name_hash(link->l_name),
+			    name_match, link->l_name);
+}
+
+static void link_index_add(struct nl_cache *cache, struct nl_object *obj)
+{
+	struct link_cache_index *ci = cache->c_index;
+	struct rtnl_link *link;
+
+	if (ci) {
+		if (link_index_insert(ci, (struct rtnl_link *) obj) == 0)
+			return;
+
+		link_index_free(cache);
+	}
+
+	/* The index is (re)built from scratch if it does not exist yet or
+	 * could not be updated, lookups fall back to walking the cache in
+	 * the meantime, or fail for caches with NL_CACHE_CONCURRENT set. */
+	if (!(ci = calloc(1, sizeof(*ci))))
+		return;
+	ci->ci_name.i_chain = 1;
+
+	nl_list_for_each_entry(link, &cache->c_items, ce_list) {
+		if (link_index_insert(ci, link) < 0) {
+			link_index_destroy(ci);
+			return;
+		}
+	}
+
+	__atomic_store_n(&cache->c_index, ci, __ATOMIC_RELEASE);
+}
+
+static void link_index_del(struct nl_cache *cache, struct nl_object *obj)
+{
+	struct link_cache_index *ci = cache->c_index;
+	struct rtnl_link *link = (struct rtnl_link *) obj;
+
+	if (!ci)
+		return;
+
+	link_idx_del(&ci->ci_ifindex, link, ifindex_hash(link->l_index),
+		     ifindex_match, &link->l_index);
+	link_idx_del(&ci->ci_name, link, name_hash(link->l_name),
+		     name_match, link->l_name);
+}
+
+static struct rtnl_link *link_idx_lookup(struct link_idx *idx, uint32_t hash,
+					 link_idx_match_t match,
+					 const void *key)
+{
+	struct link_idx_tab *tab = __atomic_load_n(&idx->i_tab,
+						   __ATOMIC_ACQUIRE);
+	struct link_idx_ent *ent;
+	struct rtnl_link *link;
+
+	if (!tab || !(ent = link_idx_find(tab, hash, match, key)))
+		return NULL;
+
+	/* the entry may have been moved meanwhile */
+	link = __atomic_load_n(&ent->e_link, __ATOMIC_RELAXED);
+	if (!match(link, key))
+		return NULL;
+
+	nl_object_get((struct nl_object *) link);
+
+	return link;
+}
+
+static struct rtnl_link *link_index_lookup(struct nl_cache *cache,
+					   int by_name, uint32_t hash,
+					   link_idx_match_t match,
+					   const void *key)
+{
+	struct link_cache_index *ci;
+	struct rtnl_link *link = NULL;
+	unsigned int seq;
+
+	if (!_nl_cache_is_concurrent(cache)) {
+		ci = cache->c_index;
+		return link_idx_lookup(by_name ? &ci->ci_name : &ci->ci_ifindex,
+				       hash, match, key);
+	}
+
+	if (__nl_epoch_enter() < 0)
+		return NULL;
+
+	do {
+		seq = _nl_cache_read_begin(cache);
+		ci = __atomic_load_n(&cache->c_index, __ATOMIC_ACQUIRE);
+		if (ci)
+			link = link_idx_lookup(by_name ? &ci->ci_name :
+						         &ci->ci_ifindex,
+					       hash, match, key);
+	} while (!link && _nl_cache_read_retry(cache, seq));
+
+	__nl_epoch_exit();
+
+	return link;
+}
+/** @endcond */
+
+/** @cond SKIP */
+/*
+ * Lazy decoding of link attributes
+ *
+ * Links parsed for a cache with NL_CACHE_LAZY_PARSE set keep a copy of
+ * the raw statistics and VF info attributes instead of decoding them.
+ * The protocol info and, for families parsing it as a whole, the address
+ * family specific attributes are kept in a block of their own. Both are
+ * compared raw by link_compare(). A block is shared by all clones of the
+ * link, decoded when any of its sections is accessed first and released
+ * once decoded.
+ */
+struct rtnl_link_lazy
+{
+	int			ll_refcnt;
+	int			ll_family;
+	int			ll_len;
+	char			ll_data[0];
+};
+
+static struct rtnl_link_lazy *link_lazy_alloc(int family, struct nlattr **tb,
+					      const int *types, int ntypes)
+{
+	struct rtnl_link_lazy *ll;
+	int i, len = 0;
+
+	for (i = 0; i < ntypes; i++)
+		if (tb[types[i]])
+			len += nla_total_size(nla_len(tb[types[i]]));
+
+	if (!len || !(ll = calloc(1, sizeof(*ll) + len)))
+		return NULL;
+
+	ll->ll_refcnt = 1;
+	ll->ll_family = family;
+
+	for (i = 0; i < ntypes; i++) {
+		struct nlattr *nla = tb[types[i]];
+
+		if (nla) {
+			memcpy(ll->ll_data + ll->ll_len, nla,
+			       nla_attr_size(nla_len(nla)));
+			ll->ll_len += nla_total_size(nla_len(nla));
+		}
+	}
+
+	return ll;
+}
+
+static int link_lazy_equal(const struct rtnl_link_lazy *a,
+			   const struct rtnl_link_lazy *b)
+{
+	if (!a || !b)
+		return 0;
+
+	return a == b || (a->ll_family == b->ll_family &&
+			  a->ll_len == b->ll_len &&
+			  !memcmp(a->ll_data, b->ll_data, a->ll_len));
+}
+
+static void link_lazy_get(struct rtnl_link_lazy *ll)
+{
+	if (ll)
+		__atomic_add_fetch(&ll->ll_refcnt, 1, __ATOMIC_RELAXED);
+}
+
+static void link_lazy_put(struct rtnl_link_lazy *ll)
+{
+	if (ll && __atomic_sub_fetch(&ll->ll_refcnt, 1, __ATOMIC_ACQ_REL) == 0)
+		free(ll);
+}
+/** @endcond */
+
 static struct rtnl_link_af_ops *af_lookup_and_alloc(struct rtnl_link *link,
 						    int family)
 {
@@ -268,6 +685,11 @@ static void link_free_data(struct nl_object *c)
 	struct rtnl_link *link = nl_object_priv(c);
 
 	if (link) {
+		link_lazy_put(link->l_lazy);
+		link->l_lazy = NULL;
+		link_lazy_put(link->l_lazy_af);
+		link->l_lazy_af = NULL;
+
 		release_link_info(link);
 
 		/* proto info af reference */
@@ -296,6 +718,10 @@ static int link_clone(struct nl_object *_dst, struct nl_object *_src)
 	struct rtnl_link *src = nl_object_priv(_src);
 	int err;
 
+	/* Sections not decoded yet are decoded by each clone on its own */
+	link_lazy_get(src->l_lazy);
+	link_lazy_get(src->l_lazy_af);
+
 	if (src->l_addr)
 		if (!(dst->l_addr = nl_addr_clone(src->l_addr)))
 			return -NLE_NOMEM;
@@ -381,14 +807,8 @@ static struct nla_policy link_info_policy[IFLA_INFO_MAX+1] = {
 	[IFLA_INFO_XSTATS]	= { .type = NLA_NESTED },
 };
 
-int rtnl_link_info_parse(struct rtnl_link *link, struct nlattr **tb)
+static void link_parse_stats(struct rtnl_link *link, struct nlattr **tb)
 {
-	if (tb[IFLA_IFNAME] == NULL)
-		return -NLE_MISSING_ATTR;
-
-	nla_strlcpy(link->l_name, tb[IFLA_IFNAME], IFNAMSIZ);
-
-
 	if (tb[IFLA_STATS]) {
 		struct rtnl_link_stats *st = nla_data(tb[IFLA_STATS]);
 
@@ -476,6 +896,16 @@ int rtnl_link_info_parse(struct rtnl_link *link, struct nlattr **tb)
 
 		link->ce_mask |= LINK_ATTR_STATS;
 	}
+}
+
+int rtnl_link_info_parse(struct rtnl_link *link, struct nlattr **tb)
+{
+	if (tb[IFLA_IFNAME] == NULL)
+		return -NLE_MISSING_ATTR;
+
+	nla_strlcpy(link->l_name, tb[IFLA_IFNAME], IFNAMSIZ);
+
+	link_parse_stats(link, tb);
 
 	if (tb[IFLA_TXQLEN]) {
 		link->l_txqlen = nla_get_u32(tb[IFLA_TXQLEN]);
@@ -577,6 +1007,85 @@ int rtnl_link_info_parse(struct rtnl_link *link, struct nlattr **tb)
 	return 0;
 }
 
+/** @cond SKIP */
+/* Decodes the address family data only, used by its accessors */
+int rtnl_link_lazy_decode_af(struct rtnl_link *link)
+{
+	struct rtnl_link_lazy *ll = link->l_lazy_af;
+	struct rtnl_link_af_ops *af_ops;
+	struct nlattr *tb[IFLA_MAX+1];
+	void *data;
+	int err;
+
+	if (!ll)
+		return 0;
+
+	/* Accessors called while decoding must not decode again */
+	link->l_lazy_af = NULL;
+
+	err = nla_parse(tb, IFLA_MAX, (struct nlattr *) ll->ll_data,
+			ll->ll_len, NULL);
+	if (err < 0 || !(af_ops = af_lookup_and_alloc(link, ll->ll_family)))
+		goto errout;
+
+	data = link->l_af_data[ll->ll_family];
+
+	if (tb[IFLA_PROTINFO] && af_ops->ao_parse_protinfo) {
+		err = af_ops->ao_parse_protinfo(link, tb[IFLA_PROTINFO], data);
+		if (err < 0)
+			goto errout_put;
+		link->ce_mask |= LINK_ATTR_PROTINFO;
+	}
+
+	if (tb[IFLA_AF_SPEC] && af_ops->ao_parse_af_full) {
+		err = af_ops->ao_parse_af_full(link, tb[IFLA_AF_SPEC], data);
+		if (err < 0)
+			goto errout_put;
+		link->ce_mask |= LINK_ATTR_AF_SPEC;
+	}
+
+errout_put:
+	rtnl_link_af_ops_put(af_ops);
+errout:
+	link_lazy_put(ll);
+	return err;
+}
+
+int rtnl_link_lazy_decode(struct rtnl_link *link)
+{
+	struct rtnl_link_lazy *ll = link->l_lazy;
+	struct nlattr *tb[IFLA_MAX+1];
+	int err;
+
+	if (!ll)
+		return rtnl_link_lazy_decode_af(link);
+
+	/* Accessors called while decoding must not decode again */
+	link->l_lazy = NULL;
+
+	err = nla_parse(tb, IFLA_MAX, (struct nlattr *) ll->ll_data,
+			ll->ll_len, NULL);
+	if (err < 0)
+		goto errout;
+
+	link_parse_stats(link, tb);
+
+	if (tb[IFLA_VFINFO_LIST]) {
+		err = rtnl_link_sriov_parse_vflist(link, tb);
+		if (link->l_vf_list)
+			link->ce_mask |= LINK_ATTR_VF_LIST;
+		if (err < 0)
+			goto errout;
+	}
+
+	err = rtnl_link_lazy_decode_af(link);
+
+errout:
+	link_lazy_put(ll);
+	return err;
+}
+/** @endcond */
+
 static int link_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 			   struct nlmsghdr *n, struct nl_parser_param *pp)
 {
@@ -585,6 +1094,7 @@ static int link_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 	struct nlattr *tb[IFLA_MAX+1];
 	struct rtnl_link_af_ops *af_ops = NULL;
 	struct rtnl_link_af_ops *af_ops_family;
+	struct rtnl_link_lazy *ll = NULL, *ll_af = NULL;
 	int err, family;
 	struct nla_policy real_link_policy[IFLA_MAX+1];
 
@@ -627,6 +1137,39 @@ static int link_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 	if (err < 0)
 		goto errout;
 
+	if (pp->pp_flags & NL_CACHE_LAZY_PARSE) {
+		int lazy[3], nlazy = 0, i;
+
+		/* Decoded by rtnl_link_lazy_decode() on first access */
+		lazy[nlazy++] = IFLA_STATS;
+		lazy[nlazy++] = IFLA_STATS64;
+		if (tb[IFLA_NUM_VF] && nla_get_u32(tb[IFLA_NUM_VF]))
+			lazy[nlazy++] = IFLA_VFINFO_LIST;
+
+		if ((ll = link_lazy_alloc(family, tb, lazy, nlazy)))
+			for (i = 0; i < nlazy; i++)
+				tb[lazy[i]] = NULL;
+
+		/* Decoded by rtnl_link_lazy_decode_af() on first access */
+		if (af_ops && af_ops->ao_parse_protinfo) {
+			nlazy = 0;
+			lazy[nlazy++] = IFLA_PROTINFO;
+			if (af_ops->ao_parse_af_full)
+				lazy[nlazy++] = IFLA_AF_SPEC;
+
+			if ((ll_af = link_lazy_alloc(family, tb, lazy, nlazy))) {
+				/* Only decoding is deferred, as for comparing */
+				if (tb[IFLA_PROTINFO])
+					link->ce_mask |= LINK_ATTR_PROTINFO;
+				if (nlazy > 1 && tb[IFLA_AF_SPEC])
+					link->ce_mask |= LINK_ATTR_AF_SPEC;
+
+				for (i = 0; i < nlazy; i++)
+					tb[lazy[i]] = NULL;
+			}
+		}
+	}
+
 	err = rtnl_link_info_parse(link, tb);
 	if (err < 0)
 		goto errout;
@@ -791,8 +1334,15 @@ static int link_msg_parser(struct nl_cache_ops *ops, struct sockaddr_nl *who,
 		link->ce_mask |= LINK_ATTR_PHYS_SWITCH_ID;
 	}
 
+	/* Attached last, accessors used while parsing would decode them */
+	link->l_lazy = ll;
+	link->l_lazy_af = ll_af;
+	ll = ll_af = NULL;
+
 	err = pp->pp_cb((struct nl_object *) link, pp);
 errout:
+	link_lazy_put(ll);
+	link_lazy_put(ll_af);
 	rtnl_link_af_ops_put(af_ops);
 	rtnl_link_put(link);
 	return err;
@@ -844,6 +1394,9 @@ static void link_dump_line(struct nl_object *obj, struct nl_dump_params *p)
 	struct rtnl_link *link = (struct rtnl_link *) obj;
 	int fetched_cache = 0;
 
+	/* Details and statistics are dumped after the line */
+	rtnl_link_lazy_decode(link);
+
 	if (!cache) {
 		cache = nl_cache_mngt_require_safe("route/link");
 		fetched_cache = 1;
@@ -1104,6 +1657,39 @@ static void link_keygen(struct nl_object *obj, uint32_t *hashkey,
 	return;
 }
 
+/*
+ * Links are compared while other threads may read them, the address family
+ * data is never decoded here. Raw data is compared as is, if only one of
+ * the links holds raw data, a private clone of it is decoded.
+ */
+static int link_af_data_compare(struct rtnl_link *a, struct rtnl_link *b)
+{
+	struct rtnl_link *clone = NULL;
+	int ret;
+
+	if (a->l_lazy_af && b->l_lazy_af)
+		return !link_lazy_equal(a->l_lazy_af, b->l_lazy_af);
+
+	if (a->l_lazy_af || b->l_lazy_af) {
+		clone = (struct rtnl_link *)
+			nl_object_clone(OBJ_CAST(a->l_lazy_af ? a : b));
+		if (!clone || rtnl_link_lazy_decode_af(clone) < 0) {
+			rtnl_link_put(clone);
+			return ~0;
+		}
+
+		if (a->l_lazy_af)
+			a = clone;
+		else
+			b = clone;
+	}
+
+	ret = rtnl_link_af_data_compare(a, b, a->l_family);
+	rtnl_link_put(clone);
+
+	return ret;
+}
+
 static uint64_t link_compare(struct nl_object *_a, struct nl_object *_b,
 			     uint64_t attrs, int flags)
 {
@@ -1143,8 +1729,8 @@ static uint64_t link_compare(struct nl_object *_a, struct nl_object *_b,
 	/*
 	 * Compare LINK_ATTR_PROTINFO af_data
 	 */
-	if (a->l_family == b->l_family) {
-		if (rtnl_link_af_data_compare(a, b, a->l_family) != 0)
+	if ((attrs & LINK_ATTR_PROTINFO) && a->l_family == b->l_family) {
+		if (link_af_data_compare(a, b) != 0)
 			goto protinfo_mismatch;
 	}
 
@@ -1309,6 +1895,10 @@ struct rtnl_link *rtnl_link_get(struct nl_cache *cache, int ifindex)
 	if (cache->c_ops != &rtnl_link_ops)
 		return NULL;
 
+	if (cache->c_index || _nl_cache_is_concurrent(cache))
+		return link_index_lookup(cache, 0, ifindex_hash(ifindex),
+					 ifindex_match, &ifindex);
+
 	nl_list_for_each_entry(link, &cache->c_items, ce_list) {
 		if (link->l_index == ifindex) {
 			nl_object_get((struct nl_object *) link);
@@ -1342,6 +1932,10 @@ struct rtnl_link *rtnl_link_get_by_name(struct nl_cache *cache,
 	if (cache->c_ops != &rtnl_link_ops)
 		return NULL;
 
+	if (cache->c_index || _nl_cache_is_concurrent(cache))
+		return link_index_lookup(cache, 1, name_hash(name),
+					 name_match, name);
+
 	nl_list_for_each_entry(link, &cache->c_items, ce_list) {
 		if (!strcmp(name, link->l_name)) {
 			nl_object_get((struct nl_object *) link);
@@ -1584,6 +2178,10 @@ static int build_link_msg(int cmd, struct ifinfomsg *hdr,
 {
 	struct nl_msg *msg;
 	struct nlattr *af_spec;
+	int err;
+
+	if ((err = rtnl_link_lazy_decode(link)) < 0)
+		return err;
 
 	msg = nlmsg_alloc_simple(cmd, flags);
 	if (!msg)
@@ -2121,8 +2719,11 @@ unsigned int rtnl_link_get_flags(struct rtnl_link *link)
  */
 void rtnl_link_set_family(struct rtnl_link *link, int family)
 {
+	rtnl_link_lazy_decode(link);
+
 	link->l_family = family;
 	link->ce_mask |= LINK_ATTR_FAMILY;
+	nl_object_invalidate_hash(OBJ_CAST(link));
 
 	if (link->l_af_ops) {
 		af_free(link, link->l_af_ops,
@@ -2188,6 +2789,7 @@ void rtnl_link_set_ifindex(struct rtnl_link *link, int ifindex)
 {
 	link->l_index = ifindex;
 	link->ce_mask |= LINK_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(link));
 }
 
 
@@ -2528,6 +3130,8 @@ uint64_t rtnl_link_get_stat(struct rtnl_link *link, rtnl_link_stat_id_t id)
 	if (id > RTNL_LINK_STATS_MAX)
 		return 0;
 
+	rtnl_link_lazy_decode(link);
+
 	return link->l_stats[id];
 }
 
@@ -2548,6 +3152,8 @@ int rtnl_link_set_stat(struct rtnl_link *link, rtnl_link_stat_id_t id,
 	if (id > RTNL_LINK_STATS_MAX)
 		return -NLE_INVAL;
 
+	rtnl_link_lazy_decode(link);
+
 	link->l_stats[id] = value;
 
 	return 0;
@@ -3129,6 +3735,8 @@ int rtnl_link_str2carrier(const char *name)
 }
 
 int rtnl_link_has_vf_list(struct rtnl_link *link) {
+	rtnl_link_lazy_decode(link);
+
 	if (link->ce_mask & LINK_ATTR_VF_LIST)
 		return 1;
 	else
@@ -3230,6 +3838,9 @@ static struct nl_cache_ops rtnl_link_ops = {
 	.co_groups		= link_groups,
 	.co_request_update	= link_request_update,
 	.co_msg_parser		= link_msg_parser,
+	.co_index_add		= link_index_add,
+	.co_index_del		= link_index_del,
+	.co_index_free		= link_index_free,
 	.co_obj_ops		= &link_obj_ops,
 };
 
@@ -236,6 +236,8 @@ void *rtnl_link_af_alloc(struct rtnl_link *link,
 
 	family = ops->ao_family;
 
+	rtnl_link_lazy_decode_af(link);
+
 	if (!link->l_af_data[family]) {
 		if (!ops->ao_alloc)
 			BUG();
@@ -267,6 +269,8 @@ void *rtnl_link_af_data(const struct rtnl_link *link,
 	if (!link || !ops)
 		BUG();
 
+	rtnl_link_lazy_decode_af((struct rtnl_link *) link);
+
 	return link->l_af_data[ops->ao_family];
 }
 
@@ -722,6 +722,8 @@ int rtnl_link_vf_add(struct rtnl_link *link, struct rtnl_link_vf *vf_data) {
 	if (!link||!vf_data)
 		return -NLE_OBJ_NOTFOUND;
 
+	rtnl_link_lazy_decode(link);
+
 	if (!link->l_vf_list) {
 		link->l_vf_list = rtnl_link_vf_alloc();
 		if (!link->l_vf_list)
@@ -801,6 +803,8 @@ void rtnl_link_vf_free(struct rtnl_link_vf *vf_data) {
 struct rtnl_link_vf *rtnl_link_vf_get(struct rtnl_link *link, uint32_t vf_num) {
 	struct rtnl_link_vf *list, *vf, *next, *ret = NULL;
 
+	rtnl_link_lazy_decode(link);
+
 	list = link->l_vf_list;
 	nl_list_for_each_entry_safe(vf, next, &list->vf_list, vf_list) {
 		if (vf->vf_index == vf_num) {
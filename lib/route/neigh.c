@@ -183,8 +183,8 @@ static void neigh_free_data(struct nl_object *c)
 	if (!neigh)
 		return;
 
-	nl_addr_put(neigh->n_lladdr);
-	nl_addr_put(neigh->n_dst);
+	__nl_addr_owner_put(c, neigh->n_lladdr);
+	__nl_addr_owner_put(c, neigh->n_dst);
 }
 
 static int neigh_clone(struct nl_object *_dst, struct nl_object *_src)
@@ -193,11 +193,13 @@ static int neigh_clone(struct nl_object *_dst, struct nl_object *_src)
 	struct rtnl_neigh *src = nl_object_priv(_src);
 
 	if (src->n_lladdr)
-		if (!(dst->n_lladdr = nl_addr_clone(src->n_lladdr)))
+		if (!(dst->n_lladdr = __nl_addr_inline_clone(&dst->n_lladdr_buf,
+							     _dst, src->n_lladdr)))
 			return -NLE_NOMEM;
 
 	if (src->n_dst)
-		if (!(dst->n_dst = nl_addr_clone(src->n_dst)))
+		if (!(dst->n_dst = __nl_addr_inline_clone(&dst->n_dst_buf,
+							  _dst, src->n_dst)))
 			return -NLE_NOMEM;
 
 	return 0;
@@ -213,8 +215,8 @@ static void neigh_keygen(struct nl_object *obj, uint32_t *hashkey,
 		uint32_t	n_family;
 		uint32_t	n_ifindex;
 		uint16_t	n_vlan;
-		char		n_addr[0];
-	} __attribute__((packed)) *nkey;
+	} __attribute__((packed)) nkey;
+	uint32_t hash;
 #ifdef NL_DEBUG
 	char buf[INET6_ADDRSTRLEN+5];
 #endif
@@ -226,39 +228,32 @@ static void neigh_keygen(struct nl_object *obj, uint32_t *hashkey,
 		addr = neigh->n_dst;
 	}
 
-	nkey_sz = sizeof(*nkey);
-	if (addr)
-		nkey_sz += nl_addr_get_len(addr);
-
-	nkey = calloc(1, nkey_sz);
-	if (!nkey) {
-		*hashkey = 0;
-		return;
-	}
-	nkey->n_family = neigh->n_family;
+	nkey_sz = sizeof(nkey);
+	memset(&nkey, 0, sizeof(nkey));
+	nkey.n_family = neigh->n_family;
 	if (neigh->n_family == AF_BRIDGE) {
-		nkey->n_vlan = neigh->n_vlan;
+		nkey.n_vlan = neigh->n_vlan;
 		if (neigh->n_flags & NTF_SELF)
-			nkey->n_ifindex = neigh->n_ifindex;
+			nkey.n_ifindex = neigh->n_ifindex;
 		else
-			nkey->n_ifindex = neigh->n_master;
+			nkey.n_ifindex = neigh->n_master;
 	} else
-		nkey->n_ifindex = neigh->n_ifindex;
+		nkey.n_ifindex = neigh->n_ifindex;
 
+	/* The address is hashed separately, seeded with the hash of the
+	 * fixed size part, to avoid allocating a variable sized key. */
+	hash = nl_hash(&nkey, nkey_sz, 0);
 	if (addr)
-		memcpy(nkey->n_addr,
-			nl_addr_get_binary_addr(addr),
-			nl_addr_get_len(addr));
+		hash = nl_hash(nl_addr_get_binary_addr(addr),
+			       nl_addr_get_len(addr), hash);
 
-	*hashkey = nl_hash(nkey, nkey_sz, 0) % table_sz;
+	*hashkey = hash % table_sz;
 
 	NL_DBG(5, "neigh %p key (fam %d dev %d addr %s) keysz %d hash 0x%x\n",
-		neigh, nkey->n_family, nkey->n_ifindex,
+		neigh, nkey.n_family, nkey.n_ifindex,
 		nl_addr2str(addr, buf, sizeof(buf)),
 		nkey_sz, *hashkey);
 
-	free(nkey);
-
 	return;
 }
 
@@ -381,7 +376,10 @@ int rtnl_neigh_parse(struct nlmsghdr *n, struct rtnl_neigh **result)
 			   NEIGH_ATTR_TYPE);
 
 	if (tb[NDA_LLADDR]) {
-		neigh->n_lladdr = nl_addr_alloc_attr(tb[NDA_LLADDR], AF_UNSPEC);
+		neigh->n_lladdr = __nl_addr_inline_build(&neigh->n_lladdr_buf,
+							 OBJ_CAST(neigh), AF_UNSPEC,
+							 nla_data(tb[NDA_LLADDR]),
+							 nla_len(tb[NDA_LLADDR]));
 		if (!neigh->n_lladdr) {
 			err = -NLE_NOMEM;
 			goto errout;
@@ -392,7 +390,10 @@ int rtnl_neigh_parse(struct nlmsghdr *n, struct rtnl_neigh **result)
 	}
 
 	if (tb[NDA_DST]) {
-		neigh->n_dst = nl_addr_alloc_attr(tb[NDA_DST], AF_UNSPEC);
+		neigh->n_dst = __nl_addr_inline_build(&neigh->n_dst_buf,
+						      OBJ_CAST(neigh), AF_UNSPEC,
+						      nla_data(tb[NDA_DST]),
+						      nla_len(tb[NDA_DST]));
 		if (!neigh->n_dst) {
 			err = -NLE_NOMEM;
 			goto errout;
@@ -945,6 +946,7 @@ void rtnl_neigh_set_flags(struct rtnl_neigh *neigh, unsigned int flags)
 	neigh->n_flag_mask |= flags;
 	neigh->n_flags |= flags;
 	neigh->ce_mask |= NEIGH_ATTR_FLAGS;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 unsigned int rtnl_neigh_get_flags(struct rtnl_neigh *neigh)
@@ -957,12 +959,14 @@ void rtnl_neigh_unset_flags(struct rtnl_neigh *neigh, unsigned int flags)
 	neigh->n_flag_mask |= flags;
 	neigh->n_flags &= ~flags;
 	neigh->ce_mask |= NEIGH_ATTR_FLAGS;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 void rtnl_neigh_set_ifindex(struct rtnl_neigh *neigh, int ifindex)
 {
 	neigh->n_ifindex = ifindex;
 	neigh->ce_mask |= NEIGH_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 int rtnl_neigh_get_ifindex(struct rtnl_neigh *neigh)
@@ -984,12 +988,12 @@ static inline int __assign_addr(struct rtnl_neigh *neigh, struct nl_addr **pos,
 	}
 
 	if (*pos)
-		nl_addr_put(*pos);
+		__nl_addr_owner_put(OBJ_CAST(neigh), *pos);
 
-	nl_addr_get(new);
-	*pos = new;
+	*pos = __nl_addr_owner_get(OBJ_CAST(neigh), new);
 
 	neigh->ce_mask |= flag;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 
 	return 0;
 }
@@ -1025,6 +1029,7 @@ void rtnl_neigh_set_family(struct rtnl_neigh *neigh, int family)
 {
 	neigh->n_family = family;
 	neigh->ce_mask |= NEIGH_ATTR_FAMILY;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 int rtnl_neigh_get_family(struct rtnl_neigh *neigh)
@@ -1050,6 +1055,7 @@ void rtnl_neigh_set_vlan(struct rtnl_neigh *neigh, int vlan)
 {
 	neigh->n_vlan = vlan;
 	neigh->ce_mask |= NEIGH_ATTR_VLAN;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 int rtnl_neigh_get_vlan(struct rtnl_neigh *neigh)
@@ -1064,6 +1070,7 @@ void rtnl_neigh_set_master(struct rtnl_neigh *neigh, int ifindex)
 {
 	neigh->n_master = ifindex;
 	neigh->ce_mask |= NEIGH_ATTR_MASTER;
+	nl_object_invalidate_hash(OBJ_CAST(neigh));
 }
 
 int rtnl_neigh_get_master(struct rtnl_neigh *neigh) {
@@ -789,6 +789,9 @@ void rtnl_neightbl_set_locktime(struct rtnl_neightbl *ntbl, uint64_t ms)
 
 /** @} */
 
+/* Without oo_id_attrs, tables are compared by the attributes present in
+ * both, leaving nothing to hash consistently. The cache holds a few
+ * tables and their per device parameters and is walked instead. */
 static struct nl_object_ops neightbl_obj_ops = {
 	.oo_name		= "route/neightbl",
 	.oo_size		= sizeof(struct rtnl_neightbl),
@@ -420,11 +420,26 @@ struct rtnl_qdisc *rtnl_qdisc_get_by_parent(struct nl_cache *cache,
 struct rtnl_qdisc *rtnl_qdisc_get(struct nl_cache *cache, int ifindex,
 				  uint32_t handle)
 {
-	struct rtnl_qdisc *q;
+	struct rtnl_qdisc *q, *needle;
 
 	if (cache->c_ops != &rtnl_qdisc_ops)
 		return NULL;
 
+	/* Qdiscs without handle are only identified by their parent */
+	if (cache->hashtable && handle) {
+		if (!(needle = rtnl_qdisc_alloc()))
+			return NULL;
+
+		rtnl_tc_set_ifindex(TC_CAST(needle), ifindex);
+		rtnl_tc_set_handle(TC_CAST(needle), handle);
+
+		q = (struct rtnl_qdisc *) nl_cache_search(cache,
+							  OBJ_CAST(needle));
+		rtnl_qdisc_put(needle);
+
+		return q;
+	}
+
 	nl_list_for_each_entry(q, &cache->c_items, ce_list) {
 		if (q->q_handle == handle && q->q_ifindex == ifindex) {
 			nl_object_get((struct nl_object *) q);
@@ -532,6 +547,19 @@ static struct rtnl_tc_type_ops qdisc_ops = {
 	},
 };
 
+static uint32_t qdisc_id_attrs_get(struct nl_object *obj)
+{
+	struct rtnl_qdisc *qdisc = (struct rtnl_qdisc *) obj;
+
+	/* Handles are unique per device, except for the handle 0 of the
+	 * default qdiscs attached to every parent, e.g. of each queue of
+	 * a multiqueue device. */
+	if (qdisc->q_handle)
+		return (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE);
+
+	return (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE | TCA_ATTR_PARENT);
+}
+
 static struct nl_cache_ops rtnl_qdisc_ops = {
 	.co_name		= "route/qdisc",
 	.co_hdrsize		= sizeof(struct tcmsg),
@@ -559,6 +587,8 @@ static struct nl_object_ops qdisc_obj_ops = {
 	    [NL_DUMP_STATS]	= rtnl_tc_dump_stats,
 	},
 	.oo_compare		= rtnl_tc_compare,
+	.oo_keygen		= rtnl_tc_keygen,
+	.oo_id_attrs_get	= qdisc_id_attrs_get,
 	.oo_id_attrs		= (TCA_ATTR_IFINDEX | TCA_ATTR_HANDLE),
 };
 
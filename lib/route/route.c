@@ -55,6 +55,453 @@ static int route_request_update(struct nl_cache *c, struct nl_sock *h)
 	return nl_send_simple(h, RTM_GETROUTE, NLM_F_DUMP, &rhdr, sizeof(rhdr));
 }
 
+/** @cond SKIP */
+/*
+ * Longest prefix match index of the route cache
+ *
+ * Routes are kept in a path compressed binary trie per routing table and
+ * family, keyed by destination prefix. A node exists for every prefix in
+ * use and wherever the paths to two prefixes diverge, lookups therefore
+ * visit at most one node per distinct prefix length on the path. Routes
+ * sharing a prefix are listed in their node ordered by priority.
+ *
+ * Routes with a TOS or a source prefix are not indexed, a lookup matches
+ * what the kernel would return for TOS 0 and any source.
+ *
+ * Lookups in caches with NL_CACHE_CONCURRENT set run concurrently with
+ * updates. Prefix and length of a node never change once it is linked,
+ * nodes and entries unlinked are retired and a lookup overlapping with
+ * an update is repeated.
+ */
+#define ROUTE_TRIE_KEYLEN	16
+
+struct route_trie_ent
+{
+	struct rtnl_route *	e_route;
+	struct route_trie_ent *	e_next;
+};
+
+struct route_trie_node
+{
+	struct route_trie_node *n_child[2];
+	struct route_trie_ent *	n_routes;
+	unsigned int		n_len;
+	uint8_t			n_key[ROUTE_TRIE_KEYLEN];
+};
+
+struct route_trie
+{
+	struct route_trie *	t_next;
+	struct route_trie_node *t_root;
+	uint32_t		t_table;
+	uint8_t			t_family;
+};
+
+struct route_cache_index
+{
+	struct route_trie *	ci_tries;
+};
+
+static inline int trie_bit(const uint8_t *key, unsigned int pos)
+{
+	return (key[pos >> 3] >> (7 - (pos & 7))) & 1;
+}
+
+/* Number of leading bits a and b have in common, at most len */
+static unsigned int trie_common(const uint8_t *a, const uint8_t *b,
+				unsigned int len)
+{
+	unsigned int i, n;
+
+	for (i = 0; i < len; i += 8) {
+		if ((n = a[i >> 3] ^ b[i >> 3]) != 0) {
+			i += __builtin_clz(n) - 24;
+			break;
+		}
+	}
+
+	return i < len ? i : len;
+}
+
+static inline struct route_trie_node *trie_load(struct route_trie_node **p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void trie_publish(struct route_trie_node **p,
+				struct route_trie_node *node)
+{
+	__atomic_store_n(p, node, __ATOMIC_RELEASE);
+}
+
+/* Returns the prefix length of the route or -1 if it is not indexed */
+static int route_trie_key(struct rtnl_route *route, uint8_t *key)
+{
+	struct nl_addr *dst = route->rt_dst;
+	unsigned int len, alen;
+
+	if (!dst || route->rt_tos ||
+	    (route->rt_src && nl_addr_get_prefixlen(route->rt_src)))
+		return -1;
+
+	len = nl_addr_get_prefixlen(dst);
+	alen = nl_addr_get_len(dst);
+	if (len > ROUTE_TRIE_KEYLEN * 8 || alen > ROUTE_TRIE_KEYLEN)
+		return -1;
+
+	if (alen > (len + 7) / 8)
+		alen = (len + 7) / 8;
+
+	memset(key, 0, ROUTE_TRIE_KEYLEN);
+	memcpy(key, nl_addr_get_binary_addr(dst), alen);
+
+	/* clear host bits */
+	if (len % 8 && alen > len / 8)
+		key[len / 8] &= 0xff << (8 - len % 8);
+
+	return len;
+}
+
+static struct route_trie_node *trie_node_alloc(const uint8_t *key,
+					       unsigned int len)
+{
+	struct route_trie_node *node;
+
+	if (!(node = calloc(1, sizeof(*node))))
+		return NULL;
+
+	node->n_len = len;
+	memcpy(node->n_key, key, (len + 7) / 8);
+	if (len % 8)
+		node->n_key[len / 8] &= 0xff << (8 - len % 8);
+
+	return node;
+}
+
+static void route_trie_retire(struct nl_cache *cache, void *ptr)
+{
+	if (_nl_cache_is_concurrent(cache))
+		__nl_epoch_retire(free, ptr);
+	else
+		free(ptr);
+}
+
+static void trie_node_destroy(struct route_trie_node *node)
+{
+	struct route_trie_ent *ent, *next;
+
+	if (!node)
+		return;
+
+	trie_node_destroy(node->n_child[0]);
+	trie_node_destroy(node->n_child[1]);
+
+	for (ent = node->n_routes; ent; ent = next) {
+		next = ent->e_next;
+		free(ent);
+	}
+
+	free(node);
+}
+
+static struct route_trie *route_trie_get(struct route_cache_index *ci,
+					 uint32_t table, uint8_t family)
+{
+	struct route_trie *t;
+
+	for (t = __atomic_load_n(&ci->ci_tries, __ATOMIC_ACQUIRE); t;
+	     t = t->t_next)
+		if (t->t_table == table && t->t_family == family)
+			return t;
+
+	return NULL;
+}
+
+/* Links an entry for the route into the node, behind routes of equal
+ * or better priority */
+static int trie_node_add_route(struct route_trie_node *node,
+			       struct rtnl_route *route)
+{
+	struct route_trie_ent *ent, **pp;
+
+	if (!(ent = calloc(1, sizeof(*ent))))
+		return -NLE_NOMEM;
+
+	ent->e_route = route;
+
+	for (pp = &node->n_routes; *pp; pp = &(*pp)->e_next)
+		if ((*pp)->e_route->rt_prio > route->rt_prio)
+			break;
+
+	ent->e_next = *pp;
+	__atomic_store_n(pp, ent, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static int route_trie_insert(struct route_cache_index *ci,
+			     struct rtnl_route *route)
+{
+	struct route_trie_node **pp, *n, *node, *glue;
+	struct route_trie *t;
+	uint8_t key[ROUTE_TRIE_KEYLEN];
+	unsigned int common;
+	int len;
+
+	if ((len = route_trie_key(route, key)) < 0)
+		return 0;
+
+	if (!(t = route_trie_get(ci, route->rt_table, route->rt_family))) {
+		if (!(t = calloc(1, sizeof(*t))))
+			return -NLE_NOMEM;
+
+		t->t_table = route->rt_table;
+		t->t_family = route->rt_family;
+		t->t_next = ci->ci_tries;
+		__atomic_store_n(&ci->ci_tries, t, __ATOMIC_RELEASE);
+	}
+
+	for (pp = &t->t_root; (n = *pp); pp = &n->n_child[trie_bit(key, n->n_len)]) {
+		common = trie_common(key, n->n_key,
+				     n->n_len < len ? n->n_len : len);
+
+		if (common == n->n_len) {
+			if (n->n_len == len)
+				return trie_node_add_route(n, route);
+			continue;
+		}
+
+		/* The prefix diverges from or is shorter than the one of
+		 * the node, a new node takes the place of the node. */
+		if (!(node = trie_node_alloc(key, len)))
+			return -NLE_NOMEM;
+
+		if (trie_node_add_route(node, route) < 0) {
+			free(node);
+			return -NLE_NOMEM;
+		}
+
+		if (common == len) {
+			node->n_child[trie_bit(n->n_key, len)] = n;
+			trie_publish(pp, node);
+			return 0;
+		}
+
+		if (!(glue = trie_node_alloc(key, common))) {
+			trie_node_destroy(node);
+			return -NLE_NOMEM;
+		}
+
+		glue->n_child[trie_bit(key, common)] = node;
+		glue->n_child[trie_bit(n->n_key, common)] = n;
+		trie_publish(pp, glue);
+		return 0;
+	}
+
+	if (!(node = trie_node_alloc(key, len)))
+		return -NLE_NOMEM;
+
+	if (trie_node_add_route(node, route) < 0) {
+		free(node);
+		return -NLE_NOMEM;
+	}
+
+	trie_publish(pp, node);
+
+	return 0;
+}
+
+static void route_trie_remove(struct nl_cache *cache,
+			      struct route_cache_index *ci,
+			      struct rtnl_route *route)
+{
+	struct route_trie_node **pp, **parent = NULL, *n;
+	struct route_trie_ent **ep, *ent;
+	struct route_trie *t;
+	uint8_t key[ROUTE_TRIE_KEYLEN];
+	int len;
+
+	if ((len = route_trie_key(route, key)) < 0 ||
+	    !(t = route_trie_get(ci, route->rt_table, route->rt_family)))
+		return;
+
+	for (pp = &t->t_root; (n = *pp); pp = &n->n_child[trie_bit(key, n->n_len)]) {
+		if (n->n_len >= len ||
+		    trie_common(key, n->n_key, n->n_len) != n->n_len)
+			break;
+		parent = pp;
+	}
+
+	if (!n || n->n_len != len || memcmp(n->n_key, key, sizeof(key)))
+		return;
+
+	for (ep = &n->n_routes; (ent = *ep); ep = &ent->e_next)
+		if (ent->e_route == route)
+			break;
+
+	if (!ent)
+		return;
+
+	__atomic_store_n(ep, ent->e_next, __ATOMIC_RELEASE);
+	route_trie_retire(cache, ent);
+
+	if (n->n_routes)
+		return;
+
+	/* Nodes without routes are only kept where two paths diverge */
+	if (n->n_child[0] && n->n_child[1])
+		return;
+
+	trie_publish(pp, n->n_child[0] ? n->n_child[0] : n->n_child[1]);
+	route_trie_retire(cache, n);
+
+	if (!parent || *pp)
+		return;
+
+	n = *parent;
+	if (n->n_routes)
+		return;
+
+	trie_publish(parent, n->n_child[0] ? n->n_child[0] : n->n_child[1]);
+	route_trie_retire(cache, n);
+}
+
+static void route_index_destroy(void *arg)
+{
+	struct route_cache_index *ci = arg;
+	struct route_trie *t, *next;
+
+	for (t = ci->ci_tries; t; t = next) {
+		next = t->t_next;
+		trie_node_destroy(t->t_root);
+		free(t);
+	}
+
+	free(ci);
+}
+
+static void route_index_free(struct nl_cache *cache)
+{
+	struct route_cache_index *ci = cache->c_index;
+
+	if (!ci)
+		return;
+
+	__atomic_store_n(&cache->c_index, NULL, __ATOMIC_RELEASE);
+	__nl_epoch_retire(route_index_destroy, ci);
+}
+
+/*
+ * Built from scratch like the link cache index, lookups walk the cache
+ * while there is none.
+ */
+static struct route_cache_index *route_index_build(struct nl_cache *cache)
+{
+	struct route_cache_index *ci;
+	struct rtnl_route *route;
+
+	if (!(ci = calloc(1, sizeof(*ci))))
+		return NULL;
+
+	nl_list_for_each_entry(route, &cache->c_items, ce_list) {
+		if (route_trie_insert(ci, route) < 0) {
+			route_index_destroy(ci);
+			return NULL;
+		}
+	}
+
+	__atomic_store_n(&cache->c_index, ci, __ATOMIC_RELEASE);
+
+	return ci;
+}
+
+static void route_index_add(struct nl_cache *cache, struct nl_object *obj)
+{
+	struct route_cache_index *ci = cache->c_index;
+
+	if (ci) {
+		if (route_trie_insert(ci, (struct rtnl_route *) obj) == 0)
+			return;
+
+		route_index_free(cache);
+	}
+
+	/* The index is only built by the first lookup, unless lookups may
+	 * come from other threads, which cannot build it. */
+	if (_nl_cache_is_concurrent(cache))
+		route_index_build(cache);
+}
+
+static void route_index_del(struct nl_cache *cache, struct nl_object *obj)
+{
+	struct route_cache_index *ci = cache->c_index;
+
+	if (ci)
+		route_trie_remove(cache, ci, (struct rtnl_route *) obj);
+}
+
+static struct rtnl_route *route_trie_lookup(struct route_cache_index *ci,
+					    uint32_t table, uint8_t family,
+					    const uint8_t *key,
+					    unsigned int maxlen)
+{
+	struct route_trie_node *n;
+	struct route_trie_ent *ent, *best = NULL;
+	struct route_trie *t;
+	struct rtnl_route *route;
+
+	if (!(t = route_trie_get(ci, table, family)))
+		return NULL;
+
+	for (n = trie_load(&t->t_root); n && n->n_len <= maxlen;
+	     n = trie_load(&n->n_child[trie_bit(key, n->n_len)])) {
+		if (trie_common(key, n->n_key, n->n_len) != n->n_len)
+			break;
+
+		if ((ent = __atomic_load_n(&n->n_routes, __ATOMIC_ACQUIRE)))
+			best = ent;
+
+		if (n->n_len == maxlen)
+			break;
+	}
+
+	if (!best)
+		return NULL;
+
+	route = best->e_route;
+	nl_object_get((struct nl_object *) route);
+
+	return route;
+}
+
+static struct rtnl_route *route_walk_lookup(struct nl_cache *cache,
+					    uint32_t table, uint8_t family,
+					    const uint8_t *key, int maxlen)
+{
+	struct rtnl_route *route, *best = NULL;
+	uint8_t rkey[ROUTE_TRIE_KEYLEN];
+	int len, best_len = -1;
+
+	nl_list_for_each_entry(route, &cache->c_items, ce_list) {
+		if (route->rt_table != table || route->rt_family != family ||
+		    (len = route_trie_key(route, rkey)) < 0 || len > maxlen ||
+		    trie_common(key, rkey, len) != len)
+			continue;
+
+		if (len > best_len ||
+		    (len == best_len && route->rt_prio < best->rt_prio)) {
+			best = route;
+			best_len = len;
+		}
+	}
+
+	if (best)
+		nl_object_get((struct nl_object *) best);
+
+	return best;
+}
+/** @endcond */
+
 /**
  * @name Cache Management
  * @{
@@ -99,6 +546,76 @@ int rtnl_route_alloc_cache(struct nl_sock *sk, int family, int flags,
 	return 0;
 }
 
+/**
+ * Lookup the route to an address in a route cache
+ * @arg cache		Route cache
+ * @arg table		Routing table
+ * @arg addr		Address
+ *
+ * Searches the routes of the table and of the family of \c addr for the
+ * one with the longest destination prefix matching \c addr. Of multiple
+ * routes to the same prefix, the one with the lowest priority is chosen.
+ * Routes with a TOS or a source prefix are not considered.
+ *
+ * The route cache keeps a prefix trie per table and family to answer
+ * lookups without walking the cache. The tries are built by the first
+ * lookup and kept up to date as the cache changes from then on. With
+ * `NL_CACHE_CONCURRENT` set on the cache, lookups may be done from any
+ * thread while the cache is being updated, the tries are then kept for
+ * every change of the cache and the flag must be set before the cache
+ * is filled.
+ *
+ * @note The reference counter of the returned route is incremented, it
+ *       must be given back with rtnl_route_put() after use.
+ * @return Route or NULL if no route matches.
+ */
+struct rtnl_route *rtnl_route_lookup(struct nl_cache *cache, uint32_t table,
+				     struct nl_addr *addr)
+{
+	struct route_cache_index *ci;
+	struct rtnl_route *route = NULL;
+	uint8_t key[ROUTE_TRIE_KEYLEN] = { 0 };
+	unsigned int alen, seq;
+	uint8_t family;
+
+	if (cache->c_ops != &rtnl_route_ops)
+		return NULL;
+
+	family = nl_addr_get_family(addr);
+	alen = nl_addr_get_len(addr);
+	if (alen > ROUTE_TRIE_KEYLEN)
+		return NULL;
+
+	memcpy(key, nl_addr_get_binary_addr(addr), alen);
+
+	if (!_nl_cache_is_concurrent(cache)) {
+		if (!(ci = cache->c_index) && !(ci = route_index_build(cache)))
+			return route_walk_lookup(cache, table, family, key,
+						 alen * 8);
+
+		return route_trie_lookup(ci, table, family, key, alen * 8);
+	}
+
+	if (__nl_epoch_enter() < 0)
+		return NULL;
+
+	/* A lookup overlapping with an update, e.g. the replacement of a
+	 * route, may find a less specific route and is repeated. */
+	do {
+		if (route)
+			rtnl_route_put(route);
+
+		seq = _nl_cache_read_begin(cache);
+		ci = __atomic_load_n(&cache->c_index, __ATOMIC_ACQUIRE);
+		route = ci ? route_trie_lookup(ci, table, family, key, alen * 8)
+			   : NULL;
+	} while (_nl_cache_read_retry(cache, seq));
+
+	__nl_epoch_exit();
+
+	return route;
+}
+
 /** @} */
 
 /**
@@ -192,6 +709,9 @@ static struct nl_cache_ops rtnl_route_ops = {
 	.co_groups		= route_groups,
 	.co_request_update	= route_request_update,
 	.co_msg_parser		= route_msg_parser,
+	.co_index_add		= route_index_add,
+	.co_index_del		= route_index_del,
+	.co_index_free		= route_index_free,
 	.co_obj_ops		= &route_obj_ops,
 };
 
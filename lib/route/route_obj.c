@@ -89,9 +89,9 @@ static void route_free_data(struct nl_object *c)
 	if (r == NULL)
 		return;
 
-	nl_addr_put(r->rt_dst);
-	nl_addr_put(r->rt_src);
-	nl_addr_put(r->rt_pref_src);
+	__nl_addr_owner_put(c, r->rt_dst);
+	__nl_addr_owner_put(c, r->rt_src);
+	__nl_addr_owner_put(c, r->rt_pref_src);
 
 	nl_list_for_each_entry_safe(nh, tmp, &r->rt_nexthops, rtnh_list) {
 		rtnl_route_remove_nexthop(r, nh);
@@ -106,7 +106,8 @@ static int route_clone(struct nl_object *_dst, struct nl_object *_src)
 	struct rtnl_nexthop *nh, *new;
 
 	if (src->rt_dst)
-		if (!(dst->rt_dst = nl_addr_clone(src->rt_dst)))
+		if (!(dst->rt_dst = __nl_addr_inline_clone(&dst->rt_dst_buf,
+							   _dst, src->rt_dst)))
 			return -NLE_NOMEM;
 
 	if (src->rt_src)
@@ -114,7 +115,9 @@ static int route_clone(struct nl_object *_dst, struct nl_object *_src)
 			return -NLE_NOMEM;
 
 	if (src->rt_pref_src)
-		if (!(dst->rt_pref_src = nl_addr_clone(src->rt_pref_src)))
+		if (!(dst->rt_pref_src = __nl_addr_inline_clone(&dst->rt_pref_src_buf,
+								_dst,
+								src->rt_pref_src)))
 			return -NLE_NOMEM;
 
 	/* Will be inc'ed again while adding the nexthops of the source */
@@ -315,8 +318,8 @@ static void route_keygen(struct nl_object *obj, uint32_t *hashkey,
 		uint8_t		rt_tos;
 		uint32_t	rt_table;
 		uint32_t	rt_prio;
-		char 		rt_addr[0];
-	} __attribute__((packed)) *rkey;
+	} __attribute__((packed)) rkey;
+	uint32_t hash;
 #ifdef NL_DEBUG
 	char buf[INET6_ADDRSTRLEN+5];
 #endif
@@ -324,32 +327,26 @@ static void route_keygen(struct nl_object *obj, uint32_t *hashkey,
 	if (route->rt_dst)
 		addr = route->rt_dst;
 
-	rkey_sz = sizeof(*rkey);
-	if (addr)
-		rkey_sz += nl_addr_get_len(addr);
-	rkey = calloc(1, rkey_sz);
-	if (!rkey) {
-		NL_DBG(2, "Warning: calloc failed for %d bytes...\n", rkey_sz);
-		*hashkey = 0;
-		return;
-	}
-	rkey->rt_family = route->rt_family;
-	rkey->rt_tos = route->rt_tos;
-	rkey->rt_table = route->rt_table;
-	rkey->rt_prio = route->rt_prio;
+	rkey_sz = sizeof(rkey);
+	rkey.rt_family = route->rt_family;
+	rkey.rt_tos = route->rt_tos;
+	rkey.rt_table = route->rt_table;
+	rkey.rt_prio = route->rt_prio;
+
+	/* The destination is hashed separately, seeded with the hash of the
+	 * fixed size part, to avoid allocating a variable sized key. */
+	hash = nl_hash(&rkey, rkey_sz, 0);
 	if (addr)
-		memcpy(rkey->rt_addr, nl_addr_get_binary_addr(addr),
-			nl_addr_get_len(addr));
+		hash = nl_hash(nl_addr_get_binary_addr(addr),
+			       nl_addr_get_len(addr), hash);
 
-	*hashkey = nl_hash(rkey, rkey_sz, 0) % table_sz;
+	*hashkey = hash % table_sz;
 
 	NL_DBG(5, "route %p key (fam %d tos %d table %d addr %s) keysz %d "
-		"hash 0x%x\n", route, rkey->rt_family, rkey->rt_tos,
-		rkey->rt_table, nl_addr2str(addr, buf, sizeof(buf)),
+		"hash 0x%x\n", route, rkey.rt_family, rkey.rt_tos,
+		rkey.rt_table, nl_addr2str(addr, buf, sizeof(buf)),
 		rkey_sz, *hashkey);
 
-	free(rkey);
-
 	return;
 }
 
@@ -628,6 +625,7 @@ void rtnl_route_set_table(struct rtnl_route *route, uint32_t table)
 {
 	route->rt_table = table;
 	route->ce_mask |= ROUTE_ATTR_TABLE;
+	nl_object_invalidate_hash(OBJ_CAST(route));
 }
 
 uint32_t rtnl_route_get_table(struct rtnl_route *route)
@@ -650,6 +648,7 @@ void rtnl_route_set_tos(struct rtnl_route *route, uint8_t tos)
 {
 	route->rt_tos = tos;
 	route->ce_mask |= ROUTE_ATTR_TOS;
+	nl_object_invalidate_hash(OBJ_CAST(route));
 }
 
 uint8_t rtnl_route_get_tos(struct rtnl_route *route)
@@ -672,6 +671,7 @@ void rtnl_route_set_priority(struct rtnl_route *route, uint32_t prio)
 {
 	route->rt_prio = prio;
 	route->ce_mask |= ROUTE_ATTR_PRIO;
+	nl_object_invalidate_hash(OBJ_CAST(route));
 }
 
 uint32_t rtnl_route_get_priority(struct rtnl_route *route)
@@ -688,6 +688,7 @@ int rtnl_route_set_family(struct rtnl_route *route, uint8_t family)
 	case AF_MPLS:
 		route->rt_family = family;
 		route->ce_mask |= ROUTE_ATTR_FAMILY;
+		nl_object_invalidate_hash(OBJ_CAST(route));
 		return 0;
 	}
 
@@ -708,12 +709,12 @@ int rtnl_route_set_dst(struct rtnl_route *route, struct nl_addr *addr)
 		route->rt_family = addr->a_family;
 
 	if (route->rt_dst)
-		nl_addr_put(route->rt_dst);
+		__nl_addr_owner_put(OBJ_CAST(route), route->rt_dst);
 
-	nl_addr_get(addr);
-	route->rt_dst = addr;
+	route->rt_dst = __nl_addr_owner_get(OBJ_CAST(route), addr);
 
 	route->ce_mask |= (ROUTE_ATTR_DST | ROUTE_ATTR_FAMILY);
+	nl_object_invalidate_hash(OBJ_CAST(route));
 
 	return 0;
 }
@@ -735,10 +736,9 @@ int rtnl_route_set_src(struct rtnl_route *route, struct nl_addr *addr)
 		route->rt_family = addr->a_family;
 
 	if (route->rt_src)
-		nl_addr_put(route->rt_src);
+		__nl_addr_owner_put(OBJ_CAST(route), route->rt_src);
 
-	nl_addr_get(addr);
-	route->rt_src = addr;
+	route->rt_src = __nl_addr_owner_get(OBJ_CAST(route), addr);
 	route->ce_mask |= (ROUTE_ATTR_SRC | ROUTE_ATTR_FAMILY);
 
 	return 0;
@@ -837,10 +837,9 @@ int rtnl_route_set_pref_src(struct rtnl_route *route, struct nl_addr *addr)
 		route->rt_family = addr->a_family;
 
 	if (route->rt_pref_src)
-		nl_addr_put(route->rt_pref_src);
+		__nl_addr_owner_put(OBJ_CAST(route), route->rt_pref_src);
 
-	nl_addr_get(addr);
-	route->rt_pref_src = addr;
+	route->rt_pref_src = __nl_addr_owner_get(OBJ_CAST(route), addr);
 	route->ce_mask |= (ROUTE_ATTR_PREF_SRC | ROUTE_ATTR_FAMILY);
 
 	return 0;
@@ -1156,22 +1155,22 @@ int rtnl_route_parse(struct nlmsghdr *nlh, struct rtnl_route **result)
 	if (family != AF_MPLS)
 		route->ce_mask |= ROUTE_ATTR_PRIO;
 
-	if (tb[RTA_DST]) {
-		if (!(dst = nl_addr_alloc_attr(tb[RTA_DST], family)))
-			goto errout_nomem;
-	} else {
-		if (!(dst = nl_addr_alloc(0)))
-			goto errout_nomem;
-		nl_addr_set_family(dst, rtm->rtm_family);
-	}
+	if (tb[RTA_DST])
+		dst = __nl_addr_inline_build(&route->rt_dst_buf, OBJ_CAST(route),
+					     family, nla_data(tb[RTA_DST]),
+					     nla_len(tb[RTA_DST]));
+	else
+		dst = __nl_addr_inline_build(&route->rt_dst_buf, OBJ_CAST(route),
+					     rtm->rtm_family, NULL, 0);
+	if (!dst)
+		goto errout_nomem;
 
 	nl_addr_set_prefixlen(dst, rtm->rtm_dst_len);
 	err = rtnl_route_set_dst(route, dst);
+	__nl_addr_owner_put(OBJ_CAST(route), dst);
 	if (err < 0)
 		goto errout;
 
-	nl_addr_put(dst);
-
 	if (tb[RTA_SRC]) {
 		if (!(src = nl_addr_alloc_attr(tb[RTA_SRC], family)))
 			goto errout_nomem;
@@ -1195,10 +1194,13 @@ int rtnl_route_parse(struct nlmsghdr *nlh, struct rtnl_route **result)
 		rtnl_route_set_priority(route, nla_get_u32(tb[RTA_PRIORITY]));
 
 	if (tb[RTA_PREFSRC]) {
-		if (!(addr = nl_addr_alloc_attr(tb[RTA_PREFSRC], family)))
+		if (!(addr = __nl_addr_inline_build(&route->rt_pref_src_buf,
+						    OBJ_CAST(route), family,
+						    nla_data(tb[RTA_PREFSRC]),
+						    nla_len(tb[RTA_PREFSRC]))))
 			goto errout_nomem;
 		rtnl_route_set_pref_src(route, addr);
-		nl_addr_put(addr);
+		__nl_addr_owner_put(OBJ_CAST(route), addr);
 	}
 
 	if (tb[RTA_METRICS]) {
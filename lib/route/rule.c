@@ -948,6 +948,9 @@ uint32_t rtnl_rule_get_goto(struct rtnl_rule *rule)
 
 /** @} */
 
+/* Rules are identified by all attributes both of them carry, a hash key
+ * of any of these would differ between rules considered identical.
+ * There is no oo_keygen, rule caches are small and searched linearly. */
 static struct nl_object_ops rule_obj_ops = {
 	.oo_name		= "route/rule",
 	.oo_size		= sizeof(struct rtnl_rule),
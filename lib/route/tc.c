@@ -21,6 +21,7 @@
 #include <netlink/netlink.h>
 #include <netlink/utils.h>
 #include <netlink/route/rtnl.h>
+#include <netlink/hashtable.h>
 #include <netlink/route/link.h>
 #include <netlink/route/tc.h>
 #include <netlink-private/route/tc-api.h>
@@ -285,6 +286,7 @@ void rtnl_tc_set_ifindex(struct rtnl_tc *tc, int ifindex)
 
 	tc->tc_ifindex = ifindex;
 	tc->ce_mask |= TCA_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(tc));
 }
 
 /**
@@ -321,6 +323,7 @@ void rtnl_tc_set_link(struct rtnl_tc *tc, struct rtnl_link *link)
 	tc->tc_link = link;
 	tc->tc_ifindex = link->l_index;
 	tc->ce_mask |= TCA_ATTR_LINK | TCA_ATTR_IFINDEX;
+	nl_object_invalidate_hash(OBJ_CAST(tc));
 }
 
 /**
@@ -488,6 +491,7 @@ void rtnl_tc_set_handle(struct rtnl_tc *tc, uint32_t id)
 {
 	tc->tc_handle = id;
 	tc->ce_mask |= TCA_ATTR_HANDLE;
+	nl_object_invalidate_hash(OBJ_CAST(tc));
 }
 
 /**
@@ -989,6 +993,26 @@ uint64_t rtnl_tc_compare(struct nl_object *aobj, struct nl_object *bobj,
 	return diff;
 }
 
+/** @cond SKIP */
+void rtnl_tc_keygen(struct nl_object *obj, uint32_t *hashkey,
+		    uint32_t table_sz)
+{
+	struct rtnl_tc *tc = TC_CAST(obj);
+	struct tc_hash_key {
+		uint32_t	tc_ifindex;
+		uint32_t	tc_handle;
+	} __attribute__((packed)) tkey;
+
+	tkey.tc_ifindex = tc->tc_ifindex;
+	tkey.tc_handle = tc->tc_handle;
+
+	*hashkey = nl_hash(&tkey, sizeof(tkey), 0) % table_sz;
+
+	NL_DBG(5, "tc %p key (dev %d handle %x) hash 0x%x\n",
+	       tc, tkey.tc_ifindex, tkey.tc_handle, *hashkey);
+}
+/** @endcond */
+
 /** @} */
 
 /**
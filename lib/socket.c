@@ -173,6 +173,24 @@ void _nl_socket_used_ports_set(uint32_t *used_ports, uint32_t port)
 }
 /** \endcond */
 
+static void recv_batch_free(struct nl_recv_batch *bt)
+{
+	unsigned int i;
+
+	if (!bt)
+		return;
+
+	for (i = 0; i < bt->bt_size; i++)
+		_nl_recvbuf_put(bt->bt_bufs[i]);
+
+	free(bt->bt_bufs);
+	free(bt->bt_msgs);
+	free(bt->bt_iov);
+	free(bt->bt_overflow);
+	free(bt->bt_addrs);
+	free(bt);
+}
+
 /**
  * @name Allocation
  * @{
@@ -246,12 +264,17 @@ void nl_socket_free(struct nl_sock *sk)
 	if (!sk)
 		return;
 
+	nl_socket_disable_io_uring(sk);
+
 	if (sk->s_fd >= 0)
 		close(sk->s_fd);
 
 	if (!(sk->s_flags & NL_OWN_PORT))
 		release_local_port(sk->s_local.nl_pid);
 
+	_nl_recvbuf_put(sk->s_rbuf);
+	free(sk->s_overflow);
+	recv_batch_free(sk->s_batch);
 	nl_cb_put(sk->s_cb);
 	free(sk);
 }
@@ -718,25 +741,176 @@ int nl_socket_set_nonblocking(const struct nl_sock *sk)
  * Enable use of MSG_PEEK when reading from socket
  * @arg sk		Netlink socket.
  *
- * See also NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT capability
+ * Peeking costs an additional recvmsg() call for every datagram but
+ * guarantees that messages exceeding the message buffer size are received
+ * in one piece, even if the buffer size has been set explicitly.
+ *
+ * @see nl_socket_set_msg_buf_size()
  */
 void nl_socket_enable_msg_peek(struct nl_sock *sk)
 {
-	sk->s_flags |= (NL_MSG_PEEK | NL_MSG_PEEK_EXPLICIT);
+	sk->s_flags |= NL_MSG_PEEK;
 }
 
 /**
- * Disable use of MSG_PEEK when reading from socket
+ * Disable use of MSG_PEEK when reading from socket (default)
  * @arg sk		Netlink socket.
- *
- * See also NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT capability
  */
 void nl_socket_disable_msg_peek(struct nl_sock *sk)
 {
-	sk->s_flags |= NL_MSG_PEEK_EXPLICIT;
 	sk->s_flags &= ~NL_MSG_PEEK;
 }
 
+/**
+ * Enable zero-copy parsing of received messages
+ * @arg sk		Netlink socket.
+ *
+ * By default, nl_recvmsgs() copies every netlink message found in a
+ * received datagram into a newly allocated struct nl_msg before invoking
+ * any callbacks. In zero-copy mode, the messages passed to the callbacks
+ * point directly into the receive buffer instead. The buffer is reference
+ * counted and stays valid for as long as any message pointing into it
+ * is alive.
+ *
+ * Messages received in zero-copy mode can not grow beyond their received
+ * size without nlmsg_expand() which moves them into a private buffer.
+ * Callers intending to hold on to a message after the callback returned
+ * should use nlmsg_clone() to avoid pinning the whole receive buffer.
+ *
+ * @see nl_socket_disable_zero_copy()
+ * @see nlmsg_clone()
+ */
+void nl_socket_enable_zero_copy(struct nl_sock *sk)
+{
+	sk->s_flags |= NL_MSG_ZERO_COPY;
+}
+
+/**
+ * Disable zero-copy parsing of received messages (default)
+ * @arg sk		Netlink socket.
+ *
+ * @see nl_socket_enable_zero_copy()
+ */
+void nl_socket_disable_zero_copy(struct nl_sock *sk)
+{
+	sk->s_flags &= ~NL_MSG_ZERO_COPY;
+}
+
+/**
+ * Receive multiple datagrams per system call
+ * @arg sk		Netlink socket.
+ * @arg n		Maximum number of datagrams to receive at once.
+ *
+ * Enables batched receiving in nl_recvmsgs(). Up to \c n datagrams are
+ * read from the socket with a single recvmmsg() call, each into its own
+ * buffer of the size set by nl_socket_set_msg_buf_size(). The datagrams
+ * are then handed to the message parser one by one on the following
+ * calls to nl_recvmsgs() without accessing the socket again.
+ *
+ * Datagrams already received but not yet parsed are not visible to
+ * poll() on the socket file descriptor. Callers must therefore keep
+ * calling nl_recvmsgs() until it returns -NLE_AGAIN (non-blocking mode)
+ * or nl_socket_get_recv_batch_pending() returns 0 before waiting for
+ * the socket to become readable again, like nl_cache_mngr_data_ready()
+ * does.
+ *
+ * Batching is not used while MSG_PEEK or credential passing is enabled,
+ * or if the receive function has been overwritten using
+ * nl_cb_overwrite_recv().
+ *
+ * A value of 0 or 1 disables batching (default).
+ *
+ * @see nl_socket_get_recv_batch_stats()
+ *
+ * @return 0 on success or a negative error code.
+ * @retval -NLE_BUSY Received datagrams are still pending
+ * @retval -NLE_RANGE \c n exceeds the maximum of 1024
+ * @retval -NLE_OPNOTSUPP recvmmsg() is not available
+ */
+int nl_socket_set_recv_batch(struct nl_sock *sk, unsigned int n)
+{
+	struct nl_recv_batch *bt;
+
+	if (nl_socket_get_recv_batch_pending(sk))
+		return -NLE_BUSY;
+
+	if (n <= 1) {
+		recv_batch_free(sk->s_batch);
+		sk->s_batch = NULL;
+		return 0;
+	}
+
+#ifdef HAVE_RECVMMSG
+	if (n > 1024)
+		return -NLE_RANGE;
+
+	bt = calloc(1, sizeof(*bt));
+	if (!bt)
+		return -NLE_NOMEM;
+
+	bt->bt_size = n;
+	bt->bt_bufs = calloc(n, sizeof(*bt->bt_bufs));
+	bt->bt_msgs = calloc(n, sizeof(*bt->bt_msgs));
+	bt->bt_iov = calloc(2 * n, sizeof(*bt->bt_iov));
+	bt->bt_addrs = calloc(n, sizeof(*bt->bt_addrs));
+	if (!bt->bt_bufs || !bt->bt_msgs || !bt->bt_iov || !bt->bt_addrs) {
+		recv_batch_free(bt);
+		return -NLE_NOMEM;
+	}
+
+	if (sk->s_batch) {
+		bt->bt_stats = sk->s_batch->bt_stats;
+		recv_batch_free(sk->s_batch);
+	}
+	sk->s_batch = bt;
+
+	return 0;
+#else
+	return -NLE_OPNOTSUPP;
+#endif
+}
+
+/**
+ * Get maximum number of datagrams received per system call
+ * @arg sk		Netlink socket.
+ *
+ * @return Batch size or 0 if batched receiving is disabled.
+ */
+unsigned int nl_socket_get_recv_batch(const struct nl_sock *sk)
+{
+	return sk->s_batch ? sk->s_batch->bt_size : 0;
+}
+
+/**
+ * Get number of received datagrams not yet parsed
+ * @arg sk		Netlink socket.
+ *
+ * @return Number of datagrams pending from the last batch.
+ */
+unsigned int nl_socket_get_recv_batch_pending(const struct nl_sock *sk)
+{
+	struct nl_recv_batch *bt = sk->s_batch;
+
+	return bt ? bt->bt_count - bt->bt_next : 0;
+}
+
+/**
+ * Get statistics of batched receiving
+ * @arg sk		Netlink socket.
+ * @arg stats		Destination for the statistics.
+ *
+ * Counters are kept since batched receiving was first enabled and are
+ * preserved when changing the batch size.
+ */
+void nl_socket_get_recv_batch_stats(const struct nl_sock *sk,
+				    struct nl_recv_batch_stats *stats)
+{
+	if (sk->s_batch)
+		*stats = sk->s_batch->bt_stats;
+	else
+		memset(stats, 0, sizeof(*stats));
+}
+
 /** @} */
 
 /**
@@ -852,18 +1026,29 @@ int nl_socket_set_buffer_size(struct nl_sock *sk, int rxbuf, int txbuf)
  * socket will be able to receive. It is generally recommneded to specify
  * a buffer size no less than the size of a memory page.
  *
- * Setting the @bufsize to zero means to use a default of 4 times getpagesize().
+ * Setting the @bufsize to zero means to use a default of 32KiB or 4 times
+ * getpagesize(), whichever is larger.
+ *
+ * nl_recvmsgs() reads into a receive buffer of this size which is owned by
+ * the socket and reused across calls. It is allocated on first use and
+ * enlarged whenever a message did not fit. Changing the size releases the
+ * current buffer. With batched receiving, every batch slot uses a buffer
+ * of this size.
  *
  * When MSG_PEEK is enabled, the buffer size is used for the initial choice
  * of the buffer while peeking. It still makes sense to choose an optimal value
  * to avoid realloc().
  *
- * When MSG_PEEK is disabled, the buffer size is important because a too small
- * size will lead to failure of receiving the message via nl_recvmsgs().
+ * When MSG_PEEK is disabled (default) and no buffer size has been set, a
+ * message exceeding the buffer continues in an overflow buffer of 64KiB
+ * which is part of the same recvmsg() call. The buffer is then enlarged to
+ * fit the message, which is received in one piece.
  *
- * By default, MSG_PEEK is enabled unless the user calls either nl_socket_disable_msg_peek()/
- * nl_socket_enable_msg_peek() or sets the message buffer size to a positive value.
- * See capability NL_CAPABILITY_NL_RECVMSGS_PEEK_BY_DEFAULT for that.
+ * Once a buffer size has been set, or for messages not even fitting into
+ * the overflow buffer, the buffer size is important because a too small
+ * size will lead to failure of receiving the message via nl_recvmsgs().
+ * The buffer is enlarged to fit the message for subsequent reads, the
+ * truncated message itself is reported as -NLE_MSG_TRUNC.
  *
  * @return 0 on success or a negative error code.
  */
@@ -871,6 +1056,18 @@ int nl_socket_set_msg_buf_size(struct nl_sock *sk, size_t bufsize)
 {
 	sk->s_bufsize = bufsize;
 
+	_nl_recvbuf_put(sk->s_rbuf);
+	sk->s_rbuf = NULL;
+
+	if (sk->s_batch && !nl_socket_get_recv_batch_pending(sk)) {
+		unsigned int i;
+
+		for (i = 0; i < sk->s_batch->bt_size; i++) {
+			_nl_recvbuf_put(sk->s_batch->bt_bufs[i]);
+			sk->s_batch->bt_bufs[i] = NULL;
+		}
+	}
+
 	return 0;
 }
 
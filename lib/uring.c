@@ -0,0 +1,725 @@
+/* SPDX-License-Identifier: LGPL-2.1-only */
+/*
+ * lib/uring.c		io_uring Receive Backend
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+/**
+ * @ingroup socket
+ * @defgroup uring io_uring Receive Backend
+ *
+ * Receiving of netlink datagrams through io_uring
+ *
+ * Instead of issuing a recvmsg() system call per datagram, a multishot
+ * IORING_OP_RECVMSG request is armed once on the netlink socket. The kernel
+ * places every received datagram into a buffer taken from a provided buffer
+ * ring and posts a completion. nl_recvmsgs() parses the messages directly
+ * from these buffers and returns each buffer to the ring as soon as the
+ * last message referencing it has been freed.
+ *
+ * Combining the backend with nl_socket_enable_zero_copy() avoids all
+ * copies and allocations on the receive path.
+ *
+ * @{
+ *
+ * Header
+ * ------
+ * ~~~~{.c}
+ * #include <netlink/socket.h>
+ * ~~~~
+ */
+
+#include <netlink-private/netlink.h>
+#include <netlink-private/socket.h>
+#include <netlink-private/utils.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+
+#ifdef HAVE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/** @cond SKIP */
+#define URING_RECV_DATA		1
+#define URING_CANCEL_DATA	2
+#define URING_MAX_BUFS		32768
+
+struct nl_uring;
+
+struct nl_uring_buf
+{
+	/* must be first, released through rb_release */
+	struct nl_recvbuf	ub_rbuf;
+	struct nl_uring *	ub_ring;
+	unsigned char *		ub_base;
+	size_t			ub_size;
+	/* allocated separately once enlarged, otherwise NULL */
+	unsigned char *		ub_alloc;
+	uint16_t		ub_bid;
+};
+
+struct nl_uring
+{
+	int			u_fd;
+	int			u_refcnt;
+	int			u_armed;
+	int			u_sock_fd;
+
+	unsigned int		u_nbufs;
+	/* buffers in the ring as of the completions reaped */
+	unsigned int		u_nfree;
+	/* size of buffers returned to the ring */
+	size_t			u_bufsize;
+	/* datagrams dropped by the socket as of the last check */
+	uint32_t		u_drops;
+
+	void *			u_sq_ring;
+	size_t			u_sq_ring_size;
+	unsigned int *		u_sq_tail;
+	unsigned int *		u_sq_array;
+	unsigned int		u_sq_mask;
+	struct io_uring_sqe *	u_sqes;
+	size_t			u_sqes_size;
+
+	void *			u_cq_ring;
+	size_t			u_cq_ring_size;
+	unsigned int *		u_cq_head;
+	unsigned int *		u_cq_tail;
+	unsigned int		u_cq_mask;
+	struct io_uring_cqe *	u_cqes;
+
+	struct io_uring_buf_ring *u_br;
+	size_t			u_br_size;
+	uint16_t		u_br_tail;
+	unsigned char *		u_data;
+	struct nl_uring_buf *	u_bufs;
+
+	struct msghdr		u_msghdr;
+};
+
+static int sys_io_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned int to_submit,
+			      unsigned int min_complete, unsigned int flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned int opcode, void *arg,
+				 unsigned int nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void uring_free(struct nl_uring *u)
+{
+	if (u->u_fd >= 0)
+		close(u->u_fd);
+
+	if (u->u_sqes)
+		munmap(u->u_sqes, u->u_sqes_size);
+	if (u->u_cq_ring && u->u_cq_ring != u->u_sq_ring)
+		munmap(u->u_cq_ring, u->u_cq_ring_size);
+	if (u->u_sq_ring)
+		munmap(u->u_sq_ring, u->u_sq_ring_size);
+	if (u->u_br)
+		munmap(u->u_br, u->u_br_size);
+
+	if (u->u_bufs) {
+		unsigned int i;
+
+		for (i = 0; i < u->u_nbufs; i++)
+			free(u->u_bufs[i].ub_alloc);
+	}
+
+	free(u->u_data);
+	free(u->u_bufs);
+	free(u);
+}
+
+static void uring_put(struct nl_uring *u)
+{
+	if (--u->u_refcnt == 0)
+		uring_free(u);
+}
+
+static void uring_buf_recycle(struct nl_uring *u, unsigned int bid)
+{
+	struct nl_uring_buf *ub = &u->u_bufs[bid];
+	struct io_uring_buf *b;
+
+	/* A datagram did not fit, buffers are enlarged on their way back
+	 * to the ring. The buffer is kept if that fails. */
+	if (ub->ub_size < u->u_bufsize) {
+		unsigned char *data = malloc(u->u_bufsize);
+
+		if (data) {
+			free(ub->ub_alloc);
+			ub->ub_base = ub->ub_alloc = data;
+			ub->ub_size = u->u_bufsize;
+		}
+	}
+
+	b = &u->u_br->bufs[u->u_br_tail & (u->u_nbufs - 1)];
+	b->addr = (uintptr_t) ub->ub_base;
+	b->len = ub->ub_size;
+	b->bid = bid;
+
+	u->u_br_tail++;
+	__atomic_store_n(&u->u_br->tail, u->u_br_tail, __ATOMIC_RELEASE);
+	u->u_nfree++;
+}
+
+static void uring_buf_release(struct nl_recvbuf *rb)
+{
+	struct nl_uring_buf *ub = (struct nl_uring_buf *) rb;
+	struct nl_uring *u = ub->ub_ring;
+
+	uring_buf_recycle(u, ub->ub_bid);
+	uring_put(u);
+}
+
+/* Returns the number of datagrams dropped by the socket in @drops */
+static int uring_sock_drops(struct nl_uring *u, uint32_t *drops)
+{
+#ifdef SO_MEMINFO
+	uint32_t mem[SK_MEMINFO_VARS];
+	socklen_t len = sizeof(mem);
+
+	if (getsockopt(u->u_sock_fd, SOL_SOCKET, SO_MEMINFO, mem, &len) < 0)
+		return -nl_syserr2nlerr(errno);
+
+	if (len <= SK_MEMINFO_DROPS * sizeof(uint32_t))
+		return -NLE_OPNOTSUPP;
+
+	*drops = mem[SK_MEMINFO_DROPS];
+
+	return 0;
+#else
+	return -NLE_OPNOTSUPP;
+#endif
+}
+
+/*
+ * A receive fails with ENOBUFS if the buffer ring was empty, the datagram
+ * is then still queued on the socket, or if the socket overran and
+ * datagrams were lost. Returns 1 in the latter case.
+ */
+static int uring_overrun(struct nl_uring *u, uint32_t flags)
+{
+	uint32_t drops;
+
+	/* A buffer was taken, the ring was not empty */
+	if (flags & IORING_CQE_F_BUFFER)
+		return 1;
+
+	/* Buffers returned since the failure may hide an empty ring, the
+	 * drop counter of the socket tells for sure. */
+	if (uring_sock_drops(u, &drops) < 0)
+		return u->u_nfree != 0;
+
+	if (drops == u->u_drops)
+		return 0;
+
+	u->u_drops = drops;
+
+	return 1;
+}
+
+static int uring_map(struct nl_uring *u, struct io_uring_params *p)
+{
+	u->u_sq_ring_size = p->sq_off.array + p->sq_entries * sizeof(unsigned int);
+	u->u_cq_ring_size = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+
+	if (p->features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->u_cq_ring_size > u->u_sq_ring_size)
+			u->u_sq_ring_size = u->u_cq_ring_size;
+		u->u_cq_ring_size = u->u_sq_ring_size;
+	}
+
+	u->u_sq_ring = mmap(NULL, u->u_sq_ring_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, u->u_fd,
+			    IORING_OFF_SQ_RING);
+	if (u->u_sq_ring == MAP_FAILED) {
+		u->u_sq_ring = NULL;
+		return -nl_syserr2nlerr(errno);
+	}
+
+	if (p->features & IORING_FEAT_SINGLE_MMAP)
+		u->u_cq_ring = u->u_sq_ring;
+	else {
+		u->u_cq_ring = mmap(NULL, u->u_cq_ring_size,
+				    PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_POPULATE, u->u_fd,
+				    IORING_OFF_CQ_RING);
+		if (u->u_cq_ring == MAP_FAILED) {
+			u->u_cq_ring = NULL;
+			return -nl_syserr2nlerr(errno);
+		}
+	}
+
+	u->u_sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+	u->u_sqes = mmap(NULL, u->u_sqes_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, u->u_fd, IORING_OFF_SQES);
+	if (u->u_sqes == MAP_FAILED) {
+		u->u_sqes = NULL;
+		return -nl_syserr2nlerr(errno);
+	}
+
+	u->u_sq_tail = (unsigned int *) ((char *) u->u_sq_ring + p->sq_off.tail);
+	u->u_sq_array = (unsigned int *) ((char *) u->u_sq_ring + p->sq_off.array);
+	u->u_sq_mask = *(unsigned int *) ((char *) u->u_sq_ring + p->sq_off.ring_mask);
+
+	u->u_cq_head = (unsigned int *) ((char *) u->u_cq_ring + p->cq_off.head);
+	u->u_cq_tail = (unsigned int *) ((char *) u->u_cq_ring + p->cq_off.tail);
+	u->u_cq_mask = *(unsigned int *) ((char *) u->u_cq_ring + p->cq_off.ring_mask);
+	u->u_cqes = (struct io_uring_cqe *) ((char *) u->u_cq_ring + p->cq_off.cqes);
+
+	return 0;
+}
+
+static int uring_setup_bufs(struct nl_uring *u)
+{
+	struct io_uring_buf_reg reg = { 0 };
+	unsigned int i;
+
+	u->u_br_size = u->u_nbufs * sizeof(struct io_uring_buf);
+	u->u_br = mmap(NULL, u->u_br_size, PROT_READ | PROT_WRITE,
+		       MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (u->u_br == MAP_FAILED) {
+		u->u_br = NULL;
+		return -NLE_NOMEM;
+	}
+
+	u->u_data = malloc(u->u_nbufs * u->u_bufsize);
+	u->u_bufs = calloc(u->u_nbufs, sizeof(*u->u_bufs));
+	if (!u->u_data || !u->u_bufs)
+		return -NLE_NOMEM;
+
+	reg.ring_addr = (uintptr_t) u->u_br;
+	reg.ring_entries = u->u_nbufs;
+	reg.bgid = 0;
+
+	if (sys_io_uring_register(u->u_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		return -nl_syserr2nlerr(errno);
+
+	for (i = 0; i < u->u_nbufs; i++) {
+		struct nl_uring_buf *ub = &u->u_bufs[i];
+
+		ub->ub_ring = u;
+		ub->ub_base = u->u_data + i * u->u_bufsize;
+		ub->ub_size = u->u_bufsize;
+		ub->ub_bid = i;
+		ub->ub_rbuf.rb_release = uring_buf_release;
+
+		uring_buf_recycle(u, i);
+	}
+
+	return 0;
+}
+
+static struct io_uring_sqe *uring_get_sqe(struct nl_uring *u)
+{
+	unsigned int tail = *u->u_sq_tail;
+	struct io_uring_sqe *sqe = &u->u_sqes[tail & u->u_sq_mask];
+
+	memset(sqe, 0, sizeof(*sqe));
+	u->u_sq_array[tail & u->u_sq_mask] = tail & u->u_sq_mask;
+
+	return sqe;
+}
+
+static int uring_submit(struct nl_uring *u, unsigned int min_complete)
+{
+	int err;
+
+	__atomic_store_n(u->u_sq_tail, *u->u_sq_tail + 1, __ATOMIC_RELEASE);
+
+	err = sys_io_uring_enter(u->u_fd, 1, min_complete,
+				 min_complete ? IORING_ENTER_GETEVENTS : 0);
+	if (err < 0)
+		return -nl_syserr2nlerr(errno);
+
+	return 0;
+}
+
+static int uring_arm(struct nl_uring *u)
+{
+	struct io_uring_sqe *sqe;
+	int err;
+
+	sqe = uring_get_sqe(u);
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = u->u_sock_fd;
+	sqe->addr = (uintptr_t) &u->u_msghdr;
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	/* report the full length of truncated datagrams */
+	sqe->msg_flags = MSG_TRUNC;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = 0;
+	sqe->user_data = URING_RECV_DATA;
+
+	if ((err = uring_submit(u, 0)) < 0)
+		return err;
+
+	u->u_armed = 1;
+
+	return 0;
+}
+
+static void uring_cancel(struct nl_uring *u)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int head, tail;
+	int done = 0;
+
+	if (!u->u_armed)
+		return;
+
+	sqe = uring_get_sqe(u);
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = URING_RECV_DATA;
+	sqe->user_data = URING_CANCEL_DATA;
+
+	if (uring_submit(u, 1) < 0)
+		return;
+
+	/* Datagrams completed but not yet parsed are dropped */
+	while (!done) {
+		head = *u->u_cq_head;
+		tail = __atomic_load_n(u->u_cq_tail, __ATOMIC_ACQUIRE);
+
+		if (head == tail) {
+			if (sys_io_uring_enter(u->u_fd, 0, 1,
+					       IORING_ENTER_GETEVENTS) < 0 &&
+			    errno != EINTR)
+				break;
+			continue;
+		}
+
+		for (; head != tail; head++) {
+			struct io_uring_cqe *cqe = &u->u_cqes[head & u->u_cq_mask];
+
+			if (cqe->user_data == URING_RECV_DATA) {
+				if (cqe->flags & IORING_CQE_F_BUFFER) {
+					u->u_nfree--;
+					uring_buf_recycle(u, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+				}
+				if (!(cqe->flags & IORING_CQE_F_MORE))
+					done = 1;
+			}
+		}
+
+		__atomic_store_n(u->u_cq_head, head, __ATOMIC_RELEASE);
+	}
+
+	u->u_armed = 0;
+}
+
+static int uring_sock_is_nonblocking(struct nl_uring *u)
+{
+	int flags = fcntl(u->u_sock_fd, F_GETFL);
+
+	return flags >= 0 && (flags & O_NONBLOCK);
+}
+
+int _nl_uring_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		   struct nl_recvbuf **rbuf)
+{
+	struct nl_uring *u = sk->s_uring;
+	struct io_uring_recvmsg_out *out;
+	struct io_uring_cqe *cqe;
+	struct nl_uring_buf *ub;
+	unsigned int head, tail, bid;
+	uint32_t flags;
+	int res, err;
+
+retry:
+	if (!u->u_armed) {
+		/* All buffers are held by messages not yet freed */
+		if (u->u_nfree == 0)
+			return -NLE_BUSY;
+
+		if ((err = uring_arm(u)) < 0)
+			return err;
+	}
+
+	head = *u->u_cq_head;
+	tail = __atomic_load_n(u->u_cq_tail, __ATOMIC_ACQUIRE);
+
+	if (head == tail) {
+		int nonblock = uring_sock_is_nonblocking(u);
+
+		/* Run pending task work, wait for a completion unless the
+		 * socket is in non-blocking mode. */
+		if (sys_io_uring_enter(u->u_fd, 0, nonblock ? 0 : 1,
+				       IORING_ENTER_GETEVENTS) < 0) {
+			if (errno == EINTR)
+				goto retry;
+			return -nl_syserr2nlerr(errno);
+		}
+
+		tail = __atomic_load_n(u->u_cq_tail, __ATOMIC_ACQUIRE);
+		if (head == tail) {
+			if (nonblock)
+				return -NLE_AGAIN;
+			goto retry;
+		}
+	}
+
+	cqe = &u->u_cqes[head & u->u_cq_mask];
+	res = cqe->res;
+	flags = cqe->flags;
+	__atomic_store_n(u->u_cq_head, head + 1, __ATOMIC_RELEASE);
+
+	if (cqe->user_data != URING_RECV_DATA)
+		goto retry;
+
+	if (!(flags & IORING_CQE_F_MORE))
+		u->u_armed = 0;
+
+	/* The kernel took the buffer off the ring */
+	if (flags & IORING_CQE_F_BUFFER)
+		u->u_nfree--;
+
+	if (res < 0) {
+		if (flags & IORING_CQE_F_BUFFER)
+			uring_buf_recycle(u, flags >> IORING_CQE_BUFFER_SHIFT);
+
+		/* All buffers were in use, the datagram is still queued
+		 * on the socket and will be received once re-armed. */
+		if (res == -ENOBUFS && !uring_overrun(u, flags))
+			goto retry;
+
+		if (res == -EAGAIN)
+			return -NLE_AGAIN;
+
+		NL_DBG(4, "_nl_uring_recv(%p): recvmsg failed with %d (%s)\n",
+		       sk, -res, nl_strerror_l(-res));
+		return -nl_syserr2nlerr(-res);
+	}
+
+	if (!(flags & IORING_CQE_F_BUFFER))
+		return -NLE_FAILURE;
+
+	bid = flags >> IORING_CQE_BUFFER_SHIFT;
+	ub = &u->u_bufs[bid];
+
+	out = (struct io_uring_recvmsg_out *) ub->ub_base;
+	if (res < (int) sizeof(*out) ||
+	    out->namelen != sizeof(struct sockaddr_nl)) {
+		uring_buf_recycle(u, bid);
+		return -NLE_NOADDR;
+	}
+
+	if (out->flags & MSG_TRUNC) {
+		size_t size = sizeof(*out) + u->u_msghdr.msg_namelen +
+			      u->u_msghdr.msg_controllen + out->payloadlen;
+
+		/* The datagram is gone once received, it can not be read
+		 * again into a larger buffer. It is reported like a lost
+		 * datagram and the buffers grow to fit the next one. */
+		if (u->u_bufsize < size)
+			u->u_bufsize = size;
+
+		uring_buf_recycle(u, bid);
+		return -NLE_MSG_TRUNC;
+	}
+
+	memcpy(nla, ub->ub_base + sizeof(*out), sizeof(*nla));
+
+	ub->ub_rbuf.rb_data = ub->ub_base + sizeof(*out) +
+			      u->u_msghdr.msg_namelen + u->u_msghdr.msg_controllen;
+	ub->ub_rbuf.rb_size = out->payloadlen;
+	ub->ub_rbuf.rb_refcnt = 1;
+	u->u_refcnt++;
+
+	*rbuf = &ub->ub_rbuf;
+
+	return out->payloadlen;
+}
+/** @endcond */
+
+#else /* HAVE_IO_URING */
+
+/** @cond SKIP */
+int _nl_uring_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		   struct nl_recvbuf **rbuf)
+{
+	return -NLE_OPNOTSUPP;
+}
+/** @endcond */
+
+#endif /* HAVE_IO_URING */
+
+/**
+ * Receive datagrams through io_uring
+ * @arg sk		Netlink socket (connected)
+ * @arg nbufs		Number of receive buffers
+ *
+ * Sets up an io_uring instance with a ring of \c nbufs provided buffers,
+ * rounded up to the next power of two, each large enough to hold a message
+ * of the size set by nl_socket_set_msg_buf_size(). All subsequent calls to
+ * nl_recvmsgs() receive datagrams through a multishot receive request
+ * armed on the socket. Buffers are returned to the ring when the last
+ * message referencing them has been freed. If all buffers are held by
+ * messages, nl_recvmsgs() fails with -NLE_BUSY until one is freed.
+ * Datagrams lost due to the socket overrunning are reported as
+ * -NLE_NOMEM as without the backend.
+ *
+ * Unless a buffer size has been set, buffers also have room for the
+ * overflow buffer used without the backend, see
+ * nl_socket_set_msg_buf_size(). A datagram exceeding the buffers is
+ * lost and reported as -NLE_MSG_TRUNC. Buffers are then enlarged to fit
+ * it as they return to the ring.
+ *
+ * While the backend is enabled, the socket file descriptor does not
+ * indicate readability as incoming datagrams are consumed by the kernel on
+ * behalf of the ring. Use the file descriptor returned by
+ * nl_socket_get_io_uring_fd() for poll() instead.
+ *
+ * The backend takes precedence over batched receiving and MSG_PEEK. It
+ * can not be combined with credential passing and is not used if the
+ * receive function has been overwritten using nl_cb_overwrite_recv().
+ *
+ * @see nl_socket_disable_io_uring()
+ * @see nl_socket_enable_zero_copy()
+ *
+ * @return 0 on success or a negative error code.
+ * @retval -NLE_BAD_SOCK Socket is not connected
+ * @retval -NLE_BUSY Backend is already enabled
+ * @retval -NLE_INVAL Credential passing is enabled
+ * @retval -NLE_RANGE \c nbufs is zero or exceeds 32768
+ * @retval -NLE_OPNOTSUPP io_uring is not supported
+ */
+int nl_socket_enable_io_uring(struct nl_sock *sk, unsigned int nbufs)
+{
+#ifdef HAVE_IO_URING
+	struct io_uring_params p = { 0 };
+	struct nl_uring *u;
+	unsigned int n = 1;
+	int err;
+
+	if (sk->s_fd < 0)
+		return -NLE_BAD_SOCK;
+
+	if (sk->s_uring)
+		return -NLE_BUSY;
+
+	if (sk->s_flags & NL_SOCK_PASSCRED)
+		return -NLE_INVAL;
+
+	if (nbufs == 0 || nbufs > URING_MAX_BUFS)
+		return -NLE_RANGE;
+
+	while (n < nbufs)
+		n <<= 1;
+
+	u = calloc(1, sizeof(*u));
+	if (!u)
+		return -NLE_NOMEM;
+
+	u->u_refcnt = 1;
+	u->u_sock_fd = sk->s_fd;
+	u->u_nbufs = n;
+	u->u_msghdr.msg_namelen = sizeof(struct sockaddr_nl);
+	u->u_bufsize = sizeof(struct io_uring_recvmsg_out) +
+		       sizeof(struct sockaddr_nl) +
+		       _nl_socket_recv_bufsize(sk);
+
+	/* Buffers can not be extended by an overflow buffer, they have
+	 * room for the same message size instead. */
+	if (!sk->s_bufsize)
+		u->u_bufsize += NL_RECV_OVERFLOW;
+
+	/* Every buffer may be completed before any completion is reaped */
+	p.flags = IORING_SETUP_CQSIZE;
+	p.cq_entries = n + 8;
+
+	u->u_fd = sys_io_uring_setup(8, &p);
+	if (u->u_fd < 0) {
+		err = errno == ENOSYS ? -NLE_OPNOTSUPP : -nl_syserr2nlerr(errno);
+		goto errout;
+	}
+
+	if ((err = uring_map(u, &p)) < 0)
+		goto errout;
+
+	if ((err = uring_setup_bufs(u)) < 0) {
+		if (err == -NLE_INVAL)
+			err = -NLE_OPNOTSUPP;
+		goto errout;
+	}
+
+	uring_sock_drops(u, &u->u_drops);
+
+	if ((err = uring_arm(u)) < 0)
+		goto errout;
+
+	sk->s_uring = u;
+
+	return 0;
+
+errout:
+	uring_free(u);
+	return err;
+#else
+	return -NLE_OPNOTSUPP;
+#endif
+}
+
+/**
+ * Stop receiving datagrams through io_uring
+ * @arg sk		Netlink socket
+ *
+ * Cancels the receive request armed on the socket. Datagrams already
+ * received by the ring but not yet parsed are dropped. Buffers still
+ * referenced by messages stay valid until those are freed.
+ *
+ * @see nl_socket_enable_io_uring()
+ */
+void nl_socket_disable_io_uring(struct nl_sock *sk)
+{
+#ifdef HAVE_IO_URING
+	struct nl_uring *u = sk->s_uring;
+
+	if (!u)
+		return;
+
+	uring_cancel(u);
+	sk->s_uring = NULL;
+	uring_put(u);
+#endif
+}
+
+/**
+ * Return file descriptor of io_uring instance
+ * @arg sk		Netlink socket
+ *
+ * The file descriptor becomes readable when datagrams are ready to be
+ * parsed by nl_recvmsgs().
+ *
+ * @return File descriptor or -1 if the backend is not enabled.
+ */
+int nl_socket_get_io_uring_fd(const struct nl_sock *sk)
+{
+#ifdef HAVE_IO_URING
+	if (sk->s_uring)
+		return sk->s_uring->u_fd;
+#endif
+
+	return -1;
+}
+
+/** @} */
@@ -11,6 +11,8 @@
 
 #include <check.h>
 #include <netlink/addr.h>
+#include <netlink/msg.h>
+#include <netlink/route/route.h>
 
 #include "util.h"
 
@@ -198,6 +200,52 @@ START_TEST(addr_info)
 }
 END_TEST
 
+START_TEST(addr_route_ref)
+{
+	struct rtmsg rtm = {
+		.rtm_family = AF_INET,
+		.rtm_dst_len = 24,
+		.rtm_table = RT_TABLE_MAIN,
+	};
+	struct nl_addr *dst, *gw, *clone;
+	struct rtnl_route *route;
+	struct nl_msg *msg;
+	uint32_t addr = htonl(0x0a000000);
+	char buf[64];
+
+	msg = nlmsg_alloc_simple(RTM_NEWROUTE, 0);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nlmsg_append(msg, &rtm, sizeof(rtm), NLMSG_ALIGNTO) < 0 ||
+		nla_put(msg, RTA_DST, sizeof(addr), &addr) < 0,
+		"Unable to build message");
+	fail_if(rtnl_route_parse(nlmsg_hdr(msg), &route) != 0,
+		"Unable to parse route");
+	nlmsg_free(msg);
+
+	/* addresses of a route remain valid after the route is released */
+	dst = nl_addr_get(rtnl_route_get_dst(route));
+
+	/* assigning an address of a route to itself must not leak it */
+	rtnl_route_set_pref_src(route, dst);
+	rtnl_route_set_pref_src(route, dst);
+	fail_if(nl_addr_parse("10.0.0.1", AF_INET, &gw) != 0,
+		"Unable to parse address");
+	rtnl_route_set_pref_src(route, gw);
+	nl_addr_put(gw);
+
+	rtnl_route_put(route);
+
+	fail_if(strcmp(nl_addr2str(dst, buf, sizeof(buf)), "10.0.0.0/24"),
+		"Address of released route changed");
+
+	clone = nl_addr_clone(dst);
+	nl_addr_put(dst);
+	fail_if(strcmp(nl_addr2str(clone, buf, sizeof(buf)), "10.0.0.0/24"),
+		"Clone of address differs");
+	nl_addr_put(clone);
+}
+END_TEST
+
 Suite *make_nl_addr_suite(void)
 {
 	Suite *suite = suite_create("Abstract addresses");
@@ -208,6 +256,7 @@ Suite *make_nl_addr_suite(void)
 	tcase_add_test(tc_addr, addr_parse4);
 	tcase_add_test(tc_addr, addr_parse6);
 	tcase_add_test(tc_addr, addr_info);
+	tcase_add_test(tc_addr, addr_route_ref);
 	suite_add_tcase(suite, tc_addr);
 
 	return suite;
@@ -31,7 +31,14 @@ int main(int argc, char *argv[])
 
 	srunner_add_suite(runner, make_nl_addr_suite());
 	srunner_add_suite(runner, make_nl_attr_suite());
+	srunner_add_suite(runner, make_nl_cache_suite());
+	srunner_add_suite(runner, make_nl_cache_mngr_suite());
 	srunner_add_suite(runner, make_nl_ematch_tree_clone_suite());
+	srunner_add_suite(runner, make_nl_hashtable_suite());
+	srunner_add_suite(runner, make_nl_link_suite());
+	srunner_add_suite(runner, make_nl_msg_suite());
+	srunner_add_suite(runner, make_nl_route_suite());
+	srunner_add_suite(runner, make_nl_socket_suite());
 
 	/* Do not add testsuites below this line */
 
@@ -0,0 +1,435 @@
+/*
+ * tests/check-cache-mngr.c	Cache manager unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netlink-private/cache-api.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+#include <netlink/cache.h>
+#include <netlink/route/link.h>
+#include <netlink/route/addr.h>
+
+#include "util.h"
+
+#define NEVENT_LINKS 200
+
+/*
+ * Notifications are not received from the kernel but from a queue of
+ * datagrams filled by the test, see fake_recv(). Caches are still
+ * filled from the kernel when added.
+ */
+struct fake_dgram
+{
+	struct fake_dgram *	d_next;
+	int			d_len;
+	unsigned char		d_data[];
+};
+
+static struct fake_dgram *fake_head, **fake_tail = &fake_head;
+
+/* Makes the next receive fail like an overrun socket */
+static int fake_overrun;
+
+static void queue_msg(struct nl_msg *msg)
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct fake_dgram *d;
+
+	d = malloc(sizeof(*d) + nlh->nlmsg_len);
+	fail_if(!d, "Unable to allocate datagram");
+
+	d->d_next = NULL;
+	d->d_len = nlh->nlmsg_len;
+	memcpy(d->d_data, nlh, nlh->nlmsg_len);
+	*fake_tail = d;
+	fake_tail = &d->d_next;
+
+	nlmsg_free(msg);
+}
+
+static int fake_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		     unsigned char **buf, struct ucred **creds)
+{
+	struct fake_dgram *d = fake_head;
+	int len;
+
+	if (creds)
+		*creds = NULL;
+
+	if (fake_overrun) {
+		fake_overrun = 0;
+		return -NLE_NOMEM;
+	}
+
+	if (!d)
+		return 0;
+
+	if (!(fake_head = d->d_next))
+		fake_tail = &fake_head;
+
+	*buf = malloc(d->d_len);
+	if (!*buf)
+		return -NLE_NOMEM;
+
+	memcpy(*buf, d->d_data, d->d_len);
+	len = d->d_len;
+	free(d);
+
+	return len;
+}
+
+static struct nl_cache_mngr *alloc_fake_mngr(struct nl_sock **sk, int flags)
+{
+	struct nl_cache_mngr *mngr;
+	struct nl_cb *cb;
+
+	*sk = nl_socket_alloc();
+	fail_if(!*sk, "Unable to allocate socket");
+	cb = nl_socket_get_cb(*sk);
+	nl_cb_overwrite_recv(cb, fake_recv);
+	nl_cb_put(cb);
+
+	fail_if(nl_cache_mngr_alloc(*sk, NETLINK_ROUTE, flags, &mngr) != 0,
+		"Unable to allocate cache manager");
+
+	return mngr;
+}
+
+static void queue_link_msg(int type, int ifindex, unsigned int mtu)
+{
+	struct ifinfomsg ifi = {
+		.ifi_family = AF_UNSPEC,
+		.ifi_index = ifindex,
+	};
+	struct nl_msg *msg;
+	char name[IFNAMSIZ];
+
+	snprintf(name, sizeof(name), "fake%d", ifindex);
+
+	msg = nlmsg_alloc_simple(type, 0);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0 ||
+		nla_put_string(msg, IFLA_IFNAME, name) < 0 ||
+		nla_put_u32(msg, IFLA_MTU, mtu) < 0,
+		"Unable to build message");
+
+	queue_msg(msg);
+}
+
+static void queue_link(int ifindex, unsigned int mtu)
+{
+	queue_link_msg(RTM_NEWLINK, ifindex, mtu);
+}
+
+static void queue_addr(int ifindex)
+{
+	struct ifaddrmsg ifa = {
+		.ifa_family = AF_INET,
+		.ifa_prefixlen = 32,
+		.ifa_index = ifindex,
+	};
+	uint32_t local = htonl(0x0a630000 + ifindex);
+	struct nl_msg *msg;
+
+	msg = nlmsg_alloc_simple(RTM_NEWADDR, 0);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nlmsg_append(msg, &ifa, sizeof(ifa), NLMSG_ALIGNTO) < 0 ||
+		nla_put(msg, IFA_LOCAL, sizeof(local), &local) < 0 ||
+		nla_put(msg, IFA_ADDRESS, sizeof(local), &local) < 0,
+		"Unable to build message");
+
+	queue_msg(msg);
+}
+
+static struct rtnl_addr *find_addr(struct nl_cache *cache, int ifindex)
+{
+	struct nl_object *obj;
+
+	for (obj = nl_cache_get_first(cache); obj;
+	     obj = nl_cache_get_next(obj))
+		if (rtnl_addr_get_ifindex((struct rtnl_addr *) obj) == ifindex)
+			return (struct rtnl_addr *) obj;
+
+	return NULL;
+}
+
+START_TEST(mngr_workers_link_addr)
+{
+	struct nl_cache_mngr *mngr;
+	struct nl_sock *sk;
+	struct nl_cache *links, *addrs;
+	struct rtnl_link *link;
+	struct rtnl_addr *addr;
+	int i, round;
+
+	mngr = alloc_fake_mngr(&sk, NL_AUTO_PROVIDE);
+	fail_if(nl_cache_mngr_add(mngr, "route/link", NULL, NULL, &links) != 0,
+		"Unable to add link cache");
+	fail_if(nl_cache_mngr_add(mngr, "route/addr", NULL, NULL, &addrs) != 0,
+		"Unable to add address cache");
+	fail_if(nl_cache_mngr_set_workers(mngr, 2) != 0,
+		"Unable to start workers");
+
+	for (i = 1; i <= NEVENT_LINKS; i++)
+		queue_link(10000 + i, 1000);
+	fail_if(nl_cache_mngr_data_ready(mngr) != NEVENT_LINKS,
+		"Links not received");
+	nl_cache_mngr_flush(mngr);
+
+	/* addresses look up their links while the links are updated and
+	 * new ones grow the link index */
+	for (round = 1; round <= 4; round++) {
+		for (i = 1; i <= NEVENT_LINKS; i++) {
+			queue_link(10000 + i, 1000 + round);
+			queue_link(10000 + round * NEVENT_LINKS + i, 1000);
+			queue_addr(10000 + i);
+		}
+		nl_cache_mngr_data_ready(mngr);
+	}
+	nl_cache_mngr_flush(mngr);
+
+	for (i = 1; i <= NEVENT_LINKS; i++) {
+		link = rtnl_link_get(links, 10000 + i);
+		fail_if(!link || rtnl_link_get_mtu(link) != 1004,
+			"Link %d not updated", 10000 + i);
+		rtnl_link_put(link);
+
+		addr = find_addr(addrs, 10000 + i);
+		fail_if(!addr, "Address of link %d missing", 10000 + i);
+		link = rtnl_addr_get_link(addr);
+		fail_if(!link || rtnl_link_get_ifindex(link) != 10000 + i,
+			"Address of link %d not linked", 10000 + i);
+		rtnl_link_put(link);
+	}
+
+	link = rtnl_link_get(links, 10000 + 5 * NEVENT_LINKS);
+	fail_if(!link, "New link missing");
+	rtnl_link_put(link);
+
+	nl_cache_mngr_free(mngr);
+	nl_socket_free(sk);
+}
+END_TEST
+
+START_TEST(mngr_dispatch_first)
+{
+	struct nl_cache_ops *link_ops, *shadow_ops;
+	struct nl_cache *links, *shadow;
+	struct nl_cache_mngr *mngr;
+	struct rtnl_link *link;
+	struct nl_sock *sk;
+	size_t size;
+	int n;
+
+	/* a second cache type handling the same message types */
+	link_ops = nl_cache_ops_lookup_safe("route/link");
+	fail_if(!link_ops, "Link cache operations missing");
+	for (n = 0; link_ops->co_msgtypes[n].mt_id >= 0; n++)
+		;
+	size = sizeof(*link_ops) + (n + 1) * sizeof(struct nl_msgtype);
+	shadow_ops = malloc(size);
+	fail_if(!shadow_ops, "Unable to allocate cache operations");
+	memcpy(shadow_ops, link_ops, size);
+	shadow_ops->co_name = "test/link";
+	shadow_ops->co_refcnt = 0;
+	shadow_ops->co_next = NULL;
+	nl_cache_ops_put(link_ops);
+
+	mngr = alloc_fake_mngr(&sk, 0);
+	fail_if(nl_cache_alloc_name("route/link", &links) < 0 ||
+		!(shadow = nl_cache_alloc(shadow_ops)),
+		"Unable to allocate caches");
+	fail_if(nl_cache_mngr_add_cache(mngr, links, NULL, NULL) != 0 ||
+		nl_cache_mngr_add_cache(mngr, shadow, NULL, NULL) != 0,
+		"Unable to add caches");
+
+	/* the cache added first handles the message type */
+	queue_link(40001, 1000);
+	nl_cache_mngr_data_ready(mngr);
+	link = rtnl_link_get(links, 40001);
+	fail_if(!link, "Link not included into first cache");
+	rtnl_link_put(link);
+	fail_if(nl_cache_find(shadow, OBJ_CAST(link)),
+		"Link included into second cache");
+
+	/* message types of no cache are ignored */
+	queue_addr(40001);
+	nl_cache_mngr_data_ready(mngr);
+
+	nl_cache_mngr_free(mngr);
+	nl_socket_free(sk);
+	free(shadow_ops);
+}
+END_TEST
+
+static void count_del_cb(struct nl_cache *cache, struct nl_object *obj,
+			 int action, void *arg)
+{
+	if (action == NL_ACT_DEL)
+		(*(int *) arg)++;
+}
+
+START_TEST(mngr_overrun_recovery)
+{
+	struct nl_cache_mngr_recovery_stats stats;
+	struct nl_cache_mngr *mngr;
+	struct nl_cache *links;
+	struct rtnl_link *link;
+	struct nl_sock *sk;
+	int ndel = 0;
+
+	mngr = alloc_fake_mngr(&sk, NL_AUTO_PROVIDE);
+	fail_if(nl_cache_mngr_add(mngr, "route/link", count_del_cb, &ndel,
+				  &links) != 0, "Unable to add link cache");
+	fail_if(nl_cache_mngr_set_rxbuf_max(mngr, 1 << 20) != 0,
+		"Unable to set receive buffer limit");
+
+	/* a link the kernel does not know about */
+	queue_link(50001, 1000);
+	nl_cache_mngr_data_ready(mngr);
+	link = rtnl_link_get(links, 50001);
+	fail_if(!link, "Link not included");
+	rtnl_link_put(link);
+
+	/* notifications queued before the overrun are dropped and the
+	 * cache is resynced with the kernel */
+	queue_link(50002, 1000);
+	fake_overrun = 1;
+	fail_if(nl_cache_mngr_data_ready(mngr) < 0, "Recovery failed");
+
+	nl_cache_mngr_get_recovery_stats(mngr, &stats);
+	ck_assert_int_eq(stats.rv_overruns, 1);
+	ck_assert_int_eq(stats.rv_resyncs, 1);
+	ck_assert_int_eq(stats.rv_failures, 0);
+	fail_if(stats.rv_rxbuf <= 0, "Receive buffer not enlarged");
+	ck_assert_int_eq(ndel, 1);
+
+	link = rtnl_link_get(links, 50001);
+	fail_if(link, "Stale link kept");
+	rtnl_link_put(link);
+	link = rtnl_link_get(links, 50002);
+	fail_if(link, "Notification older than resync included");
+	rtnl_link_put(link);
+	link = rtnl_link_get(links, 1);
+	fail_if(!link, "Loopback link lost");
+	rtnl_link_put(link);
+
+	/* notifications are received again */
+	queue_link(50003, 1000);
+	nl_cache_mngr_data_ready(mngr);
+	link = rtnl_link_get(links, 50003);
+	fail_if(!link, "Link not included after recovery");
+	rtnl_link_put(link);
+
+	nl_cache_mngr_free(mngr);
+	nl_socket_free(sk);
+}
+END_TEST
+
+struct change_rec
+{
+	int		nchange;
+	int		action;
+	uint64_t	diff;
+};
+
+static void change_v2_cb(struct nl_cache *cache, struct nl_object *old,
+			 struct nl_object *obj, uint64_t diff, int action,
+			 void *data)
+{
+	struct change_rec *rec = data;
+
+	rec->nchange++;
+	rec->action = action;
+	rec->diff = diff;
+}
+
+static uint64_t link_mtu_diff(void)
+{
+	struct rtnl_link *a, *b;
+	uint64_t diff;
+
+	a = rtnl_link_alloc();
+	b = rtnl_link_alloc();
+	fail_if(!a || !b, "Unable to allocate links");
+	rtnl_link_set_mtu(a, 1000);
+	rtnl_link_set_mtu(b, 1500);
+	diff = nl_object_diff64((struct nl_object *) a, (struct nl_object *) b);
+	rtnl_link_put(a);
+	rtnl_link_put(b);
+
+	return diff;
+}
+
+START_TEST(mngr_coalesce)
+{
+	struct change_rec rec = { 0 };
+	struct nl_cache_mngr *mngr;
+	struct nl_cache *links;
+	struct rtnl_link *link;
+	struct nl_sock *sk;
+	uint64_t mtu_diff = link_mtu_diff();
+
+	mngr = alloc_fake_mngr(&sk, NL_AUTO_PROVIDE);
+	fail_if(nl_cache_alloc_name("route/link", &links) < 0,
+		"Unable to allocate link cache");
+	fail_if(nl_cache_mngr_add_cache_v2(mngr, links, change_v2_cb, &rec) != 0,
+		"Unable to add link cache");
+	fail_if(nl_cache_mngr_set_coalesce(mngr, 60000) != 0,
+		"Unable to set coalescing window");
+
+	queue_link(20001, 1000);
+	nl_cache_mngr_data_ready(mngr);
+	ck_assert_int_eq(rec.nchange, 0);
+	ck_assert_int_eq(nl_cache_mngr_flush(mngr), 1);
+	ck_assert_int_eq(rec.nchange, 1);
+	ck_assert_int_eq(rec.action, NL_ACT_NEW);
+
+	/* a change reverted within the window is still reported */
+	rec.nchange = 0;
+	queue_link(20001, 1500);
+	queue_link(20001, 1000);
+	nl_cache_mngr_data_ready(mngr);
+	ck_assert_int_eq(nl_cache_mngr_flush(mngr), 1);
+	ck_assert_int_eq(rec.nchange, 1);
+	ck_assert_int_eq(rec.action, NL_ACT_CHANGE);
+	fail_if(!(rec.diff & mtu_diff), "MTU change not reported");
+
+	/* a link added and removed within the window is never seen */
+	rec.nchange = 0;
+	queue_link(20002, 1000);
+	queue_link(20002, 1500);
+	queue_link_msg(RTM_DELLINK, 20002, 1500);
+	nl_cache_mngr_data_ready(mngr);
+	ck_assert_int_eq(nl_cache_mngr_flush(mngr), 1);
+	ck_assert_int_eq(rec.nchange, 0);
+	link = rtnl_link_get(links, 20002);
+	fail_if(link, "Removed link cached");
+	rtnl_link_put(link);
+
+	nl_cache_mngr_free(mngr);
+	nl_socket_free(sk);
+}
+END_TEST
+
+Suite *make_nl_cache_mngr_suite(void)
+{
+	Suite *suite = suite_create("Cache manager");
+
+	TCase *tc_mngr = tcase_create("Core");
+	tcase_add_test(tc_mngr, mngr_workers_link_addr);
+	tcase_add_test(tc_mngr, mngr_coalesce);
+	tcase_add_test(tc_mngr, mngr_dispatch_first);
+	tcase_add_test(tc_mngr, mngr_overrun_recovery);
+	suite_add_tcase(suite, tc_mngr);
+
+	return suite;
+}
@@ -0,0 +1,764 @@
+/*
+ * tests/check-cache.c		Cache unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <pthread.h>
+#include <netlink-private/netlink.h>
+#include <netlink/cache.h>
+#include <netlink/hashtable.h>
+#include <netlink/route/link.h>
+#include <netlink/route/route.h>
+#include <netlink/route/qdisc.h>
+#include <netlink/route/class.h>
+#include <netlink/route/classifier.h>
+
+#include "util.h"
+
+START_TEST(tc_cache_lookup)
+{
+	struct nl_cache *qdiscs, *classes;
+	struct rtnl_qdisc *qdisc;
+	struct rtnl_class *class;
+	int i;
+
+	fail_if(nl_cache_alloc_name("route/qdisc", &qdiscs) != 0,
+		"Unable to allocate qdisc cache");
+	fail_if(nl_cache_alloc_name("route/class", &classes) != 0,
+		"Unable to allocate class cache");
+
+	/* default qdiscs of a multiqueue device all lack a handle */
+	for (i = 1; i <= 8; i++) {
+		qdisc = rtnl_qdisc_alloc();
+		rtnl_tc_set_ifindex(TC_CAST(qdisc), 1);
+		rtnl_tc_set_handle(TC_CAST(qdisc), 0);
+		rtnl_tc_set_parent(TC_CAST(qdisc), TC_HANDLE(0x100, i));
+		fail_if(nl_cache_add(qdiscs, OBJ_CAST(qdisc)) != 0,
+			"Unable to add qdisc %d", i);
+		rtnl_qdisc_put(qdisc);
+	}
+
+	for (i = 1; i <= NLINKS; i++) {
+		class = rtnl_class_alloc();
+		rtnl_tc_set_ifindex(TC_CAST(class), 1);
+		rtnl_tc_set_handle(TC_CAST(class), TC_HANDLE(1, i));
+		rtnl_tc_set_parent(TC_CAST(class), TC_HANDLE(1, 0));
+		fail_if(nl_cache_add(classes, OBJ_CAST(class)) != 0,
+			"Unable to add class %d", i);
+		rtnl_class_put(class);
+
+		qdisc = rtnl_qdisc_alloc();
+		rtnl_tc_set_ifindex(TC_CAST(qdisc), 1);
+		rtnl_tc_set_handle(TC_CAST(qdisc), TC_HANDLE(i + 1, 0));
+		rtnl_tc_set_parent(TC_CAST(qdisc), TC_HANDLE(1, i));
+		fail_if(nl_cache_add(qdiscs, OBJ_CAST(qdisc)) != 0,
+			"Unable to add qdisc for class %d", i);
+		rtnl_qdisc_put(qdisc);
+	}
+
+	for (i = 1; i <= NLINKS; i++) {
+		class = rtnl_class_get(classes, 1, TC_HANDLE(1, i));
+		fail_if(!class, "Class %d not found", i);
+		rtnl_class_put(class);
+
+		qdisc = rtnl_qdisc_get(qdiscs, 1, TC_HANDLE(i + 1, 0));
+		fail_if(!qdisc || rtnl_tc_get_parent(TC_CAST(qdisc)) !=
+			TC_HANDLE(1, i), "Qdisc of class %d not found", i);
+		rtnl_qdisc_put(qdisc);
+	}
+
+	fail_if(rtnl_class_get(classes, 2, TC_HANDLE(1, 1)) != NULL,
+		"Class found on wrong device");
+
+	qdisc = rtnl_qdisc_get_by_parent(qdiscs, 1, TC_HANDLE(0x100, 5));
+	fail_if(!qdisc, "Default qdisc not found");
+	rtnl_qdisc_put(qdisc);
+
+	nl_cache_free(qdiscs);
+	nl_cache_free(classes);
+}
+END_TEST
+
+static struct rtnl_cls *alloc_cls(int prio)
+{
+	struct rtnl_cls *cls;
+
+	cls = rtnl_cls_alloc();
+	fail_if(!cls, "Unable to allocate classifier");
+	rtnl_tc_set_ifindex(TC_CAST(cls), 1);
+	rtnl_tc_set_handle(TC_CAST(cls), 0x800);
+	rtnl_tc_set_parent(TC_CAST(cls), TC_HANDLE(1, 0));
+	rtnl_cls_set_protocol(cls, 0x0800);
+	if (prio)
+		rtnl_cls_set_prio(cls, prio);
+
+	return cls;
+}
+
+START_TEST(tc_cls_identity)
+{
+	struct nl_cache *cache;
+	struct rtnl_cls *a, *b, *c;
+	struct nl_object *found;
+
+	fail_if(nl_cache_alloc_name("route/cls", &cache) != 0,
+		"Unable to allocate classifier cache");
+
+	/* the same handle at two priorities names two filters */
+	a = alloc_cls(1);
+	b = alloc_cls(2);
+	fail_if(nl_object_identical(OBJ_CAST(a), OBJ_CAST(b)),
+		"Classifiers of different priority are identical");
+	fail_if(nl_cache_add(cache, OBJ_CAST(a)) != 0, "Unable to add a");
+	fail_if(nl_cache_add(cache, OBJ_CAST(b)) != 0, "Unable to add b");
+	ck_assert_int_eq(nl_cache_nitems(cache), 2);
+
+	c = alloc_cls(2);
+	found = nl_cache_search(cache, OBJ_CAST(c));
+	fail_if(found != OBJ_CAST(b), "Classifier not found by priority");
+	nl_object_put(found);
+	rtnl_cls_put(c);
+
+	/* a priority of zero is not reported and does not match any */
+	c = alloc_cls(0);
+	fail_if(nl_object_identical(OBJ_CAST(a), OBJ_CAST(c)),
+		"Classifier without priority is identical to one with");
+	fail_if(nl_cache_search(cache, OBJ_CAST(c)) != NULL,
+		"Classifier without priority found");
+	rtnl_cls_put(c);
+
+	rtnl_cls_put(a);
+	rtnl_cls_put(b);
+	nl_cache_free(cache);
+}
+END_TEST
+
+#define NSTABLE 64
+
+struct concurrent_reader
+{
+	struct nl_cache *	cache;
+	int *			stop;
+	unsigned long		lookups;
+	int			failed;
+};
+
+static void *concurrent_reader(void *arg)
+{
+	struct concurrent_reader *r = arg;
+	struct rtnl_link *link;
+	char name[IFNAMSIZ];
+	int i = 0;
+
+	while (!__atomic_load_n(r->stop, __ATOMIC_RELAXED) && !r->failed) {
+		i = i % NSTABLE + 1;
+
+		link = rtnl_link_get(r->cache, i);
+		if (!link || rtnl_link_get_ifindex(link) != i)
+			r->failed = i;
+		rtnl_link_put(link);
+
+		snprintf(name, sizeof(name), "stable%d", i);
+		link = rtnl_link_get_by_name(r->cache, name);
+		if (!link || rtnl_link_get_ifindex(link) != i)
+			r->failed = i;
+		rtnl_link_put(link);
+
+		/* links being added and removed, found or not */
+		link = rtnl_link_get(r->cache, NSTABLE + i);
+		if (link && rtnl_link_get_ifindex(link) != NSTABLE + i)
+			r->failed = NSTABLE + i;
+		rtnl_link_put(link);
+
+		r->lookups++;
+	}
+
+	return NULL;
+}
+
+START_TEST(cache_concurrent_lookup)
+{
+	struct concurrent_reader readers[4];
+	pthread_t threads[4];
+	int stop = 0;
+	struct nl_cache *cache;
+	struct rtnl_link *link;
+	char name[IFNAMSIZ];
+	int i, round;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+	nl_cache_set_flags(cache, NL_CACHE_CONCURRENT);
+
+	for (i = 1; i <= NSTABLE; i++) {
+		link = alloc_link(i);
+		snprintf(name, sizeof(name), "stable%d", i);
+		rtnl_link_set_name(link, name);
+		nl_cache_add(cache, OBJ_CAST(link));
+		rtnl_link_put(link);
+	}
+
+	for (i = 0; i < 4; i++) {
+		readers[i] = (struct concurrent_reader) {
+			.cache = cache,
+			.stop = &stop,
+		};
+		fail_if(pthread_create(&threads[i], NULL, concurrent_reader,
+				       &readers[i]) != 0,
+			"Unable to start reader");
+	}
+
+	/* grow and shrink the hashtable and indexes over and over */
+	for (round = 0; round < 20; round++) {
+		for (i = NSTABLE + 1; i <= NLINKS; i++) {
+			link = alloc_link(i);
+			snprintf(name, sizeof(name), "churn%d", i);
+			rtnl_link_set_name(link, name);
+			nl_cache_add(cache, OBJ_CAST(link));
+			rtnl_link_put(link);
+		}
+
+		for (i = NSTABLE + 1; i <= NLINKS; i++) {
+			link = rtnl_link_get(cache, i);
+			nl_cache_remove(OBJ_CAST(link));
+			rtnl_link_put(link);
+		}
+	}
+
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+	for (i = 0; i < 4; i++) {
+		pthread_join(threads[i], NULL);
+		fail_if(readers[i].failed, "Lookup of link %d failed",
+			readers[i].failed);
+		fail_if(!readers[i].lookups, "Reader did not run");
+	}
+
+	nl_cache_free(cache);
+}
+END_TEST
+
+struct snapshot_diff
+{
+	int	added;
+	int	removed;
+	int	changed;
+};
+
+static void snapshot_diff_cb(struct nl_object *a, struct nl_object *b,
+			     void *arg)
+{
+	struct snapshot_diff *d = arg;
+
+	if (!a)
+		d->added = rtnl_link_get_ifindex((struct rtnl_link *) b);
+	else if (!b)
+		d->removed = rtnl_link_get_ifindex((struct rtnl_link *) a);
+	else
+		d->changed = rtnl_link_get_ifindex((struct rtnl_link *) b);
+}
+
+START_TEST(cache_snapshot_diff)
+{
+	struct nl_cache_snapshot *s1, *s2;
+	struct snapshot_diff d = { 0 };
+	struct nl_cache *cache;
+	struct rtnl_link *link;
+	int i;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+
+	for (i = 1; i <= 100; i++) {
+		link = alloc_link(i);
+		nl_cache_add(cache, OBJ_CAST(link));
+		rtnl_link_put(link);
+	}
+
+	s1 = nl_cache_snapshot(cache);
+	fail_if(!s1, "Unable to take snapshot");
+	fail_if(nl_cache_snapshot_nitems(s1) != 100, "Wrong number of objects");
+
+	/* objects are shared, not copied */
+	link = rtnl_link_get(cache, 1);
+	fail_if(nl_cache_snapshot_get(s1, 0) != OBJ_CAST(link),
+		"Object not shared with snapshot");
+	rtnl_link_put(link);
+
+	link = rtnl_link_get(cache, 5);
+	nl_cache_remove(OBJ_CAST(link));
+	rtnl_link_put(link);
+
+	link = rtnl_link_get(cache, 7);
+	nl_cache_remove(OBJ_CAST(link));
+	rtnl_link_put(link);
+	link = alloc_link(7);
+	rtnl_link_set_mtu(link, 9000);
+	nl_cache_add(cache, OBJ_CAST(link));
+	rtnl_link_put(link);
+
+	link = alloc_link(101);
+	nl_cache_add(cache, OBJ_CAST(link));
+	rtnl_link_put(link);
+
+	/* removed objects remain part of the snapshot */
+	fail_if(rtnl_link_get_ifindex((struct rtnl_link *)
+				      nl_cache_snapshot_get(s1, 4)) != 5,
+		"Removed object not in snapshot");
+
+	s2 = nl_cache_snapshot(cache);
+	fail_if(nl_cache_snapshot_diff(s1, s2, snapshot_diff_cb, &d) != 3,
+		"Expected 3 differences");
+	fail_if(d.added != 101 || d.removed != 5 || d.changed != 7,
+		"Wrong differences reported");
+	fail_if(nl_cache_snapshot_diff(s2, s2, snapshot_diff_cb, &d) != 0,
+		"Snapshot differs from itself");
+
+	nl_cache_snapshot_free(s1);
+	nl_cache_snapshot_free(s2);
+	nl_cache_free(cache);
+}
+END_TEST
+
+static struct nl_msg *build_route6_msg(int gw)
+{
+	struct rtmsg rtm = {
+		.rtm_family = AF_INET6,
+		.rtm_dst_len = 48,
+		.rtm_table = RT_TABLE_MAIN,
+		.rtm_protocol = RTPROT_STATIC,
+		.rtm_scope = RT_SCOPE_UNIVERSE,
+		.rtm_type = RTN_UNICAST,
+	};
+	struct in6_addr dst = { .s6_addr = { 0x20, 0x01, 0x0d, 0xb8, 0, 1 } };
+	struct in6_addr gateway = { .s6_addr = { 0xfe, 0x80, [15] = gw } };
+	struct nl_msg *msg;
+
+	msg = nlmsg_alloc_simple(RTM_NEWROUTE, 0);
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_set_proto(msg, NETLINK_ROUTE);
+	fail_if(nlmsg_append(msg, &rtm, sizeof(rtm), NLMSG_ALIGNTO) < 0 ||
+		nla_put(msg, RTA_DST, sizeof(dst), &dst) < 0 ||
+		nla_put(msg, RTA_GATEWAY, sizeof(gateway), &gateway) < 0 ||
+		nla_put_u32(msg, RTA_OIF, 1) < 0 ||
+		nla_put_u32(msg, RTA_PRIORITY, 1024) < 0,
+		"Unable to build message");
+
+	return msg;
+}
+
+struct route_changes
+{
+	struct nl_cache *	cache;
+	int			n;
+	uint64_t		diff;
+	int			old_nnexthops;
+};
+
+static void route_change_cb(struct nl_cache *cache, struct nl_object *old,
+			    struct nl_object *new, uint64_t diff, int action,
+			    void *arg)
+{
+	struct route_changes *c = arg;
+
+	c->n++;
+	c->diff = diff;
+	c->old_nnexthops = old ?
+		rtnl_route_get_nnexthops((struct rtnl_route *) old) : 0;
+}
+
+static void include_route_cb(struct nl_object *obj, void *arg)
+{
+	struct route_changes *c = arg;
+
+	fail_if(nl_cache_include_v2(c->cache, obj, route_change_cb, c) != 0,
+		"Unable to include route");
+}
+
+static void include_route6(struct route_changes *c, int gw)
+{
+	struct nl_msg *msg = build_route6_msg(gw);
+
+	fail_if(nl_msg_parse(msg, include_route_cb, c) != 0,
+		"Unable to parse route");
+	nlmsg_free(msg);
+}
+
+START_TEST(route_include_unchanged)
+{
+	struct route_changes c = { 0 };
+	struct rtnl_route *route;
+	struct nl_object *cached;
+
+	fail_if(nl_cache_alloc_name("route/route", &c.cache) != 0,
+		"Unable to allocate route cache");
+
+	include_route6(&c, 1);
+	fail_if(c.n != 1 || c.old_nnexthops != 0, "Route not added");
+	cached = nl_cache_get_first(c.cache);
+
+	/* a notification repeating the route is neither merged nor reported,
+	 * the cached route is kept */
+	include_route6(&c, 1);
+	fail_if(c.n != 1, "Unchanged route reported");
+	fail_if(nl_cache_get_first(c.cache) != cached,
+		"Unchanged route replaced");
+	route = (struct rtnl_route *) cached;
+	fail_if(nl_cache_nitems(c.cache) != 1 ||
+		rtnl_route_get_nnexthops(route) != 1,
+		"Unchanged route merged");
+
+	/* a second nexthop is merged, the old state is passed along */
+	include_route6(&c, 2);
+	fail_if(c.n != 2 || !c.diff || c.old_nnexthops != 1,
+		"Nexthop not reported");
+	route = (struct rtnl_route *) nl_cache_get_first(c.cache);
+	fail_if(rtnl_route_get_nnexthops(route) != 2, "Nexthop not merged");
+
+	nl_cache_free(c.cache);
+}
+END_TEST
+
+START_TEST(route_resync_unchanged)
+{
+	struct nl_cache_resync_stats stats;
+	struct nl_object *first, *found;
+	struct nl_cache *cache;
+	struct nl_sock *sk;
+	int n;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+	fail_if(rtnl_route_alloc_cache(sk, AF_UNSPEC, 0, &cache) < 0,
+		"Unable to fill route cache");
+	n = nl_cache_nitems(cache);
+	first = nl_cache_get_first(cache);
+
+	/* routes repeated by the dump are kept and stay current */
+	fail_if(nl_cache_resync(sk, cache, NULL, NULL) < 0,
+		"Unable to resync cache");
+	nl_cache_get_resync_stats(cache, &stats);
+	ck_assert_int_eq(stats.rs_removed, 0);
+	ck_assert_int_eq(nl_cache_nitems(cache), n);
+	if (n) {
+		found = nl_cache_search(cache, first);
+		fail_if(found != first, "Unchanged route replaced");
+		nl_object_put(found);
+	}
+
+	nl_cache_free(cache);
+	nl_socket_free(sk);
+}
+END_TEST
+
+START_TEST(route_include_keeps_order)
+{
+	struct route_changes c = { 0 };
+	struct rtnl_route *first, *other;
+	struct nl_addr *dst;
+
+	fail_if(nl_cache_alloc_name("route/route", &c.cache) != 0,
+		"Unable to allocate route cache");
+
+	include_route6(&c, 1);
+	first = (struct rtnl_route *) nl_cache_get_first(c.cache);
+
+	fail_if(nl_addr_parse("2001:db8:2::/48", AF_INET6, &dst) != 0,
+		"Unable to parse address");
+	other = rtnl_route_alloc();
+	fail_if(!other, "Unable to allocate route");
+	rtnl_route_set_family(other, AF_INET6);
+	rtnl_route_set_table(other, RT_TABLE_MAIN);
+	rtnl_route_set_dst(other, dst);
+	nl_addr_put(dst);
+	fail_if(nl_cache_add(c.cache, OBJ_CAST(other)) != 0,
+		"Unable to add route");
+	rtnl_route_put(other);
+
+	/* merging a notification does not move the route */
+	include_route6(&c, 2);
+	fail_if(c.n != 2, "Nexthop not reported");
+	fail_if(nl_cache_get_first(c.cache) != OBJ_CAST(first),
+		"Merged route moved");
+	fail_if(nl_cache_get_last(c.cache) != OBJ_CAST(other),
+		"Order of the cache changed");
+
+	nl_cache_free(c.cache);
+}
+END_TEST
+
+static void count_del_cb(struct nl_cache *cache, struct nl_object *obj,
+			 int action, void *arg)
+{
+	if (action == NL_ACT_DEL)
+		(*(int *) arg)++;
+}
+
+START_TEST(cache_resync_sweep)
+{
+	struct nl_cache_resync_stats stats;
+	struct rtnl_link *link, *stale;
+	struct nl_cache *cache;
+	struct nl_sock *sk;
+	int ndel = 0;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+	fail_if(rtnl_link_alloc_cache(sk, AF_UNSPEC, &cache) < 0,
+		"Unable to fill link cache");
+
+	/* a link unknown to the kernel, e.g. one whose removal was missed */
+	stale = alloc_link(30001);
+	rtnl_link_set_name(stale, "stale0");
+	fail_if(nl_cache_add(cache, OBJ_CAST(stale)) != 0,
+		"Unable to add link");
+	rtnl_link_put(stale);
+
+	fail_if(nl_cache_resync(sk, cache, count_del_cb, &ndel) < 0,
+		"Unable to resync cache");
+	nl_cache_get_resync_stats(cache, &stats);
+
+	ck_assert_int_eq(ndel, 1);
+	ck_assert_int_eq(stats.rs_removed, 1);
+	ck_assert_int_eq(stats.rs_received, nl_cache_nitems(cache));
+
+	link = rtnl_link_get(cache, 30001);
+	fail_if(link, "Stale link kept");
+	rtnl_link_put(link);
+
+	link = rtnl_link_get(cache, 1);
+	fail_if(!link, "Loopback link removed");
+	rtnl_link_put(link);
+
+	nl_cache_free(cache);
+	nl_socket_free(sk);
+}
+END_TEST
+
+static struct nl_cache *fill_addr_cache(struct nl_sock *sk, unsigned int flags)
+{
+	struct nl_cache *cache;
+
+	fail_if(nl_cache_alloc_name("route/addr", &cache) != 0,
+		"Unable to allocate address cache");
+	nl_cache_set_flags(cache, flags);
+	fail_if(nl_cache_refill(sk, cache) < 0, "Unable to fill cache");
+
+	return cache;
+}
+
+START_TEST(cache_dump_parallel)
+{
+	struct nl_cache *serial, *parallel;
+	struct nl_object *obj, *found;
+	struct nl_sock *sk;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+
+	serial = fill_addr_cache(sk, NL_CACHE_AF_ITER);
+	parallel = fill_addr_cache(sk, NL_CACHE_AF_ITER | NL_CACHE_AF_PARALLEL);
+
+	/* every family is dumped once, in the order of the families */
+	ck_assert_int_eq(nl_cache_nitems(parallel), nl_cache_nitems(serial));
+	found = nl_cache_get_first(parallel);
+	for (obj = nl_cache_get_first(serial); obj;
+	     obj = nl_cache_get_next(obj)) {
+		fail_if(!found || !nl_object_identical(obj, found),
+			"Objects of parallel dump differ");
+		found = nl_cache_get_next(found);
+	}
+
+	nl_cache_free(serial);
+	nl_cache_free(parallel);
+	nl_socket_free(sk);
+}
+END_TEST
+
+static int stream_count_cb(struct nl_object *obj, void *arg)
+{
+	(*(int *) arg)++;
+
+	return NL_OK;
+}
+
+static int stream_stop_cb(struct nl_object *obj, void *arg)
+{
+	(*(int *) arg)++;
+
+	return NL_STOP;
+}
+
+START_TEST(cache_stream_stop)
+{
+	struct nl_cache *cache;
+	struct nl_sock *sk;
+	int n = 0, nstop = 0, nagain = 0, ret;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+
+	ret = nl_cache_stream(sk, cache, stream_count_cb, &n);
+	fail_if(ret < 1, "No links streamed");
+	ck_assert_int_eq(ret, n);
+	ck_assert_int_eq(nl_cache_nitems(cache), 0);
+
+	/* the rest of the dump is drained, the socket remains usable */
+	ck_assert_int_eq(nl_cache_stream(sk, cache, stream_stop_cb, &nstop), 1);
+	ck_assert_int_eq(nstop, 1);
+	ck_assert_int_eq(nl_cache_stream(sk, cache, stream_count_cb, &nagain), n);
+	ck_assert_int_eq(nagain, n);
+
+	nl_cache_free(cache);
+	nl_socket_free(sk);
+}
+END_TEST
+
+START_TEST(cache_arena_outlives_cache)
+{
+	struct rtnl_link *link;
+	struct nl_cache *cache;
+	struct nl_addr *addr;
+	struct nl_sock *sk;
+	char name[IFNAMSIZ];
+	int ifindex;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+	nl_cache_set_flags(cache, NL_CACHE_ARENA);
+	fail_if(nl_cache_refill(sk, cache) < 0, "Unable to fill cache");
+
+	link = (struct rtnl_link *) nl_cache_get_first(cache);
+	fail_if(!link, "No link received");
+	nl_object_get(OBJ_CAST(link));
+	ifindex = rtnl_link_get_ifindex(link);
+	snprintf(name, sizeof(name), "%s", rtnl_link_get_name(link));
+	addr = rtnl_link_get_addr(link);
+	if (addr)
+		nl_addr_get(addr);
+
+	/* objects and addresses keep their block of the arena */
+	nl_cache_free(cache);
+
+	ck_assert_int_eq(rtnl_link_get_ifindex(link), ifindex);
+	ck_assert_str_eq(rtnl_link_get_name(link), name);
+	rtnl_link_put(link);
+
+	if (addr) {
+		fail_if(nl_addr_get_len(addr) > 32, "Address corrupted");
+		nl_addr_put(addr);
+	}
+
+	nl_socket_free(sk);
+}
+END_TEST
+
+START_TEST(cache_arena_resync)
+{
+	struct rtnl_link *link;
+	struct nl_cache *cache;
+	struct nl_sock *sk;
+	int ifindex;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+	nl_cache_set_flags(cache, NL_CACHE_ARENA);
+	fail_if(nl_cache_refill(sk, cache) < 0, "Unable to fill cache");
+
+	link = (struct rtnl_link *) nl_cache_get_first(cache);
+	fail_if(!link, "No link received");
+	fail_if(!(link->ce_flags & NL_OBJ_ARENA), "Link not from arena");
+	ifindex = rtnl_link_get_ifindex(link);
+	nl_cache_remove(OBJ_CAST(link));
+
+	/* objects merged into a filled cache are allocated one by one */
+	fail_if(nl_cache_resync(sk, cache, NULL, NULL) < 0,
+		"Unable to resync cache");
+	link = rtnl_link_get(cache, ifindex);
+	fail_if(!link, "Removed link not received again");
+	fail_if(link->ce_flags & NL_OBJ_ARENA, "Resynced link from arena");
+	rtnl_link_put(link);
+
+	nl_cache_free(cache);
+	nl_socket_free(sk);
+}
+END_TEST
+
+START_TEST(cache_index_grows)
+{
+	struct nl_hash_table_stats stats;
+	struct rtnl_link *link;
+	struct nl_cache *cache;
+	int i;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+
+	/* an empty cache must not pay for a full sized index */
+	nl_hash_table_get_stats(cache->hashtable, &stats);
+	fail_if(stats.hs_size > 16, "Empty cache index has %u slots",
+		stats.hs_size);
+
+	for (i = 1; i <= NLINKS; i++) {
+		link = alloc_link(i);
+		fail_if(nl_cache_add(cache, OBJ_CAST(link)) != 0,
+			"Unable to add link %d", i);
+		rtnl_link_put(link);
+	}
+
+	nl_hash_table_get_stats(cache->hashtable, &stats);
+	fail_if(stats.hs_size < NLINKS, "Cache index did not grow");
+
+	for (i = 1; i <= NLINKS; i++) {
+		struct nl_object *found;
+
+		link = alloc_link(i);
+		found = nl_cache_search(cache, OBJ_CAST(link));
+		rtnl_link_put(link);
+		fail_if(!found, "Link %d not found", i);
+		nl_object_put(found);
+	}
+
+	nl_cache_free(cache);
+}
+END_TEST
+
+Suite *make_nl_cache_suite(void)
+{
+	Suite *suite = suite_create("Caches");
+
+	TCase *tc_cache = tcase_create("Core");
+	tcase_add_test(tc_cache, tc_cache_lookup);
+	tcase_add_test(tc_cache, tc_cls_identity);
+	tcase_add_test(tc_cache, cache_concurrent_lookup);
+	tcase_add_test(tc_cache, cache_snapshot_diff);
+	tcase_add_test(tc_cache, route_include_unchanged);
+	tcase_add_test(tc_cache, route_resync_unchanged);
+	tcase_add_test(tc_cache, route_include_keeps_order);
+	tcase_add_test(tc_cache, cache_resync_sweep);
+	tcase_add_test(tc_cache, cache_dump_parallel);
+	tcase_add_test(tc_cache, cache_stream_stop);
+	tcase_add_test(tc_cache, cache_arena_outlives_cache);
+	tcase_add_test(tc_cache, cache_arena_resync);
+	tcase_add_test(tc_cache, cache_index_grows);
+	suite_add_tcase(suite, tc_cache);
+
+	return suite;
+}
@@ -0,0 +1,169 @@
+/*
+ * tests/check-hashtable.c	nl_hash_table unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <netlink/object.h>
+#include <netlink/hashtable.h>
+#include <netlink/route/link.h>
+
+#include "util.h"
+
+static void check_lookup_all(nl_hash_table_t *ht, int first, int last)
+{
+	struct rtnl_link *needle;
+	int i;
+
+	for (i = first; i <= last; i++) {
+		needle = alloc_link(i);
+		fail_if(!nl_hash_table_lookup(ht, OBJ_CAST(needle)),
+			"Link %d not found", i);
+		rtnl_link_put(needle);
+	}
+}
+
+static void check_resize(int flags)
+{
+	struct nl_hash_table_stats stats;
+	struct rtnl_link *link;
+	nl_hash_table_t *ht;
+	int i;
+
+	ht = nl_hash_table_alloc_flags(8, flags);
+	fail_if(!ht, "Unable to allocate hashtable");
+
+	for (i = 1; i <= NLINKS; i++) {
+		link = alloc_link(i);
+		fail_if(nl_hash_table_add(ht, OBJ_CAST(link)) != 0,
+			"Unable to add link %d", i);
+		rtnl_link_put(link);
+
+		/* lookups must succeed while objects are being moved */
+		if (i % 500 == 0)
+			check_lookup_all(ht, 1, i);
+	}
+
+	link = alloc_link(1);
+	fail_if(nl_hash_table_add(ht, OBJ_CAST(link)) != -NLE_EXIST,
+		"Duplicate link added");
+	rtnl_link_put(link);
+
+	nl_hash_table_get_stats(ht, &stats);
+	fail_if(stats.hs_entries != NLINKS, "Expected %d entries, got %u",
+		NLINKS, stats.hs_entries);
+	fail_if(stats.hs_size < NLINKS / 2, "Hashtable did not grow");
+
+	for (i = 1; i <= NLINKS - 10; i++) {
+		link = alloc_link(i);
+		fail_if(nl_hash_table_del(ht, OBJ_CAST(link)) != 0,
+			"Unable to delete link %d", i);
+		rtnl_link_put(link);
+	}
+
+	check_lookup_all(ht, NLINKS - 9, NLINKS);
+
+	nl_hash_table_get_stats(ht, &stats);
+	fail_if(stats.hs_entries != 10, "Expected 10 entries, got %u",
+		stats.hs_entries);
+	fail_if(stats.hs_size > 64, "Hashtable did not shrink");
+
+	nl_hash_table_free(ht);
+}
+
+START_TEST(hashtable_resize)
+{
+	check_resize(0);
+}
+END_TEST
+
+START_TEST(hashtable_open_resize)
+{
+	check_resize(NL_HASH_TABLE_OPEN);
+}
+END_TEST
+
+#define NCHURN 300
+
+START_TEST(hashtable_open_churn)
+{
+	struct nl_hash_table_stats stats;
+	struct rtnl_link *link;
+	nl_hash_table_t *ht;
+	int i;
+
+	ht = nl_hash_table_alloc_flags(16, NL_HASH_TABLE_OPEN);
+	fail_if(!ht, "Unable to allocate hashtable");
+
+	/* a window of objects moving through the key space leaves
+	 * tombstones behind, the index must be rehashed to reclaim them
+	 * rather than grow or fill up */
+	for (i = 1; i <= 20 * NLINKS; i++) {
+		link = alloc_link(i);
+		fail_if(nl_hash_table_add(ht, OBJ_CAST(link)) != 0,
+			"Unable to add link %d", i);
+		rtnl_link_put(link);
+
+		if (i <= NCHURN)
+			continue;
+
+		link = alloc_link(i - NCHURN);
+		fail_if(nl_hash_table_del(ht, OBJ_CAST(link)) != 0,
+			"Unable to delete link %d", i - NCHURN);
+		rtnl_link_put(link);
+
+		if (i % NLINKS == 0) {
+			check_lookup_all(ht, i - NCHURN + 1, i);
+
+			nl_hash_table_get_stats(ht, &stats);
+			fail_if(stats.hs_entries != NCHURN,
+				"Expected %d entries, got %u", NCHURN,
+				stats.hs_entries);
+			fail_if(stats.hs_size > 8 * NCHURN,
+				"Hashtable grew to %u slots", stats.hs_size);
+		}
+	}
+
+	nl_hash_table_free(ht);
+}
+END_TEST
+
+START_TEST(hashtable_keygen_cache)
+{
+	struct rtnl_link *a, *b;
+	uint32_t ka, kb;
+
+	a = alloc_link(5);
+	b = alloc_link(6);
+
+	nl_object_keygen(OBJ_CAST(a), &ka, UINT32_MAX);
+	nl_object_keygen(OBJ_CAST(b), &kb, UINT32_MAX);
+	fail_if(ka == kb, "Distinct links should hash differently");
+
+	/* changing an identifying attribute must invalidate the cached key */
+	rtnl_link_set_ifindex(a, 6);
+	nl_object_keygen(OBJ_CAST(a), &ka, UINT32_MAX);
+	fail_if(ka != kb, "Stale hash key after changing ifindex");
+
+	rtnl_link_put(a);
+	rtnl_link_put(b);
+}
+END_TEST
+
+Suite *make_nl_hashtable_suite(void)
+{
+	Suite *suite = suite_create("Hashtable");
+
+	TCase *tc_ht = tcase_create("Core");
+	tcase_add_test(tc_ht, hashtable_resize);
+	tcase_add_test(tc_ht, hashtable_open_resize);
+	tcase_add_test(tc_ht, hashtable_open_churn);
+	tcase_add_test(tc_ht, hashtable_keygen_cache);
+	suite_add_tcase(suite, tc_ht);
+
+	return suite;
+}
@@ -0,0 +1,258 @@
+/*
+ * tests/check-link.c		Link cache unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <netlink-private/netlink.h>
+#include <netlink/cache.h>
+#include <netlink/route/link.h>
+#include <netlink/route/link/bridge.h>
+
+#include "util.h"
+
+START_TEST(link_cache_index)
+{
+	struct nl_cache *cache;
+	struct rtnl_link *link, *bridge, *inet6;
+	char name[IFNAMSIZ];
+	int i;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+
+	for (i = 1; i <= NLINKS; i++) {
+		link = alloc_link(i);
+		snprintf(name, sizeof(name), "dummy%d", i);
+		rtnl_link_set_name(link, name);
+		fail_if(nl_cache_add(cache, OBJ_CAST(link)) != 0,
+			"Unable to add link %d", i);
+		rtnl_link_put(link);
+	}
+
+	/* second entry of link 1 sharing ifindex and name */
+	bridge = alloc_link(1);
+	rtnl_link_set_family(bridge, AF_BRIDGE);
+	rtnl_link_set_name(bridge, "dummy1");
+	fail_if(nl_cache_add(cache, OBJ_CAST(bridge)) != 0,
+		"Unable to add bridge link");
+	inet6 = alloc_link(1);
+	rtnl_link_set_family(inet6, AF_INET6);
+	rtnl_link_set_name(inet6, "dummy1");
+	fail_if(nl_cache_add(cache, OBJ_CAST(inet6)) != 0,
+		"Unable to add inet6 link");
+
+	fail_if(rtnl_link_name2i(cache, "dummy4711") != 4711,
+		"Name lookup failed");
+	fail_if(!rtnl_link_i2name(cache, 42, name, sizeof(name)) ||
+		strcmp(name, "dummy42"), "Ifindex lookup failed");
+
+	/* rename, as done by cache updates: remove and add again */
+	link = rtnl_link_get(cache, 42);
+	nl_cache_remove(OBJ_CAST(link));
+	rtnl_link_set_name(link, "renamed");
+	nl_cache_add(cache, OBJ_CAST(link));
+	rtnl_link_put(link);
+
+	fail_if(rtnl_link_name2i(cache, "dummy42") != 0, "Stale name found");
+	fail_if(rtnl_link_name2i(cache, "renamed") != 42, "New name not found");
+
+	/* the remaining entries must be found after removing any one */
+	nl_cache_remove(OBJ_CAST(bridge));
+	rtnl_link_put(bridge);
+	fail_if(rtnl_link_name2i(cache, "dummy1") != 1,
+		"Link sharing the name not found");
+
+	link = rtnl_link_get(cache, 1);
+	nl_cache_remove(OBJ_CAST(link));
+	fail_if(rtnl_link_name2i(cache, "dummy1") != 1,
+		"Link sharing the name not found");
+	rtnl_link_put(link);
+
+	link = rtnl_link_get(cache, 1);
+	fail_if(link != inet6, "Link sharing the ifindex not found");
+	rtnl_link_put(link);
+
+	nl_cache_remove(OBJ_CAST(inet6));
+	rtnl_link_put(inet6);
+	fail_if(rtnl_link_get(cache, 1) != NULL, "Removed link found");
+
+	for (i = 2; i <= NLINKS; i++) {
+		link = rtnl_link_get(cache, i);
+		fail_if(!link, "Link %d not found", i);
+		nl_cache_remove(OBJ_CAST(link));
+		rtnl_link_put(link);
+	}
+
+	fail_if(!nl_cache_is_empty(cache), "Cache not empty");
+
+	nl_cache_free(cache);
+}
+END_TEST
+
+static struct nl_msg *build_link_msg(int ifindex, uint64_t rx_packets)
+{
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC, .ifi_index = ifindex };
+	struct rtnl_link_stats64 st = { .rx_packets = rx_packets };
+	struct nl_msg *msg;
+	char name[IFNAMSIZ];
+
+	snprintf(name, sizeof(name), "test%d", ifindex);
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, 0);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0 ||
+		nla_put_string(msg, IFLA_IFNAME, name) < 0 ||
+		nla_put(msg, IFLA_STATS64, sizeof(st), &st) < 0,
+		"Unable to build message");
+
+	return msg;
+}
+
+START_TEST(link_lazy_parse)
+{
+	struct nl_cache *cache;
+	struct nl_object *clone;
+	struct rtnl_link *link;
+	struct nl_msg *msg;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+	nl_cache_set_flags(cache, NL_CACHE_LAZY_PARSE);
+
+	/* accessors modify the objects, they can not be shared */
+	nl_cache_set_flags(cache, NL_CACHE_CONCURRENT);
+	fail_if(cache->c_flags & NL_CACHE_CONCURRENT,
+		"Concurrent lookups enabled for lazily parsed cache");
+	fail_if(nl_cache_snapshot(cache) != NULL,
+		"Snapshot taken of lazily parsed cache");
+
+	msg = build_link_msg(1, 42);
+	fail_if(nl_cache_parse_and_add(cache, msg) != 0, "Unable to parse");
+	nlmsg_free(msg);
+
+	link = rtnl_link_get(cache, 1);
+	fail_if(!link, "Link not in cache");
+
+	/* clones share the undecoded attributes and decode on their own */
+	clone = nl_object_clone(OBJ_CAST(link));
+	fail_if(!clone, "Unable to clone link");
+	fail_if(nl_object_diff64(OBJ_CAST(link), clone) != 0,
+		"Clone differs from link");
+	fail_if(rtnl_link_get_stat(link, RTNL_LINK_RX_PACKETS) != 42,
+		"Wrong statistics");
+	fail_if(rtnl_link_get_stat((struct rtnl_link *) clone,
+				   RTNL_LINK_RX_PACKETS) != 42,
+		"Wrong statistics in clone");
+	fail_if(nl_object_diff64(OBJ_CAST(link), clone) != 0,
+		"Clone differs from link after decoding");
+
+	nl_object_put(clone);
+	rtnl_link_put(link);
+	nl_cache_free(cache);
+}
+END_TEST
+
+static struct nl_msg *build_bridge_port_msg(int ifindex, uint8_t state,
+					    uint64_t rx_packets)
+{
+	struct ifinfomsg ifi = { .ifi_family = AF_BRIDGE, .ifi_index = ifindex };
+	struct rtnl_link_stats64 st = { .rx_packets = rx_packets };
+	struct nlattr *protinfo;
+	struct nl_msg *msg;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, 0);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0 ||
+		nla_put_string(msg, IFLA_IFNAME, "port") < 0 ||
+		nla_put(msg, IFLA_STATS64, sizeof(st), &st) < 0 ||
+		!(protinfo = nla_nest_start(msg, IFLA_PROTINFO | NLA_F_NESTED)) ||
+		nla_put_u8(msg, IFLA_BRPORT_STATE, state) < 0,
+		"Unable to build message");
+	nla_nest_end(msg, protinfo);
+
+	return msg;
+}
+
+static int include_link_cb(struct nl_object *obj, struct nl_parser_param *pp)
+{
+	return nl_cache_include(pp->pp_arg, obj, NULL, NULL);
+}
+
+/* Parses @msg as a notification for @cache, returns the link included */
+static struct rtnl_link *parse_lazy_link(struct nl_cache *cache,
+					 struct nl_msg *msg)
+{
+	struct nl_parser_param pp = {
+		.pp_cb = include_link_cb,
+		.pp_arg = cache,
+		.pp_flags = NL_CACHE_LAZY_PARSE,
+	};
+	struct nl_object *obj;
+	int err;
+
+	err = nl_cache_parse(nl_cache_get_ops(cache), NULL, nlmsg_hdr(msg), &pp);
+	nlmsg_free(msg);
+	fail_if(err < 0, "Unable to parse: %s", nl_geterror(err));
+
+	obj = nl_cache_get_first(cache);
+	fail_if(!obj || nl_cache_nitems(cache) != 1, "Link not included");
+	nl_object_get(obj);
+
+	return (struct rtnl_link *) obj;
+}
+
+START_TEST(link_lazy_protinfo)
+{
+	struct rtnl_link *a, *b, *c;
+	struct nl_cache *cache;
+
+	fail_if(nl_cache_alloc_name("route/link", &cache) != 0,
+		"Unable to allocate link cache");
+	nl_cache_set_flags(cache, NL_CACHE_LAZY_PARSE);
+
+	/* statistics differ, protocol info is equal */
+	a = parse_lazy_link(cache, build_bridge_port_msg(1, 3, 1));
+	b = parse_lazy_link(cache, build_bridge_port_msg(1, 3, 2));
+	fail_if(a == b, "Link not replaced");
+	fail_if(!a->l_lazy || !a->l_lazy_af, "Cached link decoded");
+	fail_if(nl_object_diff64(OBJ_CAST(a), OBJ_CAST(b)) != 0,
+		"Equal protocol info differs");
+
+	c = parse_lazy_link(cache, build_bridge_port_msg(1, 1, 3));
+	fail_if(!b->l_lazy || !b->l_lazy_af, "Cached link decoded");
+	fail_if(nl_object_diff64(OBJ_CAST(b), OBJ_CAST(c)) == 0,
+		"Protocol info change not detected");
+
+	/* compared to a decoded link, raw links stay raw */
+	fail_if(rtnl_link_bridge_get_port_state(a) != 3, "Wrong port state");
+	fail_if(a->l_lazy_af, "Protocol info not decoded");
+	fail_if(nl_object_diff64(OBJ_CAST(a), OBJ_CAST(b)) != 0,
+		"Equal protocol info differs after decoding");
+	fail_if(nl_object_diff64(OBJ_CAST(a), OBJ_CAST(c)) == 0,
+		"Protocol info change not detected after decoding");
+	fail_if(!b->l_lazy_af || !c->l_lazy_af, "Raw link decoded");
+
+	rtnl_link_put(a);
+	rtnl_link_put(b);
+	rtnl_link_put(c);
+	nl_cache_free(cache);
+}
+END_TEST
+
+Suite *make_nl_link_suite(void)
+{
+	Suite *suite = suite_create("Links");
+
+	TCase *tc_link = tcase_create("Core");
+	tcase_add_test(tc_link, link_cache_index);
+	tcase_add_test(tc_link, link_lazy_parse);
+	tcase_add_test(tc_link, link_lazy_protinfo);
+	suite_add_tcase(suite, tc_link);
+
+	return suite;
+}
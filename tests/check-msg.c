@@ -0,0 +1,251 @@
+/*
+ * tests/check-msg.c		nl_msg receive path unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+
+#include "util.h"
+
+#define NMSGS 3
+
+struct recv_state {
+	int nvalid;
+	struct nl_msg *kept;
+	struct nl_msg *copy;
+};
+
+/* Build a single datagram carrying NMSGS messages with one u32 attribute */
+static int fake_recv(struct nl_sock *sk, struct sockaddr_nl *nla,
+		     unsigned char **buf, struct ucred **creds)
+{
+	unsigned char *data;
+	int i, len = 0;
+
+	data = calloc(1, 4096);
+	if (!data)
+		return -NLE_NOMEM;
+
+	for (i = 0; i < NMSGS; i++) {
+		struct nl_msg *msg;
+
+		msg = nlmsg_alloc_simple(NLMSG_MIN_TYPE + i, 0);
+		if (!msg || nla_put_u32(msg, 1, 100 + i) < 0) {
+			nlmsg_free(msg);
+			free(data);
+			return -NLE_NOMEM;
+		}
+
+		memcpy(data + len, nlmsg_hdr(msg), nlmsg_hdr(msg)->nlmsg_len);
+		len += NLMSG_ALIGN(nlmsg_hdr(msg)->nlmsg_len);
+		nlmsg_free(msg);
+	}
+
+	*buf = data;
+	if (creds)
+		*creds = NULL;
+
+	return len;
+}
+
+static int valid_cb(struct nl_msg *msg, void *arg)
+{
+	struct recv_state *st = arg;
+
+	if (st->nvalid++ == 1) {
+		nlmsg_get(msg);
+		st->kept = msg;
+		st->copy = nlmsg_clone(msg);
+	}
+
+	return NL_OK;
+}
+
+static void run_recv(int zero_copy)
+{
+	struct recv_state st = { 0 };
+	struct nl_sock *sk;
+	struct nl_cb *cb;
+	struct nlattr *a;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+
+	nl_socket_disable_auto_ack(sk);
+	if (zero_copy)
+		nl_socket_enable_zero_copy(sk);
+
+	cb = nl_socket_get_cb(sk);
+	nl_cb_overwrite_recv(cb, fake_recv);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, valid_cb, &st);
+
+	fail_if(nl_recvmsgs_report(sk, cb) != NMSGS,
+		"Expected %d messages to be parsed", NMSGS);
+	fail_if(st.nvalid != NMSGS, "Valid callback not called for every message");
+	fail_if(!st.kept || !st.copy, "Message not retained");
+
+	a = nlmsg_find_attr(nlmsg_hdr(st.kept), 0, 1);
+	fail_if(!a || nla_get_u32(a) != 101,
+		"Retained message does not carry the expected payload");
+
+	fail_if(nlmsg_hdr(st.copy) == nlmsg_hdr(st.kept),
+		"nlmsg_clone() did not copy the payload");
+	fail_if(memcmp(nlmsg_hdr(st.copy), nlmsg_hdr(st.kept),
+		       nlmsg_hdr(st.kept)->nlmsg_len),
+		"nlmsg_clone() payload differs from original");
+
+	/* growing a message must not touch the receive buffer */
+	fail_if(nla_put_u32(st.kept, 2, 1) != -NLE_NOMEM,
+		"Received message must not have tailroom");
+	fail_if(nlmsg_expand(st.kept, 4096) != 0, "Unable to expand message");
+	fail_if(nla_put_u32(st.kept, 2, 1) != 0,
+		"Unable to add attribute to expanded message");
+
+	nlmsg_free(st.kept);
+	nlmsg_free(st.copy);
+	nl_cb_put(cb);
+	nl_socket_free(sk);
+}
+
+START_TEST(msg_recv_copy)
+{
+	run_recv(0);
+}
+END_TEST
+
+START_TEST(msg_recv_zero_copy)
+{
+	run_recv(1);
+}
+END_TEST
+
+START_TEST(msg_pool)
+{
+	struct nl_msg_pool_stats before, after;
+	struct nlmsghdr *nlh;
+	struct nl_msg *msg;
+
+	nlmsg_set_pool_limit(4);
+
+	msg = nlmsg_alloc_simple(NLMSG_MIN_TYPE, NLM_F_REQUEST);
+	fail_if(!msg, "Unable to allocate message");
+	fail_if(nla_put_u32(msg, 1, 0xffffffff) < 0, "Unable to add attribute");
+	nlh = nlmsg_hdr(msg);
+	nlmsg_free(msg);
+
+	nlmsg_get_pool_stats(&before);
+	fail_if(before.mps_cached < 1, "Freed message was not cached");
+
+	msg = nlmsg_alloc();
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_get_pool_stats(&after);
+
+	fail_if(after.mps_hits != before.mps_hits + 1,
+		"Allocation was not served from the pool");
+	fail_if(nlmsg_hdr(msg) != nlh, "Payload buffer was not reused");
+	fail_if(nlh->nlmsg_len != NLMSG_HDRLEN || nlh->nlmsg_type ||
+		nlh->nlmsg_flags, "Reused message header not reset");
+	fail_if(nlmsg_reserve(msg, 8, NLMSG_ALIGNTO) == NULL ||
+		*(uint32_t *) nlmsg_data(nlh) != 0,
+		"Reserved room not zeroed");
+	nlmsg_free(msg);
+
+	nlmsg_set_pool_limit(0);
+	nlmsg_get_pool_stats(&after);
+	fail_if(after.mps_cached != 0, "Pool not flushed");
+
+	msg = nlmsg_alloc();
+	nlmsg_free(msg);
+	nlmsg_get_pool_stats(&after);
+	fail_if(after.mps_cached != 0, "Message cached with pool disabled");
+
+	nlmsg_set_pool_limit(32);
+}
+END_TEST
+
+static void *pool_thread(void *arg)
+{
+	struct nl_msg_pool_stats *stats = arg;
+	struct nl_msg_pool_stats before;
+	struct nl_msg *msg;
+
+	/* the free lists of the main thread are not shared */
+	nlmsg_get_pool_stats(&before);
+	msg = nlmsg_alloc();
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_get_pool_stats(&stats[0]);
+	fail_if(stats[0].mps_misses != before.mps_misses + 1,
+		"Allocation of new thread served from the pool");
+	nlmsg_free(msg);
+
+	msg = nlmsg_alloc();
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_get_pool_stats(&stats[1]);
+	fail_if(stats[1].mps_hits != stats[0].mps_hits + 1,
+		"Allocation not served from the pool of the thread");
+	nlmsg_free(msg);
+
+	return NULL;
+}
+
+START_TEST(msg_pool_thread)
+{
+	struct nl_msg_pool_stats before, after, stats[2];
+	struct nl_msg *msg;
+	pthread_t thread;
+
+	nlmsg_set_pool_limit(4);
+
+	msg = nlmsg_alloc();
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_free(msg);
+	nlmsg_get_pool_stats(&before);
+	fail_if(before.mps_cached < 1, "Freed message was not cached");
+
+	fail_if(pthread_create(&thread, NULL, pool_thread, stats) != 0,
+		"Unable to create thread");
+	pthread_join(thread, NULL);
+
+	/* the lists of the thread are flushed when it exits */
+	nlmsg_get_pool_stats(&after);
+	fail_if(after.mps_cached != before.mps_cached,
+		"Messages of exited thread still cached");
+
+	msg = nlmsg_alloc();
+	fail_if(!msg, "Unable to allocate message");
+	nlmsg_get_pool_stats(&after);
+	fail_if(after.mps_hits != stats[1].mps_hits + 1,
+		"Allocation not served from the pool of the main thread");
+	nlmsg_free(msg);
+
+	nlmsg_set_pool_limit(32);
+}
+END_TEST
+
+Suite *make_nl_msg_suite(void)
+{
+	Suite *suite = suite_create("Netlink messages");
+
+	TCase *tc_msg = tcase_create("Receive");
+	tcase_add_test(tc_msg, msg_recv_copy);
+	tcase_add_test(tc_msg, msg_recv_zero_copy);
+	suite_add_tcase(suite, tc_msg);
+
+	TCase *tc_pool = tcase_create("Pool");
+	tcase_add_test(tc_pool, msg_pool);
+	tcase_add_test(tc_pool, msg_pool_thread);
+	suite_add_tcase(suite, tc_pool);
+
+	return suite;
+}
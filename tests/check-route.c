@@ -0,0 +1,184 @@
+/*
+ * tests/check-route.c		Route cache unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <netlink-private/netlink.h>
+#include <netlink/cache.h>
+#include <netlink/route/route.h>
+
+#include "util.h"
+
+static struct rtnl_route *add_route(struct nl_cache *cache, const char *dst,
+				    uint32_t table, uint32_t prio)
+{
+	struct rtnl_route *route;
+	struct nl_addr *addr;
+
+	fail_if(nl_addr_parse(dst, AF_UNSPEC, &addr) != 0,
+		"Unable to parse %s", dst);
+
+	route = rtnl_route_alloc();
+	fail_if(!route, "Unable to allocate route");
+	rtnl_route_set_family(route, nl_addr_get_family(addr));
+	rtnl_route_set_dst(route, addr);
+	rtnl_route_set_table(route, table);
+	rtnl_route_set_priority(route, prio);
+	nl_addr_put(addr);
+
+	fail_if(nl_cache_add(cache, OBJ_CAST(route)) != 0,
+		"Unable to add route %s", dst);
+	rtnl_route_put(route);
+
+	return route;
+}
+
+static void check_route_lookup(struct nl_cache *cache, uint32_t table,
+			       const char *str, struct rtnl_route *expect)
+{
+	struct rtnl_route *route;
+	struct nl_addr *addr;
+
+	fail_if(nl_addr_parse(str, AF_UNSPEC, &addr) != 0,
+		"Unable to parse %s", str);
+	route = rtnl_route_lookup(cache, table, addr);
+	nl_addr_put(addr);
+
+	fail_if(route != expect, "Wrong route to %s in table %u", str, table);
+	if (route)
+		rtnl_route_put(route);
+}
+
+#define NROUTES 2000
+
+START_TEST(route_cache_lpm)
+{
+	struct rtnl_route *def, *r8, *r16, *r24, *r24b, *r25, *other, *r6;
+	struct rtnl_route *routes[NROUTES], *route, *best;
+	uint32_t prefix[NROUTES], addr;
+	int len[NROUTES], i, j, best_len;
+	struct nl_cache *cache;
+	struct nl_addr *a;
+	char buf[32];
+
+	fail_if(nl_cache_alloc_name("route/route", &cache) != 0,
+		"Unable to allocate route cache");
+
+	def = add_route(cache, "0.0.0.0/0", 254, 100);
+	r8 = add_route(cache, "10.0.0.0/8", 254, 10);
+	r16 = add_route(cache, "10.1.0.0/16", 254, 0);
+	r24 = add_route(cache, "10.1.2.0/24", 254, 20);
+	r24b = add_route(cache, "10.1.2.0/24", 254, 5);
+	r25 = add_route(cache, "10.1.2.128/25", 254, 0);
+	other = add_route(cache, "192.168.1.0/24", 100, 0);
+	r6 = add_route(cache, "2001:db8::/32", 254, 1024);
+
+	check_route_lookup(cache, 254, "10.1.2.200", r25);
+	check_route_lookup(cache, 254, "10.1.2.1", r24b);
+	check_route_lookup(cache, 254, "10.1.3.1", r16);
+	check_route_lookup(cache, 254, "10.9.9.9", r8);
+	check_route_lookup(cache, 254, "8.8.8.8", def);
+	check_route_lookup(cache, 254, "192.168.1.7", def);
+	check_route_lookup(cache, 100, "192.168.1.7", other);
+	check_route_lookup(cache, 100, "192.168.2.7", NULL);
+	check_route_lookup(cache, 254, "2001:db8::1", r6);
+	check_route_lookup(cache, 254, "2001:db9::1", NULL);
+
+	nl_cache_remove(OBJ_CAST(r24b));
+	check_route_lookup(cache, 254, "10.1.2.1", r24);
+	nl_cache_remove(OBJ_CAST(r24));
+	check_route_lookup(cache, 254, "10.1.2.1", r16);
+	check_route_lookup(cache, 254, "10.1.2.200", r25);
+	nl_cache_remove(OBJ_CAST(r16));
+	check_route_lookup(cache, 254, "10.1.2.1", r8);
+	check_route_lookup(cache, 254, "10.1.2.200", r25);
+	nl_cache_remove(OBJ_CAST(r8));
+	check_route_lookup(cache, 254, "10.1.2.1", def);
+
+	nl_cache_clear(cache);
+
+	/* compare against a linear search */
+	srandom(1);
+	for (i = 0; i < NROUTES; i++) {
+		len[i] = 8 + random() % 24;
+		prefix[i] = (random() & 0x0f0f0000) & ~(0xffffffffU >> len[i]);
+		snprintf(buf, sizeof(buf), "%u.%u.%u.%u/%d", prefix[i] >> 24,
+			 (prefix[i] >> 16) & 0xff, (prefix[i] >> 8) & 0xff,
+			 prefix[i] & 0xff, len[i]);
+		routes[i] = add_route(cache, buf, 254, i);
+	}
+
+	for (j = 0; j < 2; j++) {
+		for (addr = 0; addr < 0x10000000; addr += 0x00010301) {
+			best = NULL;
+			best_len = -1;
+			for (i = 0; i < NROUTES; i++) {
+				if (!routes[i] || len[i] <= best_len ||
+				    (addr & ~(0xffffffffU >> len[i])) != prefix[i])
+					continue;
+				best = routes[i];
+				best_len = len[i];
+			}
+
+			addr = htonl(addr);
+			a = nl_addr_build(AF_INET, &addr, 4);
+			addr = ntohl(addr);
+			route = rtnl_route_lookup(cache, 254, a);
+			nl_addr_put(a);
+
+			fail_if(route != best, "Wrong route to %08x", addr);
+			if (route)
+				rtnl_route_put(route);
+		}
+
+		for (i = j; i < NROUTES; i += 2) {
+			nl_cache_remove(OBJ_CAST(routes[i]));
+			routes[i] = NULL;
+		}
+	}
+
+	fail_if(!nl_cache_is_empty(cache), "Cache not empty");
+	nl_cache_free(cache);
+}
+END_TEST
+
+START_TEST(route_cache_lazy_index)
+{
+	struct rtnl_route *r8, *r16;
+	struct nl_cache *cache;
+
+	fail_if(nl_cache_alloc_name("route/route", &cache) != 0,
+		"Unable to allocate route cache");
+
+	r8 = add_route(cache, "10.0.0.0/8", 254, 0);
+	fail_if(cache->c_index, "Index built before the first lookup");
+
+	check_route_lookup(cache, 254, "10.1.2.3", r8);
+	fail_if(!cache->c_index, "Index not built by lookup");
+
+	/* routes added after the first lookup are indexed */
+	r16 = add_route(cache, "10.1.0.0/16", 254, 0);
+	check_route_lookup(cache, 254, "10.1.2.3", r16);
+	nl_cache_remove(OBJ_CAST(r16));
+	check_route_lookup(cache, 254, "10.1.2.3", r8);
+
+	nl_cache_free(cache);
+}
+END_TEST
+
+Suite *make_nl_route_suite(void)
+{
+	Suite *suite = suite_create("Routes");
+
+	TCase *tc_route = tcase_create("Core");
+	tcase_add_test(tc_route, route_cache_lpm);
+	tcase_add_test(tc_route, route_cache_lazy_index);
+	suite_add_tcase(suite, tc_route);
+
+	return suite;
+}
@@ -0,0 +1,572 @@
+/*
+ * tests/check-socket.c		Netlink socket receive unit tests
+ *
+ *	This library is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU Lesser General Public
+ *	License as published by the Free Software Foundation version 2.1
+ *	of the License.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+#include <netlink/msg.h>
+#include <netlink/batch.h>
+#include <linux/rtnetlink.h>
+
+#include "util.h"
+
+/*
+ * Datagrams are exchanged between two NETLINK_USERSOCK sockets, which
+ * does not require any privileges. Datagrams sent to a group are dropped
+ * once the receive buffer of a member is full. Sending to a group always
+ * fails as the datagram is also sent to port 0, which is unused for this
+ * protocol, but members still receive it.
+ */
+#define USERSOCK_GROUP 1
+
+static struct nl_sock *alloc_usersock(void)
+{
+	struct nl_sock *sk;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_USERSOCK) < 0, "Unable to connect");
+
+	/* datagrams are not responses to requests of the receiver */
+	nl_socket_disable_seq_check(sk);
+
+	return sk;
+}
+
+static int send_dgram(struct nl_sock *tx, size_t len)
+{
+	struct nl_msg *msg;
+	void *data;
+	int err;
+
+	msg = nlmsg_alloc_size(nlmsg_total_size(len));
+	fail_if(!msg || !nlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ,
+				   NLMSG_MIN_TYPE, 0, 0),
+		"Unable to allocate message");
+	data = nlmsg_reserve(msg, len, NLMSG_ALIGNTO);
+	fail_if(!data, "Unable to reserve payload");
+	memset(data, 0xab, len);
+
+	err = nl_send_auto(tx, msg);
+	nlmsg_free(msg);
+
+	return err;
+}
+
+static int send_reply(struct nl_sock *tx, int type, unsigned int seq,
+		      size_t len)
+{
+	struct nl_msg *msg;
+	void *data;
+	int err;
+
+	msg = nlmsg_alloc_size(nlmsg_total_size(len));
+	fail_if(!msg || !nlmsg_put(msg, NL_AUTO_PORT, seq, type, 0,
+				   NLM_F_MULTI),
+		"Unable to allocate message");
+	data = nlmsg_reserve(msg, len, NLMSG_ALIGNTO);
+	fail_if(!data, "Unable to reserve payload");
+	memset(data, 0xab, len);
+
+	/* sent as is, no sequence number is assigned */
+	err = nl_send(tx, msg);
+	nlmsg_free(msg);
+
+	return err;
+}
+
+static struct nl_cb *clone_socket_cb(struct nl_sock *sk)
+{
+	struct nl_cb *orig, *cb;
+
+	orig = nl_socket_get_cb(sk);
+	cb = nl_cb_clone(orig);
+	nl_cb_put(orig);
+	fail_if(!cb, "Unable to clone callbacks");
+
+	return cb;
+}
+
+static int count_cb(struct nl_msg *msg, void *arg)
+{
+	(*(int *) arg)++;
+
+	return NL_OK;
+}
+
+#define NHELD 2
+
+struct held_msgs {
+	int		nheld;
+	struct nl_msg *	msgs[NHELD];
+};
+
+static int hold_cb(struct nl_msg *msg, void *arg)
+{
+	struct held_msgs *held = arg;
+
+	fail_if(held->nheld >= NHELD, "More messages than buffers");
+	nlmsg_get(msg);
+	held->msgs[held->nheld++] = msg;
+
+	return NL_OK;
+}
+
+static void release_held(struct held_msgs *held)
+{
+	while (held->nheld > 0)
+		nlmsg_free(held->msgs[--held->nheld]);
+}
+
+struct recv_hdrs {
+	int			nrecv;
+	struct nlmsghdr *	hdrs[4];
+	int			lens[4];
+};
+
+static int record_cb(struct nl_msg *msg, void *arg)
+{
+	struct recv_hdrs *r = arg;
+
+	fail_if(r->nrecv >= 4, "Too many messages");
+	r->hdrs[r->nrecv] = nlmsg_hdr(msg);
+	r->lens[r->nrecv++] = nlmsg_hdr(msg)->nlmsg_len;
+
+	return NL_OK;
+}
+
+START_TEST(socket_recv_buf_reuse)
+{
+	struct held_msgs held = { 0 };
+	struct recv_hdrs r = { 0 };
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb, *hold;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+	nl_socket_enable_zero_copy(rx);
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, record_cb, &r);
+	hold = clone_socket_cb(rx);
+	nl_cb_set(hold, NL_CB_VALID, NL_CB_CUSTOM, hold_cb, &held);
+
+	/* messages point into the buffer of the socket, which is reused
+	 * once they are gone */
+	fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+	fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	fail_if(r.hdrs[0] != r.hdrs[1], "Receive buffer not reused");
+
+	/* a buffer still referenced by a message is left to it */
+	fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+	fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, hold), 1);
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	fail_if(r.hdrs[2] == nlmsg_hdr(held.msgs[0]),
+		"Buffer of held message overwritten");
+	fail_if(nlmsg_hdr(held.msgs[0])->nlmsg_len != r.lens[2],
+		"Held message modified");
+	release_held(&held);
+
+	nl_cb_put(hold);
+	nl_cb_put(cb);
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+START_TEST(socket_recv_buf_grow)
+{
+	struct recv_hdrs r = { 0 };
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+	nl_socket_set_msg_buf_size(rx, 4096);
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, record_cb, &r);
+
+	/* an oversize message is lost but the buffer grows to fit it */
+	fail_if(send_dgram(tx, 8192) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_MSG_TRUNC);
+	ck_assert_int_eq(r.nrecv, 0);
+
+	fail_if(send_dgram(tx, 8192) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(r.lens[0], NLMSG_HDRLEN + 8192);
+
+	nl_cb_put(cb);
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+START_TEST(socket_recv_oversize)
+{
+	struct nl_recv_batch_stats stats;
+	struct recv_hdrs r = { 0 };
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+	int err;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+	fail_if(nl_socket_set_buffer_size(rx, 1 << 20, 0) < 0 ||
+		nl_socket_set_buffer_size(tx, 0, 1 << 20) < 0,
+		"Unable to set socket buffer sizes");
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, record_cb, &r);
+
+	/* messages exceeding the default buffer are received in one piece */
+	fail_if(send_dgram(tx, 40000) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(r.lens[0], NLMSG_HDRLEN + 40000);
+
+	/* so are the ones of a dump, also when received in a batch */
+	err = nl_socket_set_recv_batch(rx, 4);
+	fail_if(err < 0 && err != -NLE_OPNOTSUPP,
+		"Unable to enable batching: %s", nl_geterror(err));
+	fail_if(send_reply(tx, NLMSG_MIN_TYPE, 0, 50000) < 0, "Unable to send");
+	fail_if(send_reply(tx, NLMSG_MIN_TYPE, 0, 60000) < 0, "Unable to send");
+	fail_if(send_reply(tx, NLMSG_DONE, 0, 4) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 3);
+	ck_assert_int_eq(r.nrecv, 3);
+	ck_assert_int_eq(r.lens[1], NLMSG_HDRLEN + 50000);
+	ck_assert_int_eq(r.lens[2], NLMSG_HDRLEN + 60000);
+	if (!err) {
+		nl_socket_get_recv_batch_stats(rx, &stats);
+		ck_assert_int_eq(stats.rbs_datagrams, 3);
+	}
+
+	/* a message not even fitting into the overflow buffer is lost,
+	 * the buffer grows to fit the next one */
+	nl_socket_set_recv_batch(rx, 0);
+	fail_if(send_dgram(tx, 120000) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_MSG_TRUNC);
+	fail_if(send_dgram(tx, 120000) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(r.lens[3], NLMSG_HDRLEN + 120000);
+
+	nl_cb_put(cb);
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+START_TEST(socket_recv_batch)
+{
+	struct nl_recv_batch_stats stats;
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+	int i, err, nrecv = 0;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+	nl_socket_set_nonblocking(rx);
+
+	err = nl_socket_set_recv_batch(rx, 4);
+	if (err == -NLE_OPNOTSUPP)
+		goto out;
+	fail_if(err < 0, "Unable to enable batching: %s", nl_geterror(err));
+	ck_assert_int_eq(nl_socket_get_recv_batch(rx), 4);
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, count_cb, &nrecv);
+
+	for (i = 0; i < 6; i++)
+		fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+
+	/* a full batch is received at once and handed out one by one */
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	nl_socket_get_recv_batch_stats(rx, &stats);
+	ck_assert_int_eq(stats.rbs_calls, 1);
+	ck_assert_int_eq(stats.rbs_datagrams, 4);
+	ck_assert_int_eq(stats.rbs_full, 1);
+	ck_assert_int_eq(stats.rbs_last, 4);
+	ck_assert_int_eq(nl_socket_get_recv_batch_pending(rx), 3);
+	ck_assert_int_eq(nl_socket_set_recv_batch(rx, 8), -NLE_BUSY);
+
+	for (i = 0; i < 3; i++)
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	nl_socket_get_recv_batch_stats(rx, &stats);
+	ck_assert_int_eq(stats.rbs_calls, 1);
+
+	/* the remaining datagrams are taken without waiting for more */
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	nl_socket_get_recv_batch_stats(rx, &stats);
+	ck_assert_int_eq(stats.rbs_calls, 2);
+	ck_assert_int_eq(stats.rbs_datagrams, 6);
+	ck_assert_int_eq(stats.rbs_full, 1);
+	ck_assert_int_eq(stats.rbs_last, 2);
+
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_AGAIN);
+	ck_assert_int_eq(nrecv, 6);
+	ck_assert_int_eq(nl_socket_get_recv_batch_pending(rx), 0);
+	fail_if(nl_socket_set_recv_batch(rx, 0) < 0, "Unable to disable batching");
+
+	nl_cb_put(cb);
+out:
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+START_TEST(socket_uring_busy)
+{
+	struct held_msgs held = { 0 };
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+	int i, round, err;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+
+	nl_socket_enable_zero_copy(rx);
+	nl_socket_set_nonblocking(rx);
+	err = nl_socket_enable_io_uring(rx, NHELD);
+	if (err == -NLE_OPNOTSUPP)
+		goto out;
+	fail_if(err < 0, "Unable to enable io_uring: %s", nl_geterror(err));
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, hold_cb, &held);
+
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < 2 * NHELD; i++)
+			fail_if(send_dgram(tx, 64) < 0, "Unable to send");
+
+		/* both buffers are held by zero-copy messages */
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_BUSY);
+
+		/* no datagram was lost while waiting for buffers */
+		release_held(&held);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_BUSY);
+
+		release_held(&held);
+		ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_AGAIN);
+	}
+
+	nl_cb_put(cb);
+out:
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+START_TEST(socket_uring_oversize)
+{
+	struct recv_hdrs r = { 0 };
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+	int i, err;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, nl_socket_get_local_port(rx));
+	fail_if(nl_socket_set_buffer_size(rx, 1 << 20, 0) < 0 ||
+		nl_socket_set_buffer_size(tx, 0, 1 << 20) < 0,
+		"Unable to set socket buffer sizes");
+
+	nl_socket_set_nonblocking(rx);
+	err = nl_socket_enable_io_uring(rx, 2);
+	if (err == -NLE_OPNOTSUPP)
+		goto out;
+	fail_if(err < 0, "Unable to enable io_uring: %s", nl_geterror(err));
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, record_cb, &r);
+
+	/* buffers have room for messages exceeding the default size */
+	fail_if(send_dgram(tx, 40000) < 0, "Unable to send");
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(r.lens[0], NLMSG_HDRLEN + 40000);
+
+	/* larger ones are lost until every buffer of the ring was
+	 * enlarged on its way back */
+	for (i = 0; i <= 2; i++) {
+		fail_if(send_dgram(tx, 120000) < 0, "Unable to send");
+		err = nl_recvmsgs_report(rx, cb);
+		if (err != -NLE_MSG_TRUNC)
+			break;
+	}
+	fail_if(i == 0, "Oversize datagram not reported");
+	ck_assert_int_eq(err, 1);
+	ck_assert_int_eq(r.nrecv, 2);
+	ck_assert_int_eq(r.lens[1], NLMSG_HDRLEN + 120000);
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), -NLE_AGAIN);
+
+	nl_cb_put(cb);
+out:
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+#define NOVERRUN 64
+
+START_TEST(socket_uring_overrun)
+{
+	struct nl_sock *rx, *tx;
+	struct nl_cb *cb;
+	int i, err, nrecv = 0, noverrun = 0;
+
+	rx = alloc_usersock();
+	tx = alloc_usersock();
+	nl_socket_set_peer_port(tx, 0);
+	nl_socket_set_peer_groups(tx, 1 << (USERSOCK_GROUP - 1));
+
+	fail_if(nl_socket_add_membership(rx, USERSOCK_GROUP) < 0,
+		"Unable to join group");
+	fail_if(nl_socket_set_buffer_size(rx, 1, 0) < 0,
+		"Unable to shrink receive buffer");
+	nl_socket_set_nonblocking(rx);
+	err = nl_socket_enable_io_uring(rx, 2);
+	if (err == -NLE_OPNOTSUPP)
+		goto out;
+	fail_if(err < 0, "Unable to enable io_uring: %s", nl_geterror(err));
+
+	cb = clone_socket_cb(rx);
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, count_cb, &nrecv);
+
+	/* two datagrams fill the buffer ring, the rest overruns the socket */
+	for (i = 0; i < NOVERRUN; i++)
+		send_dgram(tx, 512);
+
+	while ((err = nl_recvmsgs_report(rx, cb)) != -NLE_AGAIN) {
+		if (err == -NLE_NOMEM)
+			noverrun++;
+		else
+			fail_if(err < 0, "Receive failed: %s", nl_geterror(err));
+	}
+
+	ck_assert_int_eq(noverrun, 1);
+	fail_if(nrecv < 2 || nrecv >= NOVERRUN,
+		"%d datagrams received", nrecv);
+
+	/* receiving resumes after the overrun was reported */
+	nrecv = 0;
+	send_dgram(tx, 512);
+	ck_assert_int_eq(nl_recvmsgs_report(rx, cb), 1);
+	ck_assert_int_eq(nrecv, 1);
+
+	nl_cb_put(cb);
+out:
+	nl_socket_free(rx);
+	nl_socket_free(tx);
+}
+END_TEST
+
+#define NBATCH 10
+#define BATCH_NO_LINK 0x7ffffff0
+
+struct batch_results {
+	int	n;
+	int	err[NBATCH];
+	int	ifindex[NBATCH];
+};
+
+static void batch_result_cb(struct nl_msg *msg, int err, void *arg)
+{
+	struct batch_results *res = arg;
+	struct ifinfomsg *ifi = nlmsg_data(nlmsg_hdr(msg));
+
+	fail_if(res->n >= NBATCH, "More results than requests");
+	res->err[res->n] = err;
+	res->ifindex[res->n++] = ifi->ifi_index;
+}
+
+START_TEST(socket_batch_ack)
+{
+	struct batch_results res = { 0 };
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC };
+	struct nl_batch *batch;
+	struct nl_msg *msg;
+	struct nl_sock *sk;
+	int i;
+
+	sk = nl_socket_alloc();
+	fail_if(!sk, "Unable to allocate socket");
+	fail_if(nl_connect(sk, NETLINK_ROUTE) < 0, "Unable to connect");
+
+	batch = nl_batch_alloc(sk);
+	fail_if(!batch, "Unable to allocate batch");
+	fail_if(nl_batch_set_window(batch, 4) < 0, "Unable to set window");
+	nl_batch_set_result_cb(batch, batch_result_cb, &res);
+
+	/* every other request asks for a link which does not exist */
+	for (i = 0; i < NBATCH; i++) {
+		ifi.ifi_index = i % 2 ? BATCH_NO_LINK : 1;
+		msg = nlmsg_alloc_simple(RTM_GETLINK, 0);
+		fail_if(!msg, "Unable to allocate message");
+		fail_if(nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0,
+			"Unable to build message");
+		fail_if(nl_batch_add(batch, msg) < 0, "Unable to add request");
+		nlmsg_free(msg);
+	}
+	ck_assert_int_eq(nl_batch_get_count(batch), NBATCH);
+
+	ck_assert_int_eq(nl_batch_commit(batch), NBATCH / 2);
+	ck_assert_int_eq(nl_batch_get_count(batch), 0);
+	ck_assert_int_eq(nl_batch_get_pending(batch), 0);
+
+	/* responses are matched to their requests in order */
+	ck_assert_int_eq(res.n, NBATCH);
+	for (i = 0; i < NBATCH; i++) {
+		ck_assert_int_eq(res.ifindex[i], i % 2 ? BATCH_NO_LINK : 1);
+		if (i % 2)
+			fail_if(res.err[i] >= 0, "Error of request %d lost", i);
+		else
+			ck_assert_int_eq(res.err[i], 0);
+	}
+
+	nl_batch_free(batch);
+	nl_socket_free(sk);
+}
+END_TEST
+
+Suite *make_nl_socket_suite(void)
+{
+	Suite *suite = suite_create("Sockets");
+
+	TCase *tc_recv = tcase_create("Receive");
+	tcase_add_test(tc_recv, socket_recv_buf_reuse);
+	tcase_add_test(tc_recv, socket_recv_buf_grow);
+	tcase_add_test(tc_recv, socket_recv_oversize);
+	tcase_add_test(tc_recv, socket_recv_batch);
+	suite_add_tcase(suite, tc_recv);
+
+	TCase *tc_batch = tcase_create("Batch");
+	tcase_add_test(tc_batch, socket_batch_ack);
+	suite_add_tcase(suite, tc_batch);
+
+	TCase *tc_uring = tcase_create("io_uring");
+	tcase_add_test(tc_uring, socket_uring_busy);
+	tcase_add_test(tc_uring, socket_uring_overrun);
+	tcase_add_test(tc_uring, socket_uring_oversize);
+	suite_add_tcase(suite, tc_uring);
+
+	return suite;
+}
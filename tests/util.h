@@ -1,10 +1,33 @@
 #include <check.h>
+#include <netlink/route/link.h>
 
 #define nl_fail_if(condition, error, message) \
 	fail_if((condition), "nlerr=%d (%s): %s", \
 		(error), nl_geterror(error), (message))
 
+/* Number of links used by tests filling caches and hashtables */
+#define NLINKS 5000
+
+static inline struct rtnl_link *alloc_link(int ifindex)
+{
+	struct rtnl_link *link;
+
+	link = rtnl_link_alloc();
+	fail_if(!link, "Unable to allocate link");
+	rtnl_link_set_family(link, AF_UNSPEC);
+	rtnl_link_set_ifindex(link, ifindex);
+
+	return link;
+}
+
 Suite *make_nl_attr_suite(void);
 Suite *make_nl_addr_suite(void);
+Suite *make_nl_cache_suite(void);
+Suite *make_nl_cache_mngr_suite(void);
 Suite *make_nl_ematch_tree_clone_suite(void);
+Suite *make_nl_hashtable_suite(void);
+Suite *make_nl_link_suite(void);
+Suite *make_nl_msg_suite(void);
+Suite *make_nl_route_suite(void);
+Suite *make_nl_socket_suite(void);
 